@@ -0,0 +1,94 @@
+// Limits the runs in flight on a Model, adapting the limit to latency.
+
+#include "concurrency_limiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace tf_cpp {
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+}  // namespace
+
+ConcurrencyLimiter::ConcurrencyLimiter(
+    const ConcurrencyLimiterOptions &options)
+    : options(options) {
+  this->options.min_limit = std::max(options.min_limit, 1.0);
+  counters.limit = std::min(
+      std::max(options.initial_limit, this->options.min_limit),
+      options.max_limit);
+}
+
+void ConcurrencyLimiter::run(const std::function<void()> &fn) {
+  acquire();
+  auto start = std::chrono::steady_clock::now();
+  try {
+    fn();
+  } catch (...) {
+    release(-1);
+    throw;
+  }
+  release(Seconds(start));
+}
+
+void ConcurrencyLimiter::acquire() {
+  std::unique_lock<std::mutex> lock(mutex);
+  auto admit = [this]() {
+    return counters.in_flight < static_cast<std::size_t>(counters.limit);
+  };
+  if (!admit()) {
+    if (counters.queued >= options.max_queue) {
+      ++counters.rejected;
+      auto limit = static_cast<std::size_t>(counters.limit);
+      throw Overloaded("concurrency limit of " + std::to_string(limit) +
+                       " runs reached.");
+    }
+    ++counters.queued;
+    cv.wait(lock, admit);
+    --counters.queued;
+  }
+  ++counters.in_flight;
+  ++counters.admitted;
+}
+
+void ConcurrencyLimiter::release(double latency) {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::size_t in_flight = counters.in_flight--;
+  // failed runs say nothing about the latency.
+  if (latency > 0) {
+    auto &min_latency = counters.min_latency_seconds;
+    if (min_latency == 0 || latency < min_latency) {
+      min_latency = latency;
+    } else {
+      // drift up slowly, so the limiter follows a model that got slower.
+      min_latency *= 1.0001;
+    }
+    double gradient =
+        std::min(std::max(options.tolerance * min_latency / latency, 0.5), 1.0);
+    double limit = counters.limit * gradient + std::sqrt(counters.limit);
+    // a limit that is not used is not raised.
+    if (limit < counters.limit || 2 * in_flight >= counters.limit) {
+      limit = (1 - options.smoothing) * counters.limit +
+              options.smoothing * limit;
+      counters.limit =
+          std::min(std::max(limit, options.min_limit), options.max_limit);
+    }
+  }
+  if (counters.queued > 0) {
+    cv.notify_all();
+  }
+}
+
+ConcurrencyLimiterStats ConcurrencyLimiter::stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return counters;
+}
+}  // namespace tf_cpp
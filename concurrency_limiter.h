@@ -0,0 +1,85 @@
+// Limits the runs in flight on a Model, adapting the limit to latency.
+
+#ifndef TENSORFLOW_C_CONCURRENCY_LIMITER_H
+#define TENSORFLOW_C_CONCURRENCY_LIMITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+// the error of a request rejected because the limit and the queue are full.
+class Overloaded : public std::runtime_error {
+ public:
+  explicit Overloaded(const std::string &what) : std::runtime_error(what) {}
+};
+
+struct ConcurrencyLimiterOptions {
+  double initial_limit = 8;
+  double min_limit = 1;
+  double max_limit = 256;
+  // requests that may wait for a free slot, the next ones are rejected.
+  // 0 rejects every request that finds the limit reached.
+  std::size_t max_queue = 0;
+  // latency up to tolerance times the no load latency counts as no load.
+  double tolerance = 2;
+  // weight of a new sample in the limit.
+  double smoothing = 0.2;
+};
+
+struct ConcurrencyLimiterStats {
+  double limit = 0;
+  std::size_t in_flight = 0;
+  std::size_t queued = 0;
+  std::size_t admitted = 0;
+  std::size_t rejected = 0;
+  // the lowest latency seen lately, taken as the latency without load.
+  double min_latency_seconds = 0;
+};
+
+// admits at most limit runs at a time and rejects the rest right away, so
+// under overload requests fail fast instead of queueing until all of them
+// are slow. the limit follows the gradient of the latency: after each run
+//   limit = limit * min(1, tolerance * min_latency / latency) + sqrt(limit)
+// smoothed, so it grows while runs are as fast as without load and shrinks
+// as soon as they queue inside tensorflow.
+// thread safe.
+class ConcurrencyLimiter {
+ public:
+  explicit ConcurrencyLimiter(const ConcurrencyLimiterOptions &options = {});
+
+  ConcurrencyLimiter(const ConcurrencyLimiter &limiter) = delete;
+  ConcurrencyLimiter &operator=(const ConcurrencyLimiter &limiter) = delete;
+
+  // model.run(inputs, outputs) if admitted.
+  // throws Overloaded if the request is rejected.
+  void run(Model &model, const std::vector<Tensor *> &inputs,
+           const std::vector<Tensor *> &outputs) {
+    run([&]() { model.run(inputs, outputs); });
+  }
+
+  // fn if admitted, its latency adapts the limit unless it throws.
+  // throws Overloaded if the request is rejected.
+  void run(const std::function<void()> &fn);
+
+  ConcurrencyLimiterStats stats() const;
+
+ private:
+  void acquire();
+  void release(double latency);
+
+  ConcurrencyLimiterOptions options;
+  mutable std::mutex mutex;
+  std::condition_variable cv;
+  ConcurrencyLimiterStats counters;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_CONCURRENCY_LIMITER_H
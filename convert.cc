@@ -0,0 +1,242 @@
+// Vectorized element type conversion with normalization for feeding tensors.
+
+#include "convert.h"
+
+#include <cstring>
+#include <type_traits>
+
+#include "simd.h"
+
+#if defined(TF_CPP_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace tf_cpp {
+
+namespace {
+
+template <typename S, typename D>
+void ConvertScalar(const S *src, D *dst, std::size_t n, D scale, D offset) {
+  for (std::size_t i = 0; i != n; ++i) {
+    dst[i] = static_cast<D>(src[i]) * scale + offset;
+  }
+}
+
+#if defined(TF_CPP_X86_SIMD)
+
+// load 8 elements as floats.
+__attribute__((target("avx2,fma"))) inline __m256 Avx2LoadPs(
+    const uint8_t *src) {
+  __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src));
+  return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(b));
+}
+
+__attribute__((target("avx2,fma"))) inline __m256 Avx2LoadPs(
+    const int16_t *src) {
+  __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+  return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(w));
+}
+
+__attribute__((target("avx2,fma"))) inline __m256 Avx2LoadPs(
+    const float *src) {
+  return _mm256_loadu_ps(src);
+}
+
+__attribute__((target("avx2,fma"))) inline __m256 Avx2LoadPs(
+    const double *src) {
+  __m128 lo = _mm256_cvtpd_ps(_mm256_loadu_pd(src));
+  __m128 hi = _mm256_cvtpd_ps(_mm256_loadu_pd(src + 4));
+  return _mm256_set_m128(hi, lo);
+}
+
+// load 4 elements as doubles.
+__attribute__((target("avx2,fma"))) inline __m256d Avx2LoadPd(
+    const uint8_t *src) {
+  int32_t bytes;
+  std::memcpy(&bytes, src, sizeof(bytes));
+  __m128i b = _mm_cvtsi32_si128(bytes);
+  return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(b));
+}
+
+__attribute__((target("avx2,fma"))) inline __m256d Avx2LoadPd(
+    const int16_t *src) {
+  __m128i w = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src));
+  return _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(w));
+}
+
+__attribute__((target("avx2,fma"))) inline __m256d Avx2LoadPd(
+    const float *src) {
+  return _mm256_cvtps_pd(_mm_loadu_ps(src));
+}
+
+__attribute__((target("avx2,fma"))) inline __m256d Avx2LoadPd(
+    const double *src) {
+  return _mm256_loadu_pd(src);
+}
+
+template <typename S>
+__attribute__((target("avx2,fma"))) void ConvertAvx2(const S *src,
+                                                     float *dst,
+                                                     std::size_t n,
+                                                     float scale,
+                                                     float offset) {
+  const __m256 s = _mm256_set1_ps(scale);
+  const __m256 o = _mm256_set1_ps(offset);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(Avx2LoadPs(src + i), s, o));
+  }
+  ConvertScalar(src + i, dst + i, n - i, scale, offset);
+}
+
+template <typename S>
+__attribute__((target("avx2,fma"))) void ConvertAvx2(const S *src,
+                                                     double *dst,
+                                                     std::size_t n,
+                                                     double scale,
+                                                     double offset) {
+  const __m256d s = _mm256_set1_pd(scale);
+  const __m256d o = _mm256_set1_pd(offset);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(dst + i, _mm256_fmadd_pd(Avx2LoadPd(src + i), s, o));
+  }
+  ConvertScalar(src + i, dst + i, n - i, scale, offset);
+}
+
+// load 16 elements as floats.
+__attribute__((target("avx512f,avx2,fma"))) inline __m512 Avx512LoadPs(
+    const uint8_t *src) {
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+  return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(b));
+}
+
+__attribute__((target("avx512f,avx2,fma"))) inline __m512 Avx512LoadPs(
+    const int16_t *src) {
+  __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+  return _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(w));
+}
+
+__attribute__((target("avx512f,avx2,fma"))) inline __m512 Avx512LoadPs(
+    const float *src) {
+  return _mm512_loadu_ps(src);
+}
+
+__attribute__((target("avx512f,avx2,fma"))) inline __m512 Avx512LoadPs(
+    const double *src) {
+  __m256 lo = _mm512_cvtpd_ps(_mm512_loadu_pd(src));
+  __m256 hi = _mm512_cvtpd_ps(_mm512_loadu_pd(src + 8));
+  __m512d v = _mm512_castpd256_pd512(_mm256_castps_pd(lo));
+  return _mm512_castpd_ps(_mm512_insertf64x4(v, _mm256_castps_pd(hi), 1));
+}
+
+// load 8 elements as doubles.
+__attribute__((target("avx512f,avx2,fma"))) inline __m512d Avx512LoadPd(
+    const uint8_t *src) {
+  __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src));
+  return _mm512_cvtepi32_pd(_mm256_cvtepu8_epi32(b));
+}
+
+__attribute__((target("avx512f,avx2,fma"))) inline __m512d Avx512LoadPd(
+    const int16_t *src) {
+  __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+  return _mm512_cvtepi32_pd(_mm256_cvtepi16_epi32(w));
+}
+
+__attribute__((target("avx512f,avx2,fma"))) inline __m512d Avx512LoadPd(
+    const float *src) {
+  return _mm512_cvtps_pd(_mm256_loadu_ps(src));
+}
+
+__attribute__((target("avx512f,avx2,fma"))) inline __m512d Avx512LoadPd(
+    const double *src) {
+  return _mm512_loadu_pd(src);
+}
+
+template <typename S>
+__attribute__((target("avx512f,avx2,fma"))) void ConvertAvx512(
+    const S *src, float *dst, std::size_t n, float scale, float offset) {
+  const __m512 s = _mm512_set1_ps(scale);
+  const __m512 o = _mm512_set1_ps(offset);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm512_storeu_ps(dst + i, _mm512_fmadd_ps(Avx512LoadPs(src + i), s, o));
+  }
+  ConvertScalar(src + i, dst + i, n - i, scale, offset);
+}
+
+template <typename S>
+__attribute__((target("avx512f,avx2,fma"))) void ConvertAvx512(
+    const S *src, double *dst, std::size_t n, double scale, double offset) {
+  const __m512d s = _mm512_set1_pd(scale);
+  const __m512d o = _mm512_set1_pd(offset);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm512_storeu_pd(dst + i, _mm512_fmadd_pd(Avx512LoadPd(src + i), s, o));
+  }
+  ConvertScalar(src + i, dst + i, n - i, scale, offset);
+}
+
+#endif  // TF_CPP_X86_SIMD
+
+template <typename S, typename D>
+void Convert(const S *src, D *dst, std::size_t n, D scale, D offset) {
+  if (std::is_same<S, D>::value && scale == 1 && offset == 0) {
+    std::memcpy(dst, src, n * sizeof(D));
+    return;
+  }
+#if defined(TF_CPP_X86_SIMD)
+  switch (simd_level()) {
+    case SimdLevel::kAvx512:
+      return ConvertAvx512(src, dst, n, scale, offset);
+    case SimdLevel::kAvx2:
+      return ConvertAvx2(src, dst, n, scale, offset);
+    default:
+      break;
+  }
+#endif
+  ConvertScalar(src, dst, n, scale, offset);
+}
+
+}  // namespace
+
+void convert(const uint8_t *src, float *dst, std::size_t n, float scale,
+             float offset) {
+  Convert(src, dst, n, scale, offset);
+}
+
+void convert(const int16_t *src, float *dst, std::size_t n, float scale,
+             float offset) {
+  Convert(src, dst, n, scale, offset);
+}
+
+void convert(const float *src, float *dst, std::size_t n, float scale,
+             float offset) {
+  Convert(src, dst, n, scale, offset);
+}
+
+void convert(const double *src, float *dst, std::size_t n, float scale,
+             float offset) {
+  Convert(src, dst, n, scale, offset);
+}
+
+void convert(const uint8_t *src, double *dst, std::size_t n, double scale,
+             double offset) {
+  Convert(src, dst, n, scale, offset);
+}
+
+void convert(const int16_t *src, double *dst, std::size_t n, double scale,
+             double offset) {
+  Convert(src, dst, n, scale, offset);
+}
+
+void convert(const float *src, double *dst, std::size_t n, double scale,
+             double offset) {
+  Convert(src, dst, n, scale, offset);
+}
+
+void convert(const double *src, double *dst, std::size_t n, double scale,
+             double offset) {
+  Convert(src, dst, n, scale, offset);
+}
+}  // namespace tf_cpp
@@ -0,0 +1,33 @@
+// Vectorized element type conversion with normalization for feeding tensors.
+
+#ifndef TENSORFLOW_C_CONVERT_H
+#define TENSORFLOW_C_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tf_cpp {
+
+// dst[i] = src[i] * scale + offset, for n elements.
+// dispatched to AVX-512, AVX2 or scalar code by simd_level(). the vector
+// paths use fused multiply add, so results can differ from the scalar path
+// in the last bit. float destinations are computed in float.
+void convert(const uint8_t *src, float *dst, std::size_t n, float scale = 1,
+             float offset = 0);
+void convert(const int16_t *src, float *dst, std::size_t n, float scale = 1,
+             float offset = 0);
+void convert(const float *src, float *dst, std::size_t n, float scale = 1,
+             float offset = 0);
+void convert(const double *src, float *dst, std::size_t n, float scale = 1,
+             float offset = 0);
+
+void convert(const uint8_t *src, double *dst, std::size_t n, double scale = 1,
+             double offset = 0);
+void convert(const int16_t *src, double *dst, std::size_t n, double scale = 1,
+             double offset = 0);
+void convert(const float *src, double *dst, std::size_t n, double scale = 1,
+             double offset = 0);
+void convert(const double *src, double *dst, std::size_t n, double scale = 1,
+             double offset = 0);
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_CONVERT_H
@@ -0,0 +1,139 @@
+// Offers more load than one model can serve: many client threads send
+// requests back to back, a rejected client backs off for a moment and tries
+// again. The clients run once straight on Model::run, where every request
+// queues inside tensorflow, and once through a ConcurrencyLimiter, which
+// rejects the requests over its limit right away. The example reports the
+// throughput, the goodput, that is the requests served within the latency
+// objective, the latency of the served requests and the rejections. The
+// model, a chain of Tanh ops, is built with the C API and written to
+// tanh.pb first.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrency_limiter.h"
+#include "model.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 14;
+constexpr int kLayers = 16;
+constexpr int kClients = 64;
+constexpr double kObjectiveSeconds = 0.02;
+constexpr auto kBackoff = std::chrono::milliseconds(1);
+constexpr auto kDuration = std::chrono::seconds(3);
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto layer = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, kWidth});
+  for (int i = 0; i != kLayers; ++i) {
+    auto name =
+        i + 1 == kLayers ? std::string("y") : "tanh_" + std::to_string(i);
+    auto desc = TF_NewOperation(graph, "Tanh", name.c_str());
+    TF_AddInput(desc, {layer, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    layer = TF_FinishOperation(desc, status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+void Serve(Model &model, ConcurrencyLimiter *limiter) {
+  std::atomic<bool> stop(false);
+  std::atomic<int> rejected(0);
+  std::mutex mutex;
+  std::vector<double> latencies;
+  std::vector<std::thread> clients;
+  for (int t = 0; t != kClients; ++t) {
+    clients.emplace_back([&]() {
+      Tensor x(model.get_graph(), "x", {1, kWidth}, TF_FLOAT);
+      Tensor y(model.get_graph(), "y", {1, kWidth}, TF_FLOAT);
+      x.set_zero();
+      std::vector<double> my_latencies;
+      while (!stop) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+          if (limiter != nullptr) {
+            limiter->run(model, {&x}, {&y});
+          } else {
+            model.run({&x}, {&y});
+          }
+          my_latencies.push_back(Seconds(start));
+        } catch (const Overloaded &) {
+          ++rejected;
+          std::this_thread::sleep_for(kBackoff);
+        }
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      latencies.insert(latencies.end(), my_latencies.begin(),
+                       my_latencies.end());
+    });
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(kDuration);
+  stop = true;
+  for (auto &c : clients) {
+    c.join();
+  }
+  double seconds = Seconds(start);
+
+  std::sort(latencies.begin(), latencies.end());
+  auto good = std::upper_bound(latencies.begin(), latencies.end(),
+                               kObjectiveSeconds) -
+              latencies.begin();
+  auto percentile = [&](double p) {
+    return latencies.empty()
+               ? 0
+               : latencies[static_cast<std::size_t>(p * (latencies.size() -
+                                                         1))];
+  };
+  std::cout << (limiter != nullptr ? "limiter:   " : "unlimited: ")
+            << latencies.size() / seconds << " runs/s, " << good / seconds
+            << " good runs/s, p50 " << percentile(0.5) * 1e3 << " ms, p99 "
+            << percentile(0.99) * 1e3 << " ms, " << rejected / seconds
+            << " rejections/s";
+  if (limiter != nullptr) {
+    auto stats = limiter->stats();
+    std::cout << ", limit " << stats.limit << ", no load latency "
+              << stats.min_latency_seconds * 1e3 << " ms";
+  }
+  std::cout << std::endl;
+}
+
+int main() {
+  WriteGraph("tanh.pb");
+  Model model("tanh.pb");
+  std::cout << std::fixed << std::setprecision(1) << kClients
+            << " clients, latency objective " << kObjectiveSeconds * 1e3
+            << " ms" << std::endl;
+  Serve(model, nullptr);
+  ConcurrencyLimiter limiter;
+  Serve(model, &limiter);
+}
@@ -0,0 +1,89 @@
+// Benchmark of tf_cpp::convert, the kernel behind Tensor::fill_from, for
+// every source / destination pair at every simd level the cpu supports,
+// against the vector + at<double>() feeding of the mnist example.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "convert.h"
+#include "simd.h"
+#include "tensor.h"
+
+constexpr std::size_t kSize = 4 << 20;
+constexpr int kIterations = 20;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// ns per element.
+template <typename F>
+double Time(F f) {
+  f();  // warm up, fault in the pages.
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != kIterations; ++i) {
+    f();
+  }
+  return Seconds(start) / kIterations / kSize * 1e9;
+}
+
+template <typename S, typename D>
+void Bench(const std::string &name, const std::vector<S> &src,
+           std::vector<D> &dst) {
+  std::cout << "  " << std::setw(18) << std::left << name << std::right
+            << Time([&] {
+                 tf_cpp::convert(src.data(), dst.data(), kSize, D(1) / 255,
+                                 D(-0.5));
+               })
+            << " ns/element" << std::endl;
+}
+
+int main() {
+  std::vector<uint8_t> u8(kSize);
+  std::vector<int16_t> i16(kSize);
+  std::vector<float> f32(kSize), out_f32(kSize);
+  std::vector<double> f64(kSize), out_f64(kSize);
+  for (std::size_t i = 0; i != kSize; ++i) {
+    u8[i] = static_cast<uint8_t>(i * 7);
+    i16[i] = static_cast<int16_t>(i * 7);
+    f32[i] = static_cast<float>(u8[i]);
+    f64[i] = static_cast<double>(u8[i]);
+  }
+  std::cout << std::fixed << std::setprecision(3);
+
+  // what examples/mnist did: convert into a vector, then at() per element.
+  std::cout << "vector + loop, uint8 -> double: "
+            << Time([&] {
+                 std::vector<double> tmp(u8.size());
+                 for (std::size_t i = 0; i != kSize; ++i) {
+                   tmp[i] = u8[i] * (1.0 / 255) - 0.5;
+                 }
+                 for (std::size_t i = 0; i != kSize; ++i) {
+                   out_f64[i] = tmp[i];
+                 }
+               })
+            << " ns/element" << std::endl;
+
+  const auto best = tf_cpp::simd_level();
+  for (int l = 0; l <= static_cast<int>(best); ++l) {
+    auto level = static_cast<tf_cpp::SimdLevel>(l);
+    tf_cpp::set_simd_level(level);
+    std::cout << tf_cpp::simd_level_name(level) << ":" << std::endl;
+    Bench("uint8 -> float", u8, out_f32);
+    Bench("int16 -> float", i16, out_f32);
+    Bench("float -> float", f32, out_f32);
+    Bench("double -> float", f64, out_f32);
+    Bench("uint8 -> double", u8, out_f64);
+    Bench("int16 -> double", i16, out_f64);
+    Bench("float -> double", f32, out_f64);
+    Bench("double -> double", f64, out_f64);
+  }
+  tf_cpp::set_simd_level(best);
+}
@@ -0,0 +1,69 @@
+// Benchmark of the float <-> half / bfloat16 conversions at every simd level
+// the cpu supports, against the scalar loop.
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "float16.h"
+#include "simd.h"
+
+constexpr std::size_t kSize = 16 << 20;
+constexpr int kIterations = 10;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// GB/s counting the bytes read and written.
+template <typename F>
+double Bandwidth(F convert, std::size_t bytes) {
+  convert();  // warm up, fault in the pages.
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != kIterations; ++i) {
+    convert();
+  }
+  return static_cast<double>(bytes) * kIterations / Seconds(start) / 1e9;
+}
+
+int main() {
+  std::mt19937 rng(0);
+  std::normal_distribution<float> dist(0, 100);
+  std::vector<float> src(kSize), dst(kSize);
+  for (auto &f : src) f = dist(rng);
+  std::vector<tf_cpp::half> h(kSize);
+  std::vector<tf_cpp::bfloat16> b(kSize);
+  const std::size_t bytes = kSize * (sizeof(float) + 2);
+
+  const auto best = tf_cpp::simd_level();
+  std::cout << std::fixed << std::setprecision(2);
+  for (int l = 0; l <= static_cast<int>(best); ++l) {
+    auto level = static_cast<tf_cpp::SimdLevel>(l);
+    tf_cpp::set_simd_level(level);
+    std::cout << tf_cpp::simd_level_name(level) << ":" << std::endl;
+    std::cout << "  float -> half:     "
+              << Bandwidth([&] { tf_cpp::float_to_half(src.data(), h.data(), kSize); },
+                           bytes)
+              << " GB/s" << std::endl;
+    std::cout << "  half -> float:     "
+              << Bandwidth([&] { tf_cpp::half_to_float(h.data(), dst.data(), kSize); },
+                           bytes)
+              << " GB/s" << std::endl;
+    std::cout << "  float -> bfloat16: "
+              << Bandwidth(
+                     [&] { tf_cpp::float_to_bfloat16(src.data(), b.data(), kSize); },
+                     bytes)
+              << " GB/s" << std::endl;
+    std::cout << "  bfloat16 -> float: "
+              << Bandwidth(
+                     [&] { tf_cpp::bfloat16_to_float(b.data(), dst.data(), kSize); },
+                     bytes)
+              << " GB/s" << std::endl;
+  }
+  tf_cpp::set_simd_level(best);
+}
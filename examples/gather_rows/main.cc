@@ -0,0 +1,73 @@
+// Benchmark of tf_cpp::gather_rows, the copy behind Tensor::gather_rows,
+// against one memcpy per row on the calling thread, for small, large and
+// huge rows.
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "row_copy.h"
+#include "thread_pool.h"
+
+constexpr int kIterations = 20;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+template <typename F>
+double Bandwidth(F f, std::size_t bytes) {
+  f();  // warm up, fault in the pages.
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != kIterations; ++i) {
+    f();
+  }
+  return static_cast<double>(bytes) * kIterations / Seconds(start) / 1e9;
+}
+
+void Bench(std::size_t n_rows, std::size_t row_bytes) {
+  // every request owns its payload, as a server would see them.
+  std::vector<std::unique_ptr<char[]>> payloads;
+  std::vector<const void *> rows;
+  std::vector<void *> out_rows;
+  for (std::size_t i = 0; i != n_rows; ++i) {
+    payloads.emplace_back(new char[row_bytes]);
+    std::memset(payloads.back().get(), static_cast<int>(i), row_bytes);
+    rows.push_back(payloads.back().get());
+    out_rows.push_back(payloads.back().get());
+  }
+  std::vector<char> batch(n_rows * row_bytes);
+  const std::size_t bytes = batch.size();
+
+  std::cout << n_rows << " rows x " << row_bytes / 1024 << "KB:" << std::endl;
+  std::cout << "  memcpy loop:  " << Bandwidth([&] {
+              for (std::size_t i = 0; i != n_rows; ++i) {
+                std::memcpy(batch.data() + i * row_bytes, rows[i], row_bytes);
+              }
+            }, bytes)
+            << " GB/s" << std::endl;
+  std::cout << "  gather_rows:  " << Bandwidth([&] {
+              tf_cpp::gather_rows(rows.data(), n_rows, row_bytes,
+                                  batch.data());
+            }, bytes)
+            << " GB/s" << std::endl;
+  std::cout << "  scatter_rows: " << Bandwidth([&] {
+              tf_cpp::scatter_rows(batch.data(), n_rows, row_bytes,
+                                   out_rows.data());
+            }, bytes)
+            << " GB/s" << std::endl;
+}
+
+int main() {
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "pool threads: " << tf_cpp::ThreadPool::default_pool().size()
+            << " + caller" << std::endl;
+  Bench(256, 4 << 10);
+  Bench(64, 256 << 10);
+  Bench(16, 8 << 20);
+}
@@ -0,0 +1,59 @@
+// Trains the linear model of examples/train_linear_model with several
+// threads on one session, and reports steps/s per thread and in total.
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "model.h"
+#include "tensor.h"
+#include "trainer.h"
+
+using namespace tf_cpp;
+
+int main() {
+  const int bs = 3;
+  std::vector<std::size_t> thread_counts = {1, 2, 4,
+                                            std::thread::hardware_concurrency()};
+  std::cout << std::fixed << std::setprecision(1);
+  for (std::size_t loss_every : {1, 100}) {
+    for (auto n_threads : thread_counts) {
+      Model model("graph.pb");
+      model.run_operation(TF_GraphOperationByName(model.get_graph(), "init"));
+
+      HogwildTrainer trainer(model,
+                             {{"input", TF_FLOAT, {bs, 1, 1}},
+                              {"target", TF_FLOAT, {bs, 1, 1}}},
+                             "train");
+      // every worker draws its own mini-batches of y = 0.5 * x - 1.
+      std::vector<std::mt19937> rngs;
+      for (std::size_t w = 0; w != n_threads; ++w) rngs.emplace_back(w);
+      auto feed = [&](std::size_t w, std::size_t,
+                      const std::vector<Tensor *> &inputs) {
+        std::uniform_real_distribution<float> dist(0, 1);
+        for (int i = 0; i != bs; ++i) {
+          float x = dist(rngs[w]);
+          inputs[0]->at<float>(i, 0, 0) = x;
+          inputs[1]->at<float>(i, 0, 0) = 0.5f * x - 1;
+        }
+        return true;
+      };
+
+      HogwildOptions options;
+      options.num_threads = n_threads;
+      options.steps_per_thread = 2000;
+      options.loss_every = loss_every;
+      auto stats = trainer.train(feed, options);
+
+      std::cout << "threads " << n_threads << ", loss every " << loss_every
+                << ": " << stats.steps_per_second() << " steps/s, loss "
+                << std::setprecision(4) << stats.last_loss[0]
+                << std::setprecision(1) << std::endl;
+      for (std::size_t w = 0; w != n_threads; ++w) {
+        std::cout << "  thread " << w << ": " << stats.steps_per_second(w)
+                  << " steps/s" << std::endl;
+      }
+    }
+  }
+}
@@ -0,0 +1,152 @@
+// Client threads send requests to a VersionedModel without pause while the
+// main thread deploys new versions of the model, each loaded and warmed up
+// in the background. The example reports the requests every version served,
+// the failed requests, and the request latency while a swap is in progress
+// next to the latency in between. The versions, chains of Tanh ops of
+// growing depth, are built with the C API and written to version_<i>.pb
+// first.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include "versioned_model.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 14;
+constexpr int kThreads = 4;
+constexpr int kVersions = 5;
+constexpr int kWarmUpRuns = 3;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// y = tanh(... tanh(x)), layers deep.
+void WriteGraph(const std::string &filename, int layers) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto layer = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, kWidth});
+  for (int i = 0; i != layers; ++i) {
+    auto name =
+        i + 1 == layers ? std::string("y") : "tanh_" + std::to_string(i);
+    auto desc = TF_NewOperation(graph, "Tanh", name.c_str());
+    TF_AddInput(desc, {layer, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    layer = TF_FinishOperation(desc, status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+void Request(Model &model) {
+  Tensor x(model.get_graph(), "x", {1, kWidth}, TF_FLOAT);
+  Tensor y(model.get_graph(), "y", {1, kWidth}, TF_FLOAT);
+  x.set_zero();
+  model.run({&x}, {&y});
+}
+
+double Percentile(std::vector<double> v, double p) {
+  if (v.empty()) {
+    return 0;
+  }
+  std::sort(v.begin(), v.end());
+  return v[static_cast<std::size_t>(p * (v.size() - 1))];
+}
+
+int main() {
+  for (int i = 1; i <= kVersions; ++i) {
+    WriteGraph("version_" + std::to_string(i) + ".pb", 4 * i);
+  }
+  VersionedModel model("version_1.pb", {}, [](Model &m) {
+    for (int i = 0; i != kWarmUpRuns; ++i) {
+      Request(m);
+    }
+  });
+
+  std::atomic<bool> swapping(false), stop(false);
+  std::atomic<int> failed(0);
+  std::mutex mutex;
+  std::map<std::uint64_t, int> served;
+  std::vector<double> steady, during_swap;
+  std::vector<std::thread> clients;
+  for (int t = 0; t != kThreads; ++t) {
+    clients.emplace_back([&]() {
+      std::map<std::uint64_t, int> my_served;
+      std::vector<double> my_steady, my_during_swap;
+      while (!stop) {
+        bool in_swap = swapping;
+        auto start = std::chrono::steady_clock::now();
+        try {
+          auto lease = model.acquire();
+          Request(*lease);
+          ++my_served[lease.version()];
+        } catch (const std::exception &) {
+          ++failed;
+        }
+        (in_swap ? my_during_swap : my_steady).push_back(Seconds(start));
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto &s : my_served) {
+        served[s.first] += s.second;
+      }
+      steady.insert(steady.end(), my_steady.begin(), my_steady.end());
+      during_swap.insert(during_swap.end(), my_during_swap.begin(),
+                         my_during_swap.end());
+    });
+  }
+
+  double swap_seconds = 0;
+  for (int i = 2; i <= kVersions; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    swapping = true;
+    auto start = std::chrono::steady_clock::now();
+    model.swap("version_" + std::to_string(i) + ".pb").get();
+    swap_seconds += Seconds(start);
+    swapping = false;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  stop = true;
+  for (auto &c : clients) {
+    c.join();
+  }
+
+  std::cout << std::fixed << std::setprecision(1) << kThreads
+            << " client threads, " << kVersions - 1 << " swaps of "
+            << swap_seconds / (kVersions - 1) * 1e3 << " ms" << std::endl;
+  for (auto &s : served) {
+    std::cout << "version " << s.first << ": " << s.second << " requests"
+              << std::endl;
+  }
+  std::cout << "failed requests: " << failed << std::endl;
+  std::cout << "latency between swaps: p50 " << Percentile(steady, 0.5) * 1e6
+            << " us, p99 " << Percentile(steady, 0.99) * 1e6 << " us"
+            << std::endl;
+  std::cout << "latency during swaps:  p50 "
+            << Percentile(during_swap, 0.5) * 1e6 << " us, p99 "
+            << Percentile(during_swap, 0.99) * 1e6 << " us" << std::endl;
+}
@@ -0,0 +1,95 @@
+// A load generator for the inference_server example: every thread opens its
+// own connection and sends requests back to back, then the example reports
+// the throughput and the request latency. Run it as
+//   inference_client [socket [connections [seconds [rows]]]]
+// the requests feed rows x 16384 floats, the input of the default model of
+// inference_server.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "inference_server.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 14;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main(int argc, char **argv) {
+  std::string socket_path =
+      argc > 1 ? argv[1] : std::string("/tmp/tf_cpp_inference.sock");
+  int connections = argc > 2 ? std::atoi(argv[2]) : 4;
+  double duration = argc > 3 ? std::atof(argv[3]) : 5;
+  int64_t rows = argc > 4 ? std::atoll(argv[4]) : 1;
+
+  WireTensor input;
+  input.dtype = TF_FLOAT;
+  input.shape = {rows, kWidth};
+  input.data.resize(rows * kWidth * sizeof(float));
+
+  std::atomic<bool> stop(false);
+  std::atomic<int> failed(0);
+  std::mutex mutex;
+  std::vector<double> latencies;
+  std::vector<std::thread> threads;
+  for (int t = 0; t != connections; ++t) {
+    threads.emplace_back([&]() {
+      InferenceClient client(socket_path);
+      std::vector<double> my_latencies;
+      while (!stop) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+          client.run({input});
+          my_latencies.push_back(Seconds(start));
+        } catch (const std::exception &e) {
+          if (++failed == 1) {
+            std::cerr << e.what() << std::endl;
+          }
+          break;
+        }
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      latencies.insert(latencies.end(), my_latencies.begin(),
+                       my_latencies.end());
+    });
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::duration<double>(duration));
+  stop = true;
+  for (auto &t : threads) {
+    t.join();
+  }
+  double seconds = Seconds(start);
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies.empty()
+               ? 0
+               : latencies[static_cast<std::size_t>(p * (latencies.size() -
+                                                         1))];
+  };
+  // every request sends the input and receives an output of the same size.
+  double mb = 2.0 * latencies.size() * input.data.size() / (1 << 20);
+  std::cout << std::fixed << std::setprecision(1) << connections
+            << " connections, " << rows << " x " << kWidth << " floats"
+            << std::endl;
+  std::cout << latencies.size() / seconds << " requests/s, " << mb / seconds
+            << " MB/s, p50 " << percentile(0.5) * 1e6 << " us, p99 "
+            << percentile(0.99) * 1e6 << " us, max "
+            << percentile(1) * 1e6 << " us, " << failed
+            << " failed connections" << std::endl;
+}
@@ -0,0 +1,85 @@
+// An inference daemon: serves one model to the processes of the host over a
+// Unix domain socket until SIGINT or SIGTERM. Run it as
+//   inference_server [model.pb socket input output [workers]]
+// without arguments it serves a chain of Tanh ops on 1 x 16384 floats,
+// built with the C API and written to tanh.pb, with input x and output y on
+// /tmp/tf_cpp_inference.sock, the defaults of the inference_client load
+// generator.
+
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "inference_server.h"
+#include "model.h"
+#include "scope_guard.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 14;
+constexpr int kLayers = 16;
+
+InferenceServer *server = nullptr;
+
+void Stop(int) { server->stop(); }
+
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto layer = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {-1, kWidth});
+  for (int i = 0; i != kLayers; ++i) {
+    auto name =
+        i + 1 == kLayers ? std::string("y") : "tanh_" + std::to_string(i);
+    auto desc = TF_NewOperation(graph, "Tanh", name.c_str());
+    TF_AddInput(desc, {layer, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    layer = TF_FinishOperation(desc, status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+int main(int argc, char **argv) {
+  std::string filename = "tanh.pb";
+  InferenceServerOptions options;
+  options.socket_path = "/tmp/tf_cpp_inference.sock";
+  options.inputs = {"x"};
+  options.outputs = {"y"};
+  if (argc >= 5) {
+    filename = argv[1];
+    options.socket_path = argv[2];
+    options.inputs = {argv[3]};
+    options.outputs = {argv[4]};
+    if (argc >= 6) {
+      options.workers = std::strtoul(argv[5], nullptr, 10);
+    }
+  } else {
+    WriteGraph(filename);
+  }
+
+  Model model(filename);
+  InferenceServer daemon(model, options);
+  server = &daemon;
+  std::signal(SIGINT, Stop);
+  std::signal(SIGTERM, Stop);
+  std::cout << "serving " << filename << " on " << options.socket_path
+            << " with " << options.workers << " workers" << std::endl;
+  daemon.serve();
+
+  auto stats = daemon.stats();
+  std::cout << stats.connections << " connections, " << stats.requests
+            << " requests, " << stats.errors << " failed runs, "
+            << stats.protocol_errors << " malformed requests" << std::endl;
+}
@@ -48,23 +48,14 @@ int main() {
       0.9133330f,  0.7188759f,  -0.0398740f, 0.1181437f,  -0.6838635f,
   };
 
-  std::vector<float> input_vals_batch;
-  input_vals_batch.reserve(input_vals_1.size() + input_vals_2.size());
-  input_vals_batch.insert(input_vals_batch.end(), input_vals_1.begin(),
-                          input_vals_1.end());
-  input_vals_batch.insert(input_vals_batch.end(), input_vals_2.begin(),
-                          input_vals_2.end());
-  memcpy((&input.at<float>(0)), input_vals_1.data(),
-         sizeof(float) * input_vals_1.size());
-  memcpy((&input.at<float>(1)), input_vals_2.data(),
-         sizeof(float) * input_vals_2.size());
-  // memcpy((&input.at<float>({0})), input_vals_batch.data(),
-  //        sizeof(float) * input_vals_batch.size());
+  // one row of the batch per request.
+  input.gather_rows({input_vals_1.data(), input_vals_2.data()});
   model.run({&input}, {&out});
 
-  std::vector<float> result(&out.at<float>(0), &out.at<float>(0) + 8);
-  std::cout << "Output vals_1: " << result[0] << ", " << result[1] << ", "
-            << result[2] << ", " << result[3] << std::endl;
-  std::cout << "Output vals_2: " << result[4] << ", " << result[5] << ", "
-            << result[6] << ", " << result[7] << std::endl;
+  std::vector<float> result_1(4), result_2(4);
+  out.scatter_rows({result_1.data(), result_2.data()});
+  std::cout << "Output vals_1: " << result_1[0] << ", " << result_1[1] << ", "
+            << result_1[2] << ", " << result_1[3] << std::endl;
+  std::cout << "Output vals_2: " << result_2[0] << ", " << result_2[1] << ", "
+            << result_2[2] << ", " << result_2[3] << std::endl;
 }
@@ -29,22 +29,12 @@ int main() {
 
   // Read image
   for (int i = 0; i < 10; i++) {
-    cv::Mat img, scaled;
-
     // Read image
-    img = cv::imread("images/" + std::to_string(i) + ".png");
-
-    // Scale image to range 0-1
-    img.convertTo(scaled, CV_64F, 1.f / 255);
+    cv::Mat img = cv::imread("images/" + std::to_string(i) + ".png",
+                             cv::IMREAD_GRAYSCALE);
 
-    // Put image in vector
-    std::vector<double> img_data;
-    img_data.assign(scaled.begin<double>(), scaled.end<double>());
-
-    // Feed data to input tensor
-    for (std::size_t i = 0; i != img_data.size(); ++i) {
-      input.at<double>(0, i) = img_data[i];
-    }
+    // Scale image to range 0-1 and feed it to the input tensor in one pass
+    input.fill_from(img.ptr<uint8_t>(), img.total(), 1.0 / 255);
 
     // Run and show predictions
     m.run({&input}, {&prediction});
@@ -0,0 +1,154 @@
+// Serves many tenant models from a ModelRegistry whose memory budget holds
+// only a few of them. Tenants are requested with a skewed popularity, and
+// a tenant's request is mostly followed by a request of its partner tenant,
+// which the registry learns and prefetches. The example runs the stream
+// with and without prediction and reports the cold loads a request waited
+// for, the load latency and the evictions. The tenant models, a constant
+// weight vector followed by Tanh ops, are built with the C API and written
+// to tenant_<i>.pb first.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "model_registry.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 16;
+constexpr int kLayers = 8;
+constexpr int kTenants = 32;
+constexpr int kResident = 6;
+constexpr int kRequests = 2000;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// y = tanh(... tanh(x * w)), w a constant of kWidth floats.
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto x = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, kWidth});
+  auto w_value = tf_utils::CreateTensor(TF_FLOAT, {1, kWidth},
+                                        std::vector<float>(kWidth, 0.5f));
+  SCOPE_EXIT { tf_utils::DeleteTensor(w_value); };
+  auto desc = TF_NewOperation(graph, "Const", "w");
+  TF_SetAttrTensor(desc, "value", w_value, status);
+  TF_SetAttrType(desc, "dtype", TF_FLOAT);
+  auto w = TF_FinishOperation(desc, status);
+  desc = TF_NewOperation(graph, "Mul", "scale");
+  TF_AddInput(desc, {x, 0});
+  TF_AddInput(desc, {w, 0});
+  TF_SetAttrType(desc, "T", TF_FLOAT);
+  auto layer = TF_FinishOperation(desc, status);
+  for (int i = 0; i != kLayers; ++i) {
+    auto name =
+        i + 1 == kLayers ? std::string("y") : "tanh_" + std::to_string(i);
+    desc = TF_NewOperation(graph, "Tanh", name.c_str());
+    TF_AddInput(desc, {layer, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    layer = TF_FinishOperation(desc, status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+// tenants of zipf popularity, each followed by its partner 80% of the time.
+std::vector<int> Stream() {
+  std::vector<double> weights;
+  for (int i = 0; i != kTenants / 2; ++i) {
+    weights.push_back(1.0 / std::pow(i + 1, 1.1));
+  }
+  std::mt19937 rng(7);
+  std::discrete_distribution<int> tenant(weights.begin(), weights.end());
+  std::bernoulli_distribution partner(0.8);
+  std::vector<int> stream;
+  while (stream.size() < kRequests) {
+    int t = 2 * tenant(rng);
+    stream.push_back(t);
+    if (partner(rng)) {
+      stream.push_back(t + 1);
+    }
+  }
+  return stream;
+}
+
+void Serve(const std::vector<int> &stream, bool predict) {
+  ModelRegistryOptions options;
+  options.predict = predict;
+  std::size_t footprint;
+  {
+    // the footprint of one tenant, all tenants are the same size.
+    ModelRegistry probe;
+    probe.add("tenant", "tenant_0.pb");
+    probe.get("tenant");
+    footprint = probe.footprint("tenant");
+  }
+  options.memory_budget = kResident * footprint;
+  ModelRegistry registry(options);
+  for (int i = 0; i != kTenants; ++i) {
+    registry.add("tenant_" + std::to_string(i),
+                 "tenant_" + std::to_string(i) + ".pb");
+  }
+
+  int cold = 0;
+  double wait = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int t : stream) {
+    auto name = "tenant_" + std::to_string(t);
+    bool resident = registry.resident(name);
+    auto request = std::chrono::steady_clock::now();
+    auto model = registry.get(name);
+    Tensor x(model->get_graph(), "x", {1, kWidth}, TF_FLOAT);
+    Tensor y(model->get_graph(), "y", {1, kWidth}, TF_FLOAT);
+    x.set_zero();
+    model->run({&x}, {&y});
+    if (!resident) {
+      ++cold;
+      wait += Seconds(request);
+    }
+  }
+  double seconds = Seconds(start);
+
+  auto stats = registry.stats();
+  std::cout << (predict ? "with prediction:    " : "without prediction: ")
+            << seconds << " s, " << cold << " cold requests waiting "
+            << (cold == 0 ? 0 : wait / cold) * 1e3 << " ms each, "
+            << stats.loads << " loads (" << stats.prefetches
+            << " prefetched) of " << stats.mean_load_seconds() * 1e3
+            << " ms, max " << stats.max_load_seconds * 1e3 << " ms, "
+            << stats.evictions << " evictions" << std::endl;
+}
+
+int main() {
+  for (int i = 0; i != kTenants; ++i) {
+    WriteGraph("tenant_" + std::to_string(i) + ".pb");
+  }
+  auto stream = Stream();
+  std::cout << std::fixed << std::setprecision(2) << kTenants
+            << " tenants, room for " << kResident << ", " << stream.size()
+            << " requests" << std::endl;
+  Serve(stream, false);
+  Serve(stream, true);
+}
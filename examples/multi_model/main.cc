@@ -0,0 +1,116 @@
+// Evaluates four small ranking models on the same request, once with four
+// Models and four runs and once with one MultiModel, which fetches the four
+// outputs in a single session run. Every model has an input x and an
+// output y, the MultiModel tells them apart by model name. The models,
+// chains of Tanh ops of different depth, are built with the C API and
+// written to model_<i>.pb first.
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "multi_model.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 14;
+constexpr int kModels = 4;
+constexpr int kRuns = 200;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// y = tanh(... tanh(x)), layers deep.
+void WriteGraph(const std::string &filename, int layers) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto layer = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, kWidth});
+  for (int i = 0; i != layers; ++i) {
+    auto name =
+        i + 1 == layers ? std::string("y") : "tanh_" + std::to_string(i);
+    auto desc = TF_NewOperation(graph, "Tanh", name.c_str());
+    TF_AddInput(desc, {layer, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    layer = TF_FinishOperation(desc, status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+int main() {
+  std::vector<ModelFile> files;
+  for (int i = 0; i != kModels; ++i) {
+    auto filename = "model_" + std::to_string(i) + ".pb";
+    WriteGraph(filename, 4 * (i + 1));
+    files.emplace_back("model_" + std::to_string(i), filename);
+  }
+  std::cout << std::fixed << std::setprecision(1) << kModels
+            << " models on " << kWidth << " floats, " << kRuns << " requests"
+            << std::endl;
+
+  // one session per model.
+  double separate;
+  {
+    std::vector<std::unique_ptr<Model>> models;
+    std::vector<std::unique_ptr<Tensor>> xs, ys;
+    for (auto &f : files) {
+      models.emplace_back(new Model(f.second));
+      xs.emplace_back(new Tensor(models.back()->get_graph(), "x", {1, kWidth},
+                                 TF_FLOAT));
+      ys.emplace_back(new Tensor(models.back()->get_graph(), "y", {1, kWidth},
+                                 TF_FLOAT));
+      xs.back()->set_zero();
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r != kRuns; ++r) {
+      for (int i = 0; i != kModels; ++i) {
+        models[i]->run({xs[i].get()}, {ys[i].get()});
+      }
+    }
+    separate = Seconds(start) / kRuns;
+  }
+  std::cout << "four Models:  " << separate * 1e6 << " us/request"
+            << std::endl;
+
+  // one session, the models are addressed by name.
+  MultiModel multi(files);
+  std::vector<Tensor> xs, ys;
+  std::vector<Tensor *> inputs, outputs;
+  for (auto &name : multi.models()) {
+    xs.push_back(multi.tensor(name, "x", {1, kWidth}, TF_FLOAT));
+    ys.push_back(multi.tensor(name, "y", {1, kWidth}, TF_FLOAT));
+    xs.back().set_zero();
+  }
+  for (int i = 0; i != kModels; ++i) {
+    inputs.push_back(&xs[i]);
+    outputs.push_back(&ys[i]);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r != kRuns; ++r) {
+    multi.run(inputs, outputs);
+  }
+  double fused = Seconds(start) / kRuns;
+  std::cout << "MultiModel:   " << fused * 1e6 << " us/request, "
+            << std::setprecision(2) << separate / fused << "x faster"
+            << std::endl;
+}
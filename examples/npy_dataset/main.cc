@@ -0,0 +1,103 @@
+// Benchmark of NpyDataset slices against reading the .npy file into a
+// std::vector and copying every batch with tf_utils::CreateTensor.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "npy_dataset.h"
+#include "scope_guard.h"
+#include "tensor.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kRows = 65536;
+constexpr int64_t kCols = 1024;
+constexpr int64_t kBatchSize = 256;
+
+void WriteNpy(const std::string &filename) {
+  std::string header =
+      "{'descr': '<f4', 'fortran_order': False, 'shape': (" +
+      std::to_string(kRows) + ", " + std::to_string(kCols) + "), }";
+  // pad like np.save, so the data starts at a multiple of 64.
+  while ((10 + header.size() + 1) % 64 != 0) header += ' ';
+  header += '\n';
+  std::ofstream f(filename, std::ios::binary);
+  uint16_t header_len = header.size();
+  f.write("\x93NUMPY\x01\x00", 8);
+  f.write(reinterpret_cast<const char *>(&header_len), 2);
+  f.write(header.data(), header.size());
+  std::vector<float> row(kCols);
+  for (int64_t i = 0; i != kRows; ++i) {
+    std::iota(row.begin(), row.end(), static_cast<float>(i));
+    f.write(reinterpret_cast<const char *>(row.data()),
+            row.size() * sizeof(float));
+  }
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// stands in for the model reading the batch.
+double Consume(const float *data, std::size_t n) {
+  return std::accumulate(data, data + n, 0.0);
+}
+
+int main() {
+  const std::string filename = "bench.npy";
+  WriteNpy(filename);
+  const double gb = kRows * kCols * sizeof(float) / 1e9;
+
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  tf_utils::AddPlaceholder(graph, "input", TF_FLOAT, {-1, kCols});
+  std::cout << std::fixed << std::setprecision(2);
+
+  // baseline: read into a vector, copy each batch into a new tensor.
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream f(filename, std::ios::binary);
+    f.seekg(128);
+    std::vector<float> data(kRows * kCols);
+    f.read(reinterpret_cast<char *>(data.data()), data.size() * sizeof(float));
+    for (int64_t b = 0; b < kRows; b += kBatchSize) {
+      std::vector<float> batch(data.begin() + b * kCols,
+                               data.begin() + (b + kBatchSize) * kCols);
+      auto t = tf_utils::CreateTensor(TF_FLOAT, {kBatchSize, kCols}, batch);
+      sum += Consume(static_cast<float *>(TF_TensorData(t)),
+                     kBatchSize * kCols);
+      tf_utils::DeleteTensor(t);
+    }
+    double t = Seconds(start);
+    std::cout << "vector + CreateTensor: " << gb / t << " GB/s (" << sum
+              << ")" << std::endl;
+  }
+
+  // mapped: every batch points into the page cache.
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    NpyDataset dataset(filename);
+    Tensor input(graph, "input", {kBatchSize, kCols}, TF_FLOAT);
+    for (int64_t b = 0; b < dataset.num_rows(); b += kBatchSize) {
+      dataset.prefetch(b + kBatchSize, kBatchSize);
+      dataset.slice(b, kBatchSize, &input);
+      sum += Consume(input.data<float>(), kBatchSize * kCols);
+    }
+    double t = Seconds(start);
+    std::cout << "NpyDataset slices: " << gb / t << " GB/s (" << sum << ", "
+              << (dataset.zero_copy(0) ? "zero-copy" : "copied") << ")"
+              << std::endl;
+  }
+
+  std::remove(filename.c_str());
+}
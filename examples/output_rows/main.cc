@@ -0,0 +1,88 @@
+// Benchmark of handing the rows of a batched output to their requests:
+// tf_utils::GetTensorData per request, a copy of the row per request, and
+// Tensor::take_rows views that share the buffer.
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kBatchSize = 64;
+constexpr int64_t kCols = 4096;
+constexpr int kIterations = 200;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// what every request does with its result.
+double Consume(const float *data, std::size_t n) {
+  return std::accumulate(data, data + n, 0.0);
+}
+
+int main() {
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  tf_utils::AddPlaceholder(graph, "output", TF_FLOAT, {-1, kCols});
+  Tensor output(graph, "output", {kBatchSize, kCols}, TF_FLOAT);
+  std::cout << std::fixed << std::setprecision(2);
+
+  // baseline: every request copies the whole output, then uses its row.
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != kIterations; ++i) {
+      auto t = tf_utils::CreateEmptyTensor(TF_FLOAT, {kBatchSize, kCols},
+                                           kBatchSize * kCols * sizeof(float));
+      for (int64_t r = 0; r != kBatchSize; ++r) {
+        auto all = tf_utils::GetTensorData<float>(t);
+        sum += Consume(all.data() + r * kCols, kCols);
+      }
+      tf_utils::DeleteTensor(t);
+    }
+    std::cout << "GetTensorData per request: "
+              << Seconds(start) / kIterations * 1e6 << " us/batch (" << sum
+              << ")" << std::endl;
+  }
+
+  // every request copies its own row.
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != kIterations; ++i) {
+      float *base = output.data<float>();
+      for (int64_t r = 0; r != kBatchSize; ++r) {
+        std::vector<float> row(base + r * kCols, base + (r + 1) * kCols);
+        sum += Consume(row.data(), row.size());
+      }
+    }
+    std::cout << "row copy per request:      "
+              << Seconds(start) / kIterations * 1e6 << " us/batch (" << sum
+              << ")" << std::endl;
+  }
+
+  // zero copy: the views keep the output alive, the Tensor is refilled.
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != kIterations; ++i) {
+      output.data<float>();  // stands in for the next Model::run.
+      for (auto &row : output.take_rows<float>()) {
+        sum += Consume(row.data(), row.size());
+      }
+    }
+    std::cout << "take_rows:                 "
+              << Seconds(start) / kIterations * 1e6 << " us/batch (" << sum
+              << ")" << std::endl;
+  }
+}
@@ -0,0 +1,117 @@
+// Scores items for a few users. The user features go through an expensive
+// tower, a chain of Tanh ops, and only the head, Mul(tower, item), depends
+// on the item. A PrefixCache keeps the tower output per user and feeds it
+// on a hit, so the tower is not computed again. The graph is built with the
+// C API and written to tower.pb first.
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "prefix_cache.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 16;
+constexpr int kTowerLayers = 16;
+constexpr int kUsers = 8;
+constexpr int kRequests = 200;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+TF_Operation *AddOp(TF_Graph *graph, const char *type, const std::string &name,
+                    const std::vector<TF_Operation *> &inputs,
+                    TF_Status *status) {
+  auto desc = TF_NewOperation(graph, type, name.c_str());
+  for (auto input : inputs) {
+    TF_AddInput(desc, {input, 0});
+  }
+  TF_SetAttrType(desc, "T", TF_FLOAT);
+  return TF_FinishOperation(desc, status);
+}
+
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto user = tf_utils::AddPlaceholder(graph, "user", TF_FLOAT, {1, kWidth});
+  auto item = tf_utils::AddPlaceholder(graph, "item", TF_FLOAT, {1, kWidth});
+  auto tower = user;
+  for (int i = 0; i != kTowerLayers; ++i) {
+    tower =
+        AddOp(graph, "Tanh", "tower_" + std::to_string(i), {tower}, status);
+  }
+  AddOp(graph, "Mul", "score", {tower, item}, status);
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+int main() {
+  WriteGraph("tower.pb");
+  Model model("tower.pb");
+  auto graph = model.get_graph();
+
+  std::vector<Tensor> users;
+  for (int u = 0; u != kUsers; ++u) {
+    users.emplace_back(graph, "user", std::vector<int64_t>{1, kWidth},
+                       TF_FLOAT);
+    std::fill_n(users.back().data<float>(), kWidth, 0.1f * u);
+  }
+  Tensor item(graph, "item", {1, kWidth}, TF_FLOAT);
+  Tensor score(graph, "score", {1, kWidth}, TF_FLOAT);
+  item.set_zero();
+
+  std::mt19937 rng(1);
+  std::vector<int> requests(kRequests);
+  for (auto &r : requests) {
+    r = rng() % kUsers;
+  }
+  std::cout << std::fixed << std::setprecision(1) << kTowerLayers
+            << " tower layers of " << kWidth << " floats, " << kUsers
+            << " users, " << kRequests << " requests" << std::endl;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int r : requests) {
+    model.run({&users[r], &item}, {&score});
+  }
+  double run_seconds = Seconds(start);
+  std::cout << "Model::run:   " << run_seconds / kRequests * 1e3
+            << " ms/request" << std::endl;
+
+  // the last tower layer, named with its output index.
+  std::string last = "tower_" + std::to_string(kTowerLayers - 1) + ":0";
+  PrefixCache cache(model, {{last, TF_FLOAT, {1, kWidth}}}, kUsers);
+  start = std::chrono::steady_clock::now();
+  for (int r : requests) {
+    cache.run({&users[r]}, {&item}, {&score});
+  }
+  double cache_seconds = Seconds(start);
+  auto stats = cache.stats();
+  std::cout << "PrefixCache:  " << cache_seconds / kRequests * 1e3
+            << " ms/request, " << std::setprecision(2)
+            << run_seconds / cache_seconds << "x faster" << std::endl;
+  std::cout << std::setprecision(1) << "hit rate " << stats.hit_rate() * 100
+            << "%, " << stats.hits << " hits, " << stats.misses
+            << " misses, about " << stats.saved_seconds() * 1e3
+            << " ms of compute saved" << std::endl;
+}
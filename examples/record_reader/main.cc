@@ -0,0 +1,132 @@
+// Benchmark of RecordReader against a raw read of the same TFRecord files.
+// the files are written first, so all numbers are from the page cache.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "record_reader.h"
+#include "scope_guard.h"
+#include "tensor.h"
+
+using namespace tf_cpp;
+
+constexpr int kImageSize = 784;
+constexpr int kBatchSize = 256;
+
+void PutVarint(std::string *s, uint64_t v) {
+  while (v >= 0x80) {
+    s->push_back(static_cast<char>(v | 0x80));
+    v >>= 7;
+  }
+  s->push_back(static_cast<char>(v));
+}
+
+void PutBytes(std::string *s, int field, const std::string &bytes) {
+  PutVarint(s, (field << 3) | 2);
+  PutVarint(s, bytes.size());
+  s->append(bytes);
+}
+
+// map entry of Features.feature.
+std::string FeatureEntry(const std::string &name, int list_field,
+                         const std::string &packed) {
+  std::string list, feature, entry;
+  PutBytes(&list, 1, packed);
+  PutBytes(&feature, list_field, list);
+  PutBytes(&entry, 1, name);
+  PutBytes(&entry, 2, feature);
+  return entry;
+}
+
+std::string EncodeExample(const std::vector<float> &image, int64_t label) {
+  std::string floats(reinterpret_cast<const char *>(image.data()),
+                     image.size() * sizeof(float));
+  std::string ints;
+  PutVarint(&ints, static_cast<uint64_t>(label));
+  std::string features, example;
+  PutBytes(&features, 1, FeatureEntry("image", 2, floats));
+  PutBytes(&features, 1, FeatureEntry("label", 3, ints));
+  PutBytes(&example, 1, features);
+  return example;
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main() {
+  const int n_files = 4;
+  const int n_per_file = 20000;
+  std::vector<std::string> files;
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(0, 1);
+  std::vector<float> image(kImageSize);
+  for (int f = 0; f != n_files; ++f) {
+    files.push_back("bench_" + std::to_string(f) + ".tfrecord");
+    RecordWriter writer(files.back());
+    for (int i = 0; i != n_per_file; ++i) {
+      for (auto &v : image) v = dist(rng);
+      writer.write(EncodeExample(image, i % 10));
+    }
+    writer.close();
+  }
+
+  // raw read baseline: read every file into one buffer.
+  std::size_t raw_bytes = 0;
+  std::vector<char> buffer;
+  auto start = std::chrono::steady_clock::now();
+  for (auto &name : files) {
+    std::ifstream f(name, std::ios::binary | std::ios::ate);
+    std::size_t size = f.tellg();
+    f.seekg(0);
+    buffer.resize(size);
+    f.read(buffer.data(), size);
+    raw_bytes += size;
+  }
+  double raw_time = Seconds(start);
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "raw read: " << raw_bytes / raw_time / 1e6 << " MB/s"
+            << std::endl;
+
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  tf_utils::AddPlaceholder(graph, "image", TF_FLOAT, {-1, kImageSize});
+  tf_utils::AddPlaceholder(graph, "label", TF_INT64, {-1, 1});
+  Tensor images(graph, "image", {kBatchSize, kImageSize}, TF_FLOAT);
+  Tensor labels(graph, "label", {kBatchSize, 1}, TF_INT64);
+
+  std::vector<FeatureSpec> schema = {{"image", TF_FLOAT, kImageSize},
+                                     {"label", TF_INT64, 1}};
+  std::vector<std::size_t> threads = {1, 2, 4,
+                                      std::thread::hardware_concurrency()};
+  for (bool verify : {false, true}) {
+    for (auto n_threads : threads) {
+      RecordReaderOptions options;
+      options.verify_crc = verify;
+      options.num_threads = n_threads;
+      options.cycle_length = n_files;
+      options.shuffle = true;
+      RecordReader reader(files, schema, options);
+      start = std::chrono::steady_clock::now();
+      while (reader.next_batch({&images, &labels}) != 0) {
+      }
+      double t = Seconds(start);
+      std::cout << "threads " << n_threads << (verify ? ", crc" : ", no crc")
+                << ": " << reader.records_read() / t << " records/s, "
+                << reader.bytes_read() / t / 1e6 << " MB/s" << std::endl;
+    }
+  }
+
+  for (auto &name : files) {
+    std::remove(name.c_str());
+  }
+}
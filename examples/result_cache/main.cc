@@ -0,0 +1,113 @@
+// Serves a skewed stream of requests, where a few inputs repeat often, once
+// with Model::run and once through a ResultCache, which answers repeated
+// inputs without running the session. The model, a chain of Tanh ops, is
+// built with the C API and written to tanh.pb first.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "result_cache.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 14;
+constexpr int kLayers = 16;
+constexpr int kDistinctInputs = 1000;
+constexpr int kRequests = 5000;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto layer = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, kWidth});
+  for (int i = 0; i != kLayers; ++i) {
+    auto name =
+        i + 1 == kLayers ? std::string("y") : "tanh_" + std::to_string(i);
+    auto desc = TF_NewOperation(graph, "Tanh", name.c_str());
+    TF_AddInput(desc, {layer, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    layer = TF_FinishOperation(desc, status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+int main() {
+  WriteGraph("tanh.pb");
+  Model model("tanh.pb");
+  Tensor x(model.get_graph(), "x", {1, kWidth}, TF_FLOAT);
+  Tensor y(model.get_graph(), "y", {1, kWidth}, TF_FLOAT);
+
+  // zipf distributed input ids, id 0 is the most popular.
+  std::vector<double> weights(kDistinctInputs);
+  for (int i = 0; i != kDistinctInputs; ++i) {
+    weights[i] = 1 / std::pow(i + 1, 1.1);
+  }
+  std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+  std::mt19937 rng(1);
+  std::vector<int> requests(kRequests);
+  for (auto &r : requests) {
+    r = zipf(rng);
+  }
+  std::cout << std::fixed << std::setprecision(1) << kRequests
+            << " zipf requests over " << kDistinctInputs << " inputs of "
+            << kWidth * sizeof(float) / 1024 << "KB" << std::endl;
+
+  auto start = std::chrono::steady_clock::now();
+  double checksum = 0;
+  for (int r : requests) {
+    std::fill_n(x.data<float>(), kWidth, r * 1e-3f);
+    model.run({&x}, {&y});
+    checksum += y.at<float>(0, 0);
+  }
+  double run_seconds = Seconds(start);
+  std::cout << "Model::run:   " << run_seconds / kRequests * 1e6
+            << " us/request" << std::endl;
+
+  // room for about 10% of the distinct results.
+  ResultCacheOptions options;
+  options.max_bytes = kDistinctInputs / 10 * kWidth * sizeof(float);
+  options.shards = 4;
+  ResultCache cache(options);
+  start = std::chrono::steady_clock::now();
+  double cached_checksum = 0;
+  for (int r : requests) {
+    std::fill_n(x.data<float>(), kWidth, r * 1e-3f);
+    auto results = cache.run(model, {&x}, {&y});
+    cached_checksum += results[0].data<float>()[0];
+  }
+  double cache_seconds = Seconds(start);
+  auto stats = cache.stats();
+  std::cout << "ResultCache:  " << cache_seconds / kRequests * 1e6
+            << " us/request, " << std::setprecision(2)
+            << run_seconds / cache_seconds << "x faster, same results: "
+            << (checksum == cached_checksum ? "yes" : "no") << std::endl;
+  std::cout << std::setprecision(1) << "hit rate " << stats.hit_rate() * 100
+            << "%, " << stats.evictions << " evictions, " << stats.rejections
+            << " rejected by admission, " << stats.entries << " entries in "
+            << stats.bytes / 1024 << "KB" << std::endl;
+}
@@ -0,0 +1,149 @@
+// Mixes interactive requests with tight deadlines and bulk backfill requests
+// on one model, each class sent by its own client threads. They run once
+// through a single class Scheduler, first come first served, and once with
+// interactive traffic as the higher class and deadlines, where bulk
+// requests only get the workers interactive requests leave free. The
+// example reports the latency of each class and the requests dropped at
+// their deadline. The model, a chain of Tanh ops, is built with the C API
+// and written to tanh.pb first.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+#include "scheduler.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 14;
+constexpr int kLayers = 16;
+constexpr int kWorkers = 2;
+constexpr int kInteractiveThreads = 2;
+constexpr int kBulkThreads = 6;
+constexpr auto kInteractiveDeadline = std::chrono::milliseconds(20);
+constexpr auto kBulkDeadline = std::chrono::seconds(1);
+constexpr auto kDuration = std::chrono::seconds(3);
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto layer = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, kWidth});
+  for (int i = 0; i != kLayers; ++i) {
+    auto name =
+        i + 1 == kLayers ? std::string("y") : "tanh_" + std::to_string(i);
+    auto desc = TF_NewOperation(graph, "Tanh", name.c_str());
+    TF_AddInput(desc, {layer, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    layer = TF_FinishOperation(desc, status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+struct ClassResult {
+  std::mutex mutex;
+  std::vector<double> latencies;
+  std::atomic<int> dropped{0};
+
+  double percentile(double p) {
+    if (latencies.empty()) {
+      return 0;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))];
+  }
+};
+
+// client threads of one class, sending requests back to back until stop.
+void Clients(std::vector<std::thread> &threads, int n, Model &model,
+             Scheduler &scheduler, std::size_t priority, bool deadlines,
+             std::chrono::milliseconds deadline, ClassResult &result,
+             std::atomic<bool> &stop) {
+  for (int t = 0; t != n; ++t) {
+    threads.emplace_back([&, priority, deadlines, deadline]() {
+      Tensor x(model.get_graph(), "x", {1, kWidth}, TF_FLOAT);
+      Tensor y(model.get_graph(), "y", {1, kWidth}, TF_FLOAT);
+      x.set_zero();
+      std::vector<double> latencies;
+      while (!stop) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+          scheduler.run(model, {&x}, {&y}, priority,
+                        deadlines ? start + deadline
+                                  : Scheduler::Clock::time_point::max());
+          latencies.push_back(Seconds(start));
+        } catch (const std::exception &) {
+          ++result.dropped;
+        }
+      }
+      std::lock_guard<std::mutex> lock(result.mutex);
+      result.latencies.insert(result.latencies.end(), latencies.begin(),
+                              latencies.end());
+    });
+  }
+}
+
+void Serve(Model &model, bool prioritized) {
+  SchedulerOptions options;
+  options.workers = kWorkers;
+  options.classes = prioritized ? 2 : 1;
+  Scheduler scheduler(options);
+  ClassResult interactive, bulk;
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> threads;
+  Clients(threads, kInteractiveThreads, model, scheduler, 0, prioritized,
+          kInteractiveDeadline, interactive, stop);
+  Clients(threads, kBulkThreads, model, scheduler, prioritized ? 1 : 0,
+          prioritized, kBulkDeadline, bulk, stop);
+  std::this_thread::sleep_for(kDuration);
+  stop = true;
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  std::cout << (prioritized ? "priority + EDF:" : "first come:") << std::endl;
+  for (auto c : {std::make_pair("  interactive", &interactive),
+                 std::make_pair("  bulk       ", &bulk)}) {
+    std::cout << c.first << ": " << c.second->latencies.size()
+              << " requests, p50 " << c.second->percentile(0.5) * 1e3
+              << " ms, p99 " << c.second->percentile(0.99) * 1e3 << " ms, "
+              << c.second->dropped << " dropped" << std::endl;
+  }
+}
+
+int main() {
+  WriteGraph("tanh.pb");
+  Model model("tanh.pb");
+  std::cout << std::fixed << std::setprecision(2) << kWorkers << " workers, "
+            << kInteractiveThreads << " interactive and " << kBulkThreads
+            << " bulk clients, interactive deadline "
+            << kInteractiveDeadline.count() << " ms" << std::endl;
+  Serve(model, false);
+  Serve(model, true);
+}
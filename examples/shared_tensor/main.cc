@@ -0,0 +1,87 @@
+// Benchmark of fanning one output out to several consumers:
+// tf_utils::CopyTensor per consumer against SharedTensor handles, and the
+// cost of the copy on write when one consumer mutates its handle.
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "scope_guard.h"
+#include "shared_tensor.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kRows = 256;
+constexpr int64_t kCols = 1024;
+constexpr int kConsumers = 8;
+constexpr int kIterations = 100;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main() {
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  tf_utils::AddPlaceholder(graph, "embedding", TF_FLOAT, {kRows, kCols});
+  Tensor embedding(graph, "embedding", {kRows, kCols}, TF_FLOAT);
+  auto data = embedding.data<float>();
+  std::iota(data, data + kRows * kCols, 0.0f);
+  SharedTensor shared(std::move(embedding));
+  std::cout << std::fixed << std::setprecision(2) << kRows * kCols * 4 / 1024
+            << "KB to " << kConsumers << " consumers:" << std::endl;
+
+  // baseline: every consumer gets its own deep copy.
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != kIterations; ++i) {
+      std::vector<TF_Tensor *> copies;
+      for (int c = 0; c != kConsumers; ++c) {
+        copies.push_back(tf_utils::CopyTensor(shared.get()));
+      }
+      for (auto t : copies) {
+        sum += static_cast<float *>(TF_TensorData(t))[i];
+      }
+      tf_utils::DeleteTensors(copies);
+    }
+    std::cout << "  CopyTensor:           " << Seconds(start) / kIterations * 1e6
+              << " us (" << sum << ")" << std::endl;
+  }
+
+  // read only sharing.
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != kIterations; ++i) {
+      std::vector<SharedTensor> handles(kConsumers, shared);
+      for (auto &h : handles) {
+        sum += h.data<float>()[i];
+      }
+    }
+    std::cout << "  SharedTensor:         " << Seconds(start) / kIterations * 1e6
+              << " us (" << sum << ")" << std::endl;
+  }
+
+  // one consumer writes, only it pays for a copy.
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != kIterations; ++i) {
+      std::vector<SharedTensor> handles(kConsumers, shared);
+      handles[0].mutable_data<float>()[i] = 0;
+      for (auto &h : handles) {
+        sum += h.data<float>()[i];
+      }
+    }
+    std::cout << "  SharedTensor, 1 write: " << Seconds(start) / kIterations * 1e6
+              << " us (" << sum << ")" << std::endl;
+  }
+}
@@ -0,0 +1,128 @@
+// Compares the shared memory transport with the Unix socket of
+// InferenceServer on an Identity graph, for payloads of 1 MB to 64 MB.
+// Both servers run in this process but the clients only reach them through
+// the socket and the shared memory object, as another process would. The
+// socket copies every byte through the kernel twice each way, the shared
+// memory client writes the input once into its slot and reads the output in
+// place. Run it as
+//   shm_transport [seconds per payload]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "inference_server.h"
+#include "model.h"
+#include "scope_guard.h"
+#include "shm_transport.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto x = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {-1});
+  auto desc = TF_NewOperation(graph, "Identity", "y");
+  TF_AddInput(desc, {x, 0});
+  TF_SetAttrType(desc, "T", TF_FLOAT);
+  TF_FinishOperation(desc, status);
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+// runs request until duration has passed, at least 3 times, returns the
+// MB/s moved, the input plus the output.
+template <typename Request>
+double Throughput(std::size_t bytes, double duration, Request request) {
+  request();
+  int runs = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (runs < 3 || Seconds(start) < duration) {
+    request();
+    ++runs;
+  }
+  return 2.0 * bytes * runs / (1 << 20) / Seconds(start);
+}
+
+int main(int argc, char **argv) {
+  double duration = argc > 1 ? std::atof(argv[1]) : 1;
+  const std::size_t max_bytes = std::size_t(64) << 20;
+  WriteGraph("identity.pb");
+  Model model("identity.pb");
+
+  InferenceServerOptions socket_options;
+  socket_options.socket_path = "/tmp/tf_cpp_shm_transport.sock";
+  socket_options.inputs = {"x"};
+  socket_options.outputs = {"y"};
+  socket_options.workers = 1;
+  InferenceServer socket_server(model, socket_options);
+  std::thread socket_loop([&]() { socket_server.serve(); });
+
+  ShmServerOptions shm_options;
+  shm_options.name = "/tf_cpp_shm_transport";
+  shm_options.slots = 2;
+  // the input and the output of the largest payload.
+  shm_options.slot_bytes = 2 * max_bytes + 64;
+  shm_options.inputs = {"x"};
+  shm_options.outputs = {"y"};
+  shm_options.workers = 1;
+  ShmServer shm_server(model, shm_options);
+  std::thread shm_loop([&]() { shm_server.serve(); });
+
+  InferenceClient socket_client(socket_options.socket_path);
+  ShmClient shm_client(shm_options.name);
+  std::cout << std::fixed << std::setprecision(1);
+  for (std::size_t bytes = 1 << 20; bytes <= max_bytes; bytes *= 4) {
+    WireTensor input;
+    input.dtype = TF_FLOAT;
+    input.shape = {static_cast<int64_t>(bytes / sizeof(float))};
+    input.data.assign(bytes, 1);
+
+    double socket = Throughput(bytes, duration, [&]() {
+      auto outputs = socket_client.run({input});
+      if (outputs[0].data.size() != bytes) {
+        throw std::runtime_error("wrong response");
+      }
+    });
+    double shm = Throughput(bytes, duration, [&]() {
+      auto request = shm_client.request();
+      std::memcpy(request.input(input.dtype, input.shape), input.data.data(),
+                  bytes);
+      request.run();
+      if (request.output_bytes(0) != bytes ||
+          *static_cast<const uint8_t *>(request.output_data(0)) != 1) {
+        throw std::runtime_error("wrong response");
+      }
+    });
+    std::cout << std::setw(3) << (bytes >> 20) << " MB: socket " << socket
+              << " MB/s, shared memory " << shm << " MB/s, " << shm / socket
+              << "x" << std::endl;
+  }
+
+  socket_server.stop();
+  shm_server.stop();
+  socket_loop.join();
+  shm_loop.join();
+}
@@ -0,0 +1,146 @@
+// Several client threads send a skewed stream of requests, where a few
+// inputs are much more popular than the rest, once straight to Model::run
+// and once through a SingleFlight, which runs the session once for requests
+// that are in flight at the same time. Then one thread with only distinct
+// inputs shows what SingleFlight adds to a request it can not share. The
+// model, a chain of Tanh ops, is built with the C API and written to
+// tanh.pb first.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "model.h"
+#include "scope_guard.h"
+#include "single_flight.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 1 << 14;
+constexpr int kLayers = 16;
+constexpr int kThreads = 8;
+constexpr int kDistinctInputs = 100;
+constexpr int kRequestsPerThread = 500;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto layer = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, kWidth});
+  for (int i = 0; i != kLayers; ++i) {
+    auto name =
+        i + 1 == kLayers ? std::string("y") : "tanh_" + std::to_string(i);
+    auto desc = TF_NewOperation(graph, "Tanh", name.c_str());
+    TF_AddInput(desc, {layer, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    layer = TF_FinishOperation(desc, status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+// zipf distributed input ids per thread, id 0 is the most popular.
+std::vector<std::vector<int>> SkewedRequests() {
+  std::vector<double> weights(kDistinctInputs);
+  for (int i = 0; i != kDistinctInputs; ++i) {
+    weights[i] = 1 / std::pow(i + 1, 1.2);
+  }
+  std::discrete_distribution<int> zipf(weights.begin(), weights.end());
+  std::mt19937 rng(1);
+  std::vector<std::vector<int>> requests(kThreads);
+  for (auto &thread : requests) {
+    for (int i = 0; i != kRequestsPerThread; ++i) {
+      thread.push_back(zipf(rng));
+    }
+  }
+  return requests;
+}
+
+// run every thread's requests with serve(x, y), return the seconds taken.
+template <typename Serve>
+double RunClients(Model &model, const std::vector<std::vector<int>> &requests,
+                  Serve serve) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (auto &ids : requests) {
+    threads.emplace_back([&]() {
+      Tensor x(model.get_graph(), "x", {1, kWidth}, TF_FLOAT);
+      Tensor y(model.get_graph(), "y", {1, kWidth}, TF_FLOAT);
+      for (int id : ids) {
+        std::fill_n(x.data<float>(), kWidth, id * 1e-2f);
+        serve(x, y);
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  return Seconds(start);
+}
+
+int main() {
+  WriteGraph("tanh.pb");
+  Model model("tanh.pb");
+  auto requests = SkewedRequests();
+  const int total = kThreads * kRequestsPerThread;
+  std::cout << std::fixed << std::setprecision(1) << kThreads
+            << " threads, " << total << " zipf requests over "
+            << kDistinctInputs << " inputs" << std::endl;
+
+  double run_seconds = RunClients(
+      model, requests, [&](Tensor &x, Tensor &y) { model.run({&x}, {&y}); });
+  std::cout << "Model::run:    " << total / run_seconds << " requests/s"
+            << std::endl;
+
+  SingleFlight flight;
+  double flight_seconds =
+      RunClients(model, requests, [&](Tensor &x, Tensor &y) {
+        flight.run(model, {&x}, {&y});
+      });
+  auto stats = flight.stats();
+  std::cout << "SingleFlight:  " << total / flight_seconds << " requests/s, "
+            << stats.runs << " session runs, " << stats.shared
+            << " requests shared a run" << std::endl;
+
+  // distinct inputs, every request runs the session itself.
+  Tensor x(model.get_graph(), "x", {1, kWidth}, TF_FLOAT);
+  Tensor y(model.get_graph(), "y", {1, kWidth}, TF_FLOAT);
+  const int n = 1000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != n; ++i) {
+    x.at<float>(0, 0) = i;
+    model.run({&x}, {&y});
+  }
+  double direct = Seconds(start) / n;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i != n; ++i) {
+    x.at<float>(0, 0) = n + i;
+    flight.run(model, {&x}, {&y});
+  }
+  double deduplicated = Seconds(start) / n;
+  std::cout << std::setprecision(2) << "miss path:     "
+            << direct * 1e6 << " us direct, " << deduplicated * 1e6
+            << " us through SingleFlight" << std::endl;
+}
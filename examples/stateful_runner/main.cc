@@ -0,0 +1,100 @@
+// Runs a toy recurrent cell, h = tanh(x + h), step by step, once copying
+// the state from the output Tensor to the input Tensor after every step and
+// once with StatefulRunner, which moves it. The graph is built with the C
+// API and written to rnn.pb first.
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "model.h"
+#include "scope_guard.h"
+#include "stateful_runner.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kHidden = 1 << 20;
+constexpr int kSteps = 100;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+TF_Operation *AddOp(TF_Graph *graph, const char *type, const char *name,
+                    const std::vector<TF_Operation *> &inputs,
+                    TF_Status *status) {
+  auto desc = TF_NewOperation(graph, type, name);
+  for (auto input : inputs) {
+    TF_AddInput(desc, {input, 0});
+  }
+  TF_SetAttrType(desc, "T", TF_FLOAT);
+  return TF_FinishOperation(desc, status);
+}
+
+void WriteGraph(const std::string &filename) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  auto x = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, kHidden});
+  auto h = tf_utils::AddPlaceholder(graph, "h", TF_FLOAT, {1, kHidden});
+  auto sum = AddOp(graph, "AddV2", "sum", {x, h}, status);
+  AddOp(graph, "Tanh", "h_next", {sum}, status);
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(TF_Message(status));
+  }
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char *>(buffer->data), buffer->length);
+}
+
+int main() {
+  WriteGraph("rnn.pb");
+  Model model("rnn.pb");
+  Tensor x(model.get_graph(), "x", {1, kHidden}, TF_FLOAT);
+  x.set_zero();
+  std::cout << std::fixed << std::setprecision(1) << "state of "
+            << kHidden * sizeof(float) / 1024 << "KB, " << kSteps << " steps"
+            << std::endl;
+
+  // baseline: copy the fetched state into the input Tensor.
+  {
+    Tensor h(model.get_graph(), "h", {1, kHidden}, TF_FLOAT);
+    Tensor h_next(model.get_graph(), "h_next", {1, kHidden}, TF_FLOAT);
+    h.set_zero();
+    double copy_seconds = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != kSteps; ++i) {
+      model.run({&x, &h}, {&h_next});
+      auto copy_start = std::chrono::steady_clock::now();
+      std::memcpy(h.data<float>(), h_next.data<float>(),
+                  kHidden * sizeof(float));
+      copy_seconds += Seconds(copy_start);
+    }
+    std::cout << "copy state:      " << Seconds(start) / kSteps * 1e6
+              << " us/step, of which copy " << copy_seconds / kSteps * 1e6
+              << " us" << std::endl;
+  }
+
+  // StatefulRunner moves the fetched state into the input.
+  {
+    StatefulRunner runner(model,
+                          {{{"h", TF_FLOAT, {1, kHidden}}, "h_next"}});
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i != kSteps; ++i) {
+      runner.step({&x}, {});
+    }
+    std::cout << "StatefulRunner:  " << Seconds(start) / kSteps * 1e6
+              << " us/step" << std::endl;
+  }
+}
@@ -0,0 +1,92 @@
+// Benchmark of tf_utils::CreateStringTensor / GetStringTensorData for
+// batches of 1k short strings, against building the offset table by hand.
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "scope_guard.h"
+#include "tf_utils.h"
+
+constexpr int kBatchSize = 1000;
+constexpr int kIterations = 2000;
+
+// what callers did before: encode every string on its own, then copy.
+TF_Tensor* ManualStringTensor(const std::vector<std::string>& strings,
+                              TF_Status* status) {
+  std::vector<std::string> encoded;
+  std::vector<std::uint64_t> offsets;
+  std::uint64_t offset = 0;
+  for (auto& s : strings) {
+    std::string e(TF_StringEncodedSize(s.size()), '\0');
+    TF_StringEncode(s.data(), s.size(), &e[0], e.size(), status);
+    offsets.push_back(offset);
+    offset += e.size();
+    encoded.push_back(std::move(e));
+  }
+  std::vector<char> buffer(offsets.size() * 8 + offset);
+  std::memcpy(buffer.data(), offsets.data(), offsets.size() * 8);
+  char* p = buffer.data() + offsets.size() * 8;
+  for (auto& e : encoded) {
+    std::memcpy(p, e.data(), e.size());
+    p += e.size();
+  }
+  const std::int64_t dims[] = {static_cast<std::int64_t>(strings.size())};
+  return tf_utils::CreateTensor(TF_STRING, dims, 1, buffer.data(),
+                                buffer.size());
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main() {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> len(3, 24);
+  std::uniform_int_distribution<int> chr('a', 'z');
+  std::vector<std::string> strings(kBatchSize);
+  for (auto& s : strings) {
+    s.resize(len(rng));
+    for (auto& c : s) c = static_cast<char>(chr(rng));
+  }
+  std::vector<std::string_view> views(strings.begin(), strings.end());
+
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  const double n = static_cast<double>(kBatchSize) * kIterations;
+  std::cout << std::fixed << std::setprecision(1);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != kIterations; ++i) {
+    tf_utils::DeleteTensor(ManualStringTensor(strings, status));
+  }
+  std::cout << "manual encode: " << Seconds(start) / n * 1e9 << " ns/string"
+            << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i != kIterations; ++i) {
+    tf_utils::DeleteTensor(
+        tf_utils::CreateStringTensor(views, {kBatchSize}, status));
+  }
+  std::cout << "CreateStringTensor: " << Seconds(start) / n * 1e9
+            << " ns/string" << std::endl;
+
+  auto tensor = tf_utils::CreateStringTensor(views, {kBatchSize}, status);
+  SCOPE_EXIT { tf_utils::DeleteTensor(tensor); };
+  std::size_t total = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i != kIterations; ++i) {
+    for (auto& s : tf_utils::GetStringTensorData(tensor, status)) {
+      total += s.size();
+    }
+  }
+  std::cout << "GetStringTensorData: " << Seconds(start) / n * 1e9
+            << " ns/string (" << total << " bytes)" << std::endl;
+}
@@ -0,0 +1,122 @@
+// Benchmark of TextParser, JSON and CSV feature rows parsed into a tensor,
+// at every simd level the cpu supports, against the generic path: strtof
+// into a std::vector<float>, then a copy into the tensor. Run it as
+//   text_parser [rows]
+// the rows are 256 floats each, 4096 rows by default, about 9 MB of text.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "scope_guard.h"
+#include "simd.h"
+#include "tensor.h"
+#include "text_parser.h"
+#include "tf_utils.h"
+
+using namespace tf_cpp;
+
+constexpr int64_t kWidth = 256;
+constexpr int kIterations = 5;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// MB/s of text.
+template <typename F>
+double Throughput(const std::string &text, F f) {
+  f();  // warm up, fault in the pages.
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != kIterations; ++i) {
+    f();
+  }
+  return text.size() * double(kIterations) / (1 << 20) / Seconds(start);
+}
+
+// what a generic parser does: every number into a vector, then a copy.
+void Baseline(const std::string &text, Tensor *tensor) {
+  std::vector<float> values;
+  const char *p = text.c_str();
+  while (*p != '\0') {
+    if (std::strchr("[], \t\r\n", *p) != nullptr) {
+      ++p;
+      continue;
+    }
+    char *end;
+    values.push_back(std::strtof(p, &end));
+    if (end == p) {
+      throw std::runtime_error("malformed text.");
+    }
+    p = end;
+  }
+  if (values.size() % kWidth != 0) {
+    throw std::runtime_error("malformed text.");
+  }
+  std::memcpy(tensor->data<float>(), values.data(),
+              values.size() * sizeof(float));
+}
+
+int main(int argc, char **argv) {
+  int64_t rows = argc > 1 ? std::atoll(argv[1]) : 4096;
+  TF_Graph *graph = TF_NewGraph();
+  SCOPE_EXIT { tf_utils::DeleteGraph(graph); };
+  tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {-1, kWidth});
+
+  // features as producers print them, six significant digits.
+  std::mt19937 rng(42);
+  std::normal_distribution<float> normal;
+  std::string json = "[", csv;
+  char number[32];
+  for (int64_t r = 0; r != rows; ++r) {
+    json += r == 0 ? "[" : ",\n[";
+    for (int64_t c = 0; c != kWidth; ++c) {
+      std::snprintf(number, sizeof(number), "%.6g", normal(rng));
+      json += (c == 0 ? "" : ", ") + std::string(number);
+      csv += (c == 0 ? "" : ",") + std::string(number);
+    }
+    json += "]";
+    csv += "\n";
+  }
+  json += "]";
+
+  TextParser parser({"x", TF_FLOAT, {-1, kWidth}});
+  Tensor baseline(graph, "x", {rows, kWidth}, TF_FLOAT);
+  Tensor x(graph, "x", {-1, kWidth}, TF_FLOAT);
+  std::cout << std::fixed << std::setprecision(1) << rows << " x " << kWidth
+            << " floats, json " << json.size() / double(1 << 20)
+            << " MB, csv " << csv.size() / double(1 << 20) << " MB"
+            << std::endl;
+  std::cout << "strtof + vector + copy: json "
+            << Throughput(json, [&] { Baseline(json, &baseline); })
+            << " MB/s, csv "
+            << Throughput(csv, [&] { Baseline(csv, &baseline); }) << " MB/s"
+            << std::endl;
+
+  const auto best = simd_level();
+  for (int l = 0; l <= static_cast<int>(best); ++l) {
+    auto level = static_cast<SimdLevel>(l);
+    set_simd_level(level);
+    std::cout << "TextParser, " << simd_level_name(level) << ": json "
+              << Throughput(json, [&] { parser.parse_json(json, &x); })
+              << " MB/s, csv "
+              << Throughput(csv, [&] { parser.parse_csv(csv, &x); })
+              << " MB/s" << std::endl;
+  }
+  set_simd_level(best);
+
+  if (std::memcmp(x.data<float>(), baseline.data<float>(),
+                  rows * kWidth * sizeof(float)) != 0) {
+    std::cout << "TextParser and strtof disagree" << std::endl;
+    return 1;
+  }
+}
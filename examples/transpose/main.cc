@@ -0,0 +1,79 @@
+// Benchmark of tf_cpp::permute for image layout changes and a square
+// transpose, in GB/s of bytes read and written, against memcpy and the
+// naive nested loops.
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "simd.h"
+#include "transpose.h"
+
+constexpr int kIterations = 10;
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+template <typename F>
+double Bandwidth(F f, std::size_t bytes) {
+  f();  // warm up, fault in the pages.
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i != kIterations; ++i) {
+    f();
+  }
+  return 2.0 * bytes * kIterations / Seconds(start) / 1e9;
+}
+
+template <typename T>
+void Bench(const std::string &name, const std::vector<int64_t> &nchw) {
+  std::size_t n = 1;
+  for (auto s : nchw) n *= s;
+  std::vector<T> src(n, T(1)), dst(n);
+  const std::size_t bytes = n * sizeof(T);
+  const int64_t N = nchw[0], C = nchw[1], HW = nchw[2] * nchw[3];
+
+  std::cout << name << " " << bytes / (1 << 20) << "MB" << std::endl;
+  std::cout << "  memcpy:    "
+            << Bandwidth([&] { std::memcpy(dst.data(), src.data(), bytes); },
+                         bytes)
+            << " GB/s" << std::endl;
+  std::cout << "  naive:     " << Bandwidth([&] {
+              for (int64_t b = 0; b != N; ++b) {
+                for (int64_t c = 0; c != C; ++c) {
+                  for (int64_t p = 0; p != HW; ++p) {
+                    dst[(b * HW + p) * C + c] = src[(b * C + c) * HW + p];
+                  }
+                }
+              }
+            }, bytes)
+            << " GB/s" << std::endl;
+  const auto best = tf_cpp::simd_level();
+  for (int l = 0; l <= static_cast<int>(best); ++l) {
+    auto level = static_cast<tf_cpp::SimdLevel>(l);
+    tf_cpp::set_simd_level(level);
+    std::cout << "  permute " << std::setw(6) << std::left
+              << tf_cpp::simd_level_name(level) << std::right << " "
+              << Bandwidth([&] {
+                   tf_cpp::permute(src.data(), nchw, tf_cpp::kNchwToNhwc,
+                                   dst.data(), sizeof(T));
+                 }, bytes)
+              << " GB/s" << std::endl;
+  }
+  tf_cpp::set_simd_level(best);
+}
+
+int main() {
+  std::cout << std::fixed << std::setprecision(2);
+  Bench<float>("float NCHW -> NHWC 32x3x224x224", {32, 3, 224, 224});
+  Bench<float>("float NCHW -> NHWC 32x64x56x56", {32, 64, 56, 56});
+  Bench<float>("float transpose 4096x4096", {1, 4096, 64, 64});
+  Bench<double>("double NCHW -> NHWC 8x64x56x56", {8, 64, 56, 56});
+  Bench<uint8_t>("uint8 NCHW -> NHWC 32x3x224x224", {32, 3, 224, 224});
+}
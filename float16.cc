@@ -0,0 +1,215 @@
+// 16 bit floating point element types for TF_HALF and TF_BFLOAT16 tensors.
+
+#include "float16.h"
+
+#include "simd.h"
+
+#if defined(TF_CPP_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace tf_cpp {
+
+namespace {
+
+void FloatToHalfScalar(const float *src, half *dst, std::size_t n) {
+  for (std::size_t i = 0; i != n; ++i) {
+    dst[i].bits = detail::float_to_half_bits(src[i]);
+  }
+}
+
+void HalfToFloatScalar(const half *src, float *dst, std::size_t n) {
+  for (std::size_t i = 0; i != n; ++i) {
+    dst[i] = detail::half_bits_to_float(src[i].bits);
+  }
+}
+
+void FloatToBfloat16Scalar(const float *src, bfloat16 *dst, std::size_t n) {
+  for (std::size_t i = 0; i != n; ++i) {
+    dst[i].bits = detail::float_to_bfloat16_bits(src[i]);
+  }
+}
+
+void Bfloat16ToFloatScalar(const bfloat16 *src, float *dst, std::size_t n) {
+  for (std::size_t i = 0; i != n; ++i) {
+    dst[i] = detail::bfloat16_bits_to_float(src[i].bits);
+  }
+}
+
+#if defined(TF_CPP_X86_SIMD)
+
+__attribute__((target("avx2,f16c"))) void FloatToHalfAvx2(const float *src,
+                                                            half *dst,
+                                                            std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+  }
+  FloatToHalfScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2,f16c"))) void HalfToFloatAvx2(const half *src,
+                                                            float *dst,
+                                                            std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+  }
+  HalfToFloatScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) void FloatToBfloat16Avx2(const float *src,
+                                                         bfloat16 *dst,
+                                                         std::size_t n) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i bias = _mm256_set1_epi32(0x7fff);
+  const __m256i abs_mask = _mm256_set1_epi32(0x7fffffff);
+  const __m256i inf = _mm256_set1_epi32(0x7f800000);
+  const __m256i quiet = _mm256_set1_epi32(0x400000);
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_castps_si256(_mm256_loadu_ps(src + i));
+    __m256i odd = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+    __m256i rounded = _mm256_add_epi32(x, _mm256_add_epi32(bias, odd));
+    __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(x, abs_mask), inf);
+    rounded = _mm256_blendv_epi8(rounded, _mm256_or_si256(x, quiet), nan);
+    __m256i hi = _mm256_srli_epi32(rounded, 16);
+    // packus works per 128 bit lane, gather the two halves afterwards.
+    __m256i packed =
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(hi, hi), 0xd8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     _mm256_castsi256_si128(packed));
+  }
+  FloatToBfloat16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2"))) void Bfloat16ToFloatAvx2(const bfloat16 *src,
+                                                         float *dst,
+                                                         std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m256i x = _mm256_slli_epi32(_mm256_cvtepu16_epi32(b), 16);
+    _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(x));
+  }
+  Bfloat16ToFloatScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void FloatToHalfAvx512(const float *src,
+                                                          half *dst,
+                                                          std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(src + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), h);
+  }
+  FloatToHalfScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void HalfToFloatAvx512(const half *src,
+                                                          float *dst,
+                                                          std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(h));
+  }
+  HalfToFloatScalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void FloatToBfloat16Avx512(
+    const float *src, bfloat16 *dst, std::size_t n) {
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i bias = _mm512_set1_epi32(0x7fff);
+  const __m512i abs_mask = _mm512_set1_epi32(0x7fffffff);
+  const __m512i inf = _mm512_set1_epi32(0x7f800000);
+  const __m512i quiet = _mm512_set1_epi32(0x400000);
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_castps_si512(_mm512_loadu_ps(src + i));
+    __m512i odd = _mm512_and_si512(_mm512_srli_epi32(x, 16), one);
+    __m512i rounded = _mm512_add_epi32(x, _mm512_add_epi32(bias, odd));
+    __mmask16 nan =
+        _mm512_cmpgt_epi32_mask(_mm512_and_si512(x, abs_mask), inf);
+    rounded = _mm512_mask_blend_epi32(nan, rounded, _mm512_or_si512(x, quiet));
+    __m256i packed = _mm512_cvtepi32_epi16(_mm512_srli_epi32(rounded, 16));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+  }
+  FloatToBfloat16Scalar(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void Bfloat16ToFloatAvx512(
+    const bfloat16 *src, float *dst, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    __m512i x = _mm512_slli_epi32(_mm512_cvtepu16_epi32(b), 16);
+    _mm512_storeu_ps(dst + i, _mm512_castsi512_ps(x));
+  }
+  Bfloat16ToFloatScalar(src + i, dst + i, n - i);
+}
+
+#endif  // TF_CPP_X86_SIMD
+
+}  // namespace
+
+void float_to_half(const float *src, half *dst, std::size_t n) {
+#if defined(TF_CPP_X86_SIMD)
+  switch (simd_level()) {
+    case SimdLevel::kAvx512:
+      return FloatToHalfAvx512(src, dst, n);
+    case SimdLevel::kAvx2:
+      return FloatToHalfAvx2(src, dst, n);
+    default:
+      break;
+  }
+#endif
+  FloatToHalfScalar(src, dst, n);
+}
+
+void half_to_float(const half *src, float *dst, std::size_t n) {
+#if defined(TF_CPP_X86_SIMD)
+  switch (simd_level()) {
+    case SimdLevel::kAvx512:
+      return HalfToFloatAvx512(src, dst, n);
+    case SimdLevel::kAvx2:
+      return HalfToFloatAvx2(src, dst, n);
+    default:
+      break;
+  }
+#endif
+  HalfToFloatScalar(src, dst, n);
+}
+
+void float_to_bfloat16(const float *src, bfloat16 *dst, std::size_t n) {
+#if defined(TF_CPP_X86_SIMD)
+  switch (simd_level()) {
+    case SimdLevel::kAvx512:
+      return FloatToBfloat16Avx512(src, dst, n);
+    case SimdLevel::kAvx2:
+      return FloatToBfloat16Avx2(src, dst, n);
+    default:
+      break;
+  }
+#endif
+  FloatToBfloat16Scalar(src, dst, n);
+}
+
+void bfloat16_to_float(const bfloat16 *src, float *dst, std::size_t n) {
+#if defined(TF_CPP_X86_SIMD)
+  switch (simd_level()) {
+    case SimdLevel::kAvx512:
+      return Bfloat16ToFloatAvx512(src, dst, n);
+    case SimdLevel::kAvx2:
+      return Bfloat16ToFloatAvx2(src, dst, n);
+    default:
+      break;
+  }
+#endif
+  Bfloat16ToFloatScalar(src, dst, n);
+}
+}  // namespace tf_cpp
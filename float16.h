@@ -0,0 +1,108 @@
+// 16 bit floating point element types for TF_HALF and TF_BFLOAT16 tensors.
+
+#ifndef TENSORFLOW_C_FLOAT16_H
+#define TENSORFLOW_C_FLOAT16_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace tf_cpp {
+
+namespace detail {
+
+inline uint32_t float_bits(float f) {
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  return x;
+}
+
+inline float bits_float(uint32_t x) {
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+// round to nearest even, overflow to inf, NaN to a quiet NaN.
+inline uint16_t float_to_half_bits(float f) {
+  uint32_t x = float_bits(f);
+  uint32_t sign = (x >> 16) & 0x8000u;
+  x &= 0x7fffffffu;
+  uint16_t h;
+  if (x >= 0x47800000u) {
+    // >= 65536, inf or NaN.
+    h = x > 0x7f800000u ? 0x7e00 : 0x7c00;
+  } else if (x < 0x38800000u) {
+    // subnormal half or zero, let the fpu round.
+    const uint32_t magic = 0x3f000000u;
+    h = static_cast<uint16_t>(float_bits(bits_float(x) + bits_float(magic)) -
+                              magic);
+  } else {
+    uint32_t odd = (x >> 13) & 1u;
+    x += 0xc8000fffu + odd;  // rebias exponent by -112, round.
+    h = static_cast<uint16_t>(x >> 13);
+  }
+  return static_cast<uint16_t>(h | sign);
+}
+
+inline float half_bits_to_float(uint16_t h) {
+  uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+  uint32_t exp = (h >> 10) & 0x1fu;
+  uint32_t mant = h & 0x3ffu;
+  if (exp == 0) {
+    // zero or subnormal: mant * 2^-24.
+    float f = static_cast<float>(mant) * bits_float(0x33800000u);
+    return bits_float(float_bits(f) | sign);
+  }
+  if (exp == 0x1f) {
+    return bits_float(sign | 0x7f800000u | (mant << 13));
+  }
+  return bits_float(sign | ((exp + 112) << 23) | (mant << 13));
+}
+
+inline uint16_t float_to_bfloat16_bits(float f) {
+  uint32_t x = float_bits(f);
+  if ((x & 0x7fffffffu) > 0x7f800000u) {
+    return static_cast<uint16_t>((x >> 16) | 0x40u);
+  }
+  x += 0x7fffu + ((x >> 16) & 1u);
+  return static_cast<uint16_t>(x >> 16);
+}
+
+inline float bfloat16_bits_to_float(uint16_t b) {
+  return bits_float(static_cast<uint32_t>(b) << 16);
+}
+
+}  // namespace detail
+
+// IEEE 754 binary16, the element type of TF_HALF tensors.
+struct half {
+  uint16_t bits;
+
+  half() = default;
+  explicit half(float f) : bits(detail::float_to_half_bits(f)) {}
+  explicit operator float() const { return detail::half_bits_to_float(bits); }
+};
+
+// the upper half of a float, the element type of TF_BFLOAT16 tensors.
+struct bfloat16 {
+  uint16_t bits;
+
+  bfloat16() = default;
+  explicit bfloat16(float f) : bits(detail::float_to_bfloat16_bits(f)) {}
+  explicit operator float() const {
+    return detail::bfloat16_bits_to_float(bits);
+  }
+};
+
+static_assert(sizeof(half) == 2, "half must be 2 bytes.");
+static_assert(sizeof(bfloat16) == 2, "bfloat16 must be 2 bytes.");
+
+// bulk conversions, dispatched to AVX-512, AVX2 + F16C or scalar code by
+// simd_level(). float to 16 bit rounds to nearest even.
+void float_to_half(const float *src, half *dst, std::size_t n);
+void half_to_float(const half *src, float *dst, std::size_t n);
+void float_to_bfloat16(const float *src, bfloat16 *dst, std::size_t n);
+void bfloat16_to_float(const bfloat16 *src, float *dst, std::size_t n);
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_FLOAT16_H
@@ -0,0 +1,115 @@
+// Fast 64 bit hashes of buffers and tensors, e.g. for caching by input.
+
+#include "hash.h"
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include "tf_utils.h"
+
+namespace tf_cpp {
+
+namespace {
+
+constexpr uint64_t kSecret0 = 0xa0761d6478bd642full;
+constexpr uint64_t kSecret1 = 0xe7037ed1a0b428dbull;
+constexpr uint64_t kSecret2 = 0x8ebc6af09c88c6e3ull;
+constexpr uint64_t kSecret3 = 0x589965cc75374cc3ull;
+
+// fold the 128 bit product of a and b to 64 bits.
+inline uint64_t Mum(uint64_t a, uint64_t b) {
+  __uint128_t r = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+inline uint64_t Read8(const uint8_t *p) {
+  uint64_t v;
+  std::memcpy(&v, p, 8);
+  return v;
+}
+
+inline uint64_t Read4(const uint8_t *p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+// 1 to 3 bytes.
+inline uint64_t Read3(const uint8_t *p, std::size_t n) {
+  return (static_cast<uint64_t>(p[0]) << 16) |
+         (static_cast<uint64_t>(p[n >> 1]) << 8) | p[n - 1];
+}
+
+}  // namespace
+
+uint64_t hash_bytes(const void *data, std::size_t n, uint64_t seed) {
+  auto p = static_cast<const uint8_t *>(data);
+  seed ^= Mum(seed ^ kSecret0, kSecret1);
+  uint64_t a, b;
+  if (n <= 16) {
+    if (n >= 4) {
+      // two possibly overlapping pairs of 4 byte reads cover 4 to 16 bytes.
+      std::size_t k = (n >> 3) << 2;
+      a = (Read4(p) << 32) | Read4(p + k);
+      b = (Read4(p + n - 4) << 32) | Read4(p + n - 4 - k);
+    } else if (n > 0) {
+      a = Read3(p, n);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    std::size_t i = n;
+    if (i > 48) {
+      // three independent chains keep the multipliers busy.
+      uint64_t s1 = seed, s2 = seed;
+      do {
+        seed = Mum(Read8(p) ^ kSecret1, Read8(p + 8) ^ seed);
+        s1 = Mum(Read8(p + 16) ^ kSecret2, Read8(p + 24) ^ s1);
+        s2 = Mum(Read8(p + 32) ^ kSecret3, Read8(p + 40) ^ s2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= s1 ^ s2;
+    }
+    while (i > 16) {
+      seed = Mum(Read8(p) ^ kSecret1, Read8(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    // the last 16 bytes, overlapping what was hashed already.
+    a = Read8(p + i - 16);
+    b = Read8(p + i - 8);
+  }
+  a ^= kSecret1;
+  b ^= seed;
+  __uint128_t r = static_cast<__uint128_t>(a) * b;
+  a = static_cast<uint64_t>(r);
+  b = static_cast<uint64_t>(r >> 64);
+  return Mum(a ^ kSecret0 ^ n, b ^ kSecret1);
+}
+
+uint64_t hash_combine(uint64_t seed, uint64_t value) {
+  return Mum(seed ^ kSecret2, value ^ kSecret3);
+}
+
+uint64_t hash_tensor(const TF_Tensor *tensor, uint64_t seed) {
+  int n_dims = TF_NumDims(tensor);
+  std::vector<int64_t> header;
+  header.reserve(n_dims + 2);
+  header.push_back(TF_TensorType(tensor));
+  header.push_back(n_dims);
+  for (int i = 0; i != n_dims; ++i) {
+    header.push_back(TF_Dim(tensor, i));
+  }
+  seed = hash_bytes(header.data(), header.size() * sizeof(int64_t), seed);
+  if (TF_TensorType(tensor) == TF_STRING) {
+    for (auto s : tf_utils::GetStringTensorData(tensor)) {
+      seed = hash_bytes(s.data(), s.size(), seed);
+    }
+    return seed;
+  }
+  return hash_bytes(TF_TensorData(tensor), TF_TensorByteSize(tensor), seed);
+}
+}  // namespace tf_cpp
@@ -0,0 +1,26 @@
+// Fast 64 bit hashes of buffers and tensors, e.g. for caching by input.
+
+#ifndef TENSORFLOW_C_HASH_H
+#define TENSORFLOW_C_HASH_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tf_cpp {
+
+// a wyhash style hash of n bytes: 48 bytes per round in three independent
+// 64x64->128 bit multiply chains, several GB/s on one core. not meant to
+// resist attacks, only to spread keys well.
+uint64_t hash_bytes(const void *data, std::size_t n, uint64_t seed = 0);
+
+// mix two hashes, e.g. to combine the hashes of several tensors.
+uint64_t hash_combine(uint64_t seed, uint64_t value);
+
+// hash of the dtype, the shape and the contents of tensor, so tensors with
+// the same bytes but another shape differ. TF_STRING tensors are hashed by
+// their strings.
+uint64_t hash_tensor(const TF_Tensor *tensor, uint64_t seed = 0);
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_HASH_H
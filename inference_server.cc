@@ -0,0 +1,625 @@
+// Serves a Model to other processes of the host over a Unix domain socket.
+
+#include "inference_server.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#include "scope_guard.h"
+#include "tf_utils.h"
+
+namespace tf_cpp {
+
+namespace {
+
+struct FramePrefix {
+  uint32_t header_bytes = 0;
+  uint32_t status = 0;
+  uint64_t payload_bytes = 0;
+};
+static_assert(sizeof(FramePrefix) == 16, "FramePrefix has padding");
+
+struct TensorHeader {
+  TF_DataType dtype;
+  std::vector<int64_t> shape;
+};
+
+void AppendHeader(std::vector<uint8_t> &header, TF_DataType dtype,
+                  const int64_t *dims, std::size_t n_dims) {
+  uint32_t fields[2] = {static_cast<uint32_t>(dtype),
+                        static_cast<uint32_t>(n_dims)};
+  auto p = reinterpret_cast<const uint8_t *>(fields);
+  header.insert(header.end(), p, p + sizeof(fields));
+  p = reinterpret_cast<const uint8_t *>(dims);
+  header.insert(header.end(), p, p + n_dims * sizeof(int64_t));
+}
+
+// false if header is malformed.
+bool ParseHeader(const std::vector<uint8_t> &header,
+                 std::vector<TensorHeader> &tensors) {
+  tensors.clear();
+  std::size_t pos = 0;
+  while (pos != header.size()) {
+    uint32_t fields[2];
+    if (header.size() - pos < sizeof(fields)) {
+      return false;
+    }
+    std::memcpy(fields, header.data() + pos, sizeof(fields));
+    pos += sizeof(fields);
+    if (fields[1] > MAX_DIMS ||
+        header.size() - pos < fields[1] * sizeof(int64_t)) {
+      return false;
+    }
+    TensorHeader t{static_cast<TF_DataType>(fields[0]),
+                   std::vector<int64_t>(fields[1])};
+    std::memcpy(t.shape.data(), header.data() + pos,
+                fields[1] * sizeof(int64_t));
+    pos += fields[1] * sizeof(int64_t);
+    if (TF_DataTypeSize(t.dtype) == 0 ||
+        std::any_of(t.shape.begin(), t.shape.end(),
+                    [](int64_t d) { return d < 0; })) {
+      return false;
+    }
+    tensors.push_back(std::move(t));
+  }
+  return true;
+}
+
+// the bytes of the buffer of t in size, false if they are more than limit.
+bool ByteSize(const TensorHeader &t, uint64_t limit, uint64_t &size) {
+  size = 0;
+  if (std::find(t.shape.begin(), t.shape.end(), 0) != t.shape.end()) {
+    return true;
+  }
+  size = TF_DataTypeSize(t.dtype);
+  for (auto d : t.shape) {
+    if (static_cast<uint64_t>(d) > limit / size) {
+      return false;
+    }
+    size *= d;
+  }
+  return size <= limit;
+}
+
+// false if the graph tensor of spec can not take t. a spec without
+// dimensions may be of unknown rank, the Tensor constructor checks those.
+bool Accepts(const TensorSpec &spec, const TensorHeader &t) {
+  if (spec.dtype != t.dtype) {
+    return false;
+  }
+  if (spec.shape.empty()) {
+    return true;
+  }
+  if (spec.shape.size() != t.shape.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i != t.shape.size(); ++i) {
+    if (spec.shape[i] != -1 && spec.shape[i] != t.shape[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// a scatter gather transfer, advanced by partial reads and writes.
+struct Transfer {
+  std::vector<iovec> iov;
+  std::size_t next = 0;
+
+  void add(const void *data, std::size_t bytes) {
+    if (bytes != 0) {
+      iov.push_back({const_cast<void *>(data), bytes});
+    }
+  }
+  bool done() const { return next == iov.size(); }
+  iovec *pending() { return iov.data() + next; }
+  int count() const {
+    return static_cast<int>(std::min<std::size_t>(iov.size() - next, IOV_MAX));
+  }
+  void advance(std::size_t n) {
+    while (n != 0) {
+      auto &v = iov[next];
+      if (n < v.iov_len) {
+        v.iov_base = static_cast<char *>(v.iov_base) + n;
+        v.iov_len -= n;
+        return;
+      }
+      n -= v.iov_len;
+      ++next;
+    }
+  }
+};
+
+ssize_t Send(int fd, Transfer &t) {
+  msghdr msg = {};
+  msg.msg_iov = t.pending();
+  msg.msg_iovlen = t.count();
+  return sendmsg(fd, &msg, MSG_NOSIGNAL);
+}
+
+void SendAll(int fd, Transfer &t) {
+  while (!t.done()) {
+    auto n = Send(fd, t);
+    if (n < 0 && errno != EINTR) {
+      throw std::runtime_error(std::string("send failed: ") +
+                               std::strerror(errno));
+    }
+    t.advance(std::max<ssize_t>(n, 0));
+  }
+}
+
+void RecvAll(int fd, Transfer &t) {
+  while (!t.done()) {
+    auto n = readv(fd, t.pending(), t.count());
+    if (n == 0) {
+      throw std::runtime_error("connection closed by the server.");
+    }
+    if (n < 0 && errno != EINTR) {
+      throw std::runtime_error(std::string("receive failed: ") +
+                               std::strerror(errno));
+    }
+    t.advance(std::max<ssize_t>(n, 0));
+  }
+}
+
+sockaddr_un Address(const std::string &socket_path) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("socket path " + socket_path + " is too long.");
+  }
+  std::strcpy(address.sun_path, socket_path.c_str());
+  return address;
+}
+
+}  // namespace
+
+struct InferenceServer::Connection {
+  enum State { kPrefix, kHeader, kPayload, kRunning, kWriting };
+
+  int fd;
+  State state = kPrefix;
+  bool watched = false;
+  FramePrefix prefix;
+  std::vector<uint8_t> header;
+  Transfer transfer;
+  // reused while the shapes of the requests stay the same.
+  std::vector<Tensor> inputs;
+  std::vector<Tensor> outputs;
+  // the error of the last run, empty if it succeeded.
+  std::string error;
+  FramePrefix response_prefix;
+  std::vector<uint8_t> response_header;
+
+  void expect_prefix() {
+    state = kPrefix;
+    transfer = {};
+    transfer.add(&prefix, sizeof(prefix));
+  }
+};
+
+InferenceServer::InferenceServer(Model &model,
+                                 const InferenceServerOptions &options)
+    : model(model), options(options) {
+  for (auto &name : options.inputs) {
+    input_specs.push_back(graph_spec(model.get_graph(), name));
+  }
+  max_header_bytes =
+      input_specs.size() * (2 * sizeof(uint32_t) + MAX_DIMS * sizeof(int64_t));
+  for (auto &name : options.outputs) {
+    output_specs.push_back(graph_spec(model.get_graph(), name));
+  }
+  auto address = Address(options.socket_path);
+
+  MAKE_SCOPE_EXIT(cleanup) {
+    for (int fd : {listen_fd, epoll_fd, event_fd}) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  };
+  auto check = [](bool ok, const std::string &what) {
+    if (!ok) {
+      throw std::runtime_error(what + " failed: " + std::strerror(errno));
+    }
+  };
+  listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  check(listen_fd >= 0, "socket");
+  unlink(options.socket_path.c_str());
+  check(bind(listen_fd, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) == 0,
+        "bind " + options.socket_path);
+  check(listen(listen_fd, SOMAXCONN) == 0, "listen");
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  check(epoll_fd >= 0, "epoll_create1");
+  event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  check(event_fd >= 0, "eventfd");
+  for (int fd : {listen_fd, event_fd}) {
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    check(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0, "epoll_ctl");
+  }
+  workers.reset(new ThreadPool(std::max<std::size_t>(options.workers, 1)));
+  cleanup.dismiss();
+}
+
+InferenceServer::~InferenceServer() {
+  // the runs in flight refer to their connections.
+  workers.reset();
+  for (auto &c : connections) {
+    close(c.first);
+  }
+  close(event_fd);
+  close(epoll_fd);
+  close(listen_fd);
+  unlink(options.socket_path.c_str());
+}
+
+void InferenceServer::serve() {
+  epoll_event events[64];
+  while (!stopping) {
+    int n = epoll_wait(epoll_fd, events, 64, -1);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("epoll_wait failed: ") +
+                               std::strerror(errno));
+    }
+    for (int i = 0; i != n; ++i) {
+      int fd = events[i].data.fd;
+      if (fd == listen_fd) {
+        accept_connections();
+        continue;
+      }
+      if (fd == event_fd) {
+        uint64_t count;
+        while (read(event_fd, &count, sizeof(count)) > 0) {
+        }
+        std::vector<int> finished;
+        {
+          std::lock_guard<std::mutex> lock(done_mutex);
+          finished.swap(done);
+        }
+        for (int f : finished) {
+          on_done(*connections.at(f));
+        }
+        continue;
+      }
+      auto it = connections.find(fd);
+      if (it == connections.end()) {
+        continue;
+      }
+      auto &c = *it->second;
+      bool open = true;
+      if (events[i].events & EPOLLOUT) {
+        open = on_writable(c);
+      } else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        open = on_readable(c);
+      }
+      if (!open) {
+        close_connection(fd);
+      }
+    }
+  }
+}
+
+void InferenceServer::stop() {
+  stopping = true;
+  uint64_t one = 1;
+  // write is async signal safe, and a full eventfd wakes the loop as well.
+  if (write(event_fd, &one, sizeof(one)) < 0) {
+  }
+}
+
+void InferenceServer::accept_connections() {
+  while (true) {
+    int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      return;
+    }
+    std::unique_ptr<Connection> c(new Connection());
+    c->fd = fd;
+    for (auto &spec : output_specs) {
+      c->outputs.emplace_back(model.get_graph(), spec);
+    }
+    c->expect_prefix();
+    watch(*c, EPOLLIN);
+    connections[fd] = std::move(c);
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    ++counters.connections;
+  }
+}
+
+bool InferenceServer::on_readable(Connection &c) {
+  while (true) {
+    if (!c.transfer.done()) {
+      auto n = readv(c.fd, c.transfer.pending(), c.transfer.count());
+      if (n == 0) {
+        return false;
+      }
+      if (n < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+      }
+      c.transfer.advance(n);
+      continue;
+    }
+    if (c.state == Connection::kPrefix) {
+      // each field on its own, their sum could wrap. the header is read
+      // before it is checked, so it may only be as big as the header of
+      // the inputs of the graph can be.
+      if (c.prefix.status != 0 || c.prefix.header_bytes > max_header_bytes ||
+          c.prefix.header_bytes > options.max_frame_bytes ||
+          c.prefix.payload_bytes >
+              options.max_frame_bytes - c.prefix.header_bytes) {
+        break;
+      }
+      c.state = Connection::kHeader;
+      c.header.resize(c.prefix.header_bytes);
+      c.transfer = {};
+      c.transfer.add(c.header.data(), c.header.size());
+    } else if (c.state == Connection::kHeader) {
+      if (!on_request(c)) {
+        break;
+      }
+    } else {
+      // the payload is in the input tensors.
+      c.state = Connection::kRunning;
+      watch(c, 0);
+      workers->enqueue([this, &c]() {
+        std::vector<Tensor *> inputs, outputs;
+        for (auto &t : c.inputs) {
+          inputs.push_back(&t);
+        }
+        for (auto &t : c.outputs) {
+          outputs.push_back(&t);
+        }
+        try {
+          model.run(inputs, outputs);
+          c.error.clear();
+        } catch (const std::exception &e) {
+          c.error = e.what();
+        }
+        {
+          std::lock_guard<std::mutex> lock(done_mutex);
+          done.push_back(c.fd);
+        }
+        uint64_t one = 1;
+        if (write(event_fd, &one, sizeof(one)) < 0) {
+        }
+      });
+      return true;
+    }
+  }
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  ++counters.protocol_errors;
+  return false;
+}
+
+bool InferenceServer::on_request(Connection &c) {
+  std::vector<TensorHeader> tensors;
+  if (!ParseHeader(c.header, tensors) ||
+      tensors.size() != input_specs.size()) {
+    return false;
+  }
+  // the header must match the graph and the payload before any buffer is
+  // allocated, the client chooses the shapes.
+  std::vector<uint64_t> bytes(tensors.size());
+  uint64_t payload_bytes = 0;
+  for (std::size_t i = 0; i != tensors.size(); ++i) {
+    if (!Accepts(input_specs[i], tensors[i]) ||
+        !ByteSize(tensors[i], c.prefix.payload_bytes - payload_bytes,
+                  bytes[i])) {
+      return false;
+    }
+    payload_bytes += bytes[i];
+  }
+  if (payload_bytes != c.prefix.payload_bytes) {
+    return false;
+  }
+  c.inputs.reserve(tensors.size());
+  c.transfer = {};
+  try {
+    for (std::size_t i = 0; i != tensors.size(); ++i) {
+      auto &t = tensors[i];
+      if (i == c.inputs.size() || c.inputs[i].tf_type != t.dtype ||
+          c.inputs[i].tf_shape != t.shape) {
+        Tensor input(model.get_graph(), input_specs[i].name, t.shape,
+                     t.dtype);
+        if (i == c.inputs.size()) {
+          c.inputs.push_back(std::move(input));
+        } else {
+          c.inputs[i] = std::move(input);
+        }
+      }
+      c.transfer.add(c.inputs[i].raw_data(), bytes[i]);
+    }
+  } catch (const std::exception &) {
+    // a rank the graph does not take, or the buffers can not be allocated.
+    c.inputs.clear();
+    return false;
+  }
+  c.state = Connection::kPayload;
+  return true;
+}
+
+void InferenceServer::on_done(Connection &c) {
+  c.response_prefix = {};
+  c.response_header.clear();
+  c.transfer = {};
+  c.transfer.add(&c.response_prefix, sizeof(c.response_prefix));
+  if (c.error.empty()) {
+    for (auto &t : c.outputs) {
+      if (t.tf_tensor == nullptr || TF_DataTypeSize(t.tf_type) == 0) {
+        c.error = "output of type " + tf_utils::DataTypeToString(t.tf_type) +
+                  " can not be sent.";
+        break;
+      }
+    }
+  }
+  if (c.error.empty()) {
+    for (auto &t : c.outputs) {
+      AppendHeader(c.response_header, t.tf_type, t.tf_shape.data(),
+                   t.tf_shape.size());
+    }
+    c.transfer.add(c.response_header.data(), c.response_header.size());
+    for (auto &t : c.outputs) {
+      auto bytes = TF_TensorByteSize(t.tf_tensor);
+      c.response_prefix.payload_bytes += bytes;
+      c.transfer.add(TF_TensorData(t.tf_tensor), bytes);
+    }
+  } else {
+    c.response_prefix.status = 1;
+    c.response_prefix.payload_bytes = c.error.size();
+    c.transfer.add(c.error.data(), c.error.size());
+  }
+  c.response_prefix.header_bytes =
+      static_cast<uint32_t>(c.response_header.size());
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    ++counters.requests;
+    counters.errors += !c.error.empty();
+  }
+  c.state = Connection::kWriting;
+  if (!on_writable(c)) {
+    close_connection(c.fd);
+  }
+}
+
+bool InferenceServer::on_writable(Connection &c) {
+  while (!c.transfer.done()) {
+    auto n = Send(c.fd, c.transfer);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        watch(c, EPOLLOUT);
+        return true;
+      }
+      return false;
+    }
+    c.transfer.advance(n);
+  }
+  c.expect_prefix();
+  watch(c, EPOLLIN);
+  // the next request may be in the socket already.
+  return on_readable(c);
+}
+
+void InferenceServer::close_connection(int fd) {
+  auto it = connections.find(fd);
+  if (it->second->watched) {
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  }
+  close(fd);
+  connections.erase(it);
+}
+
+void InferenceServer::watch(Connection &c, uint32_t events) {
+  epoll_event event = {};
+  event.events = events;
+  event.data.fd = c.fd;
+  if (events == 0) {
+    // a connection in the set reports hangups even without events.
+    if (c.watched) {
+      epoll_ctl(epoll_fd, EPOLL_CTL_DEL, c.fd, &event);
+      c.watched = false;
+    }
+    return;
+  }
+  epoll_ctl(epoll_fd, c.watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, c.fd,
+            &event);
+  c.watched = true;
+}
+
+InferenceServerStats InferenceServer::stats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  return counters;
+}
+
+InferenceClient::InferenceClient(const std::string &socket_path) {
+  auto address = Address(socket_path);
+  fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address),
+                        sizeof(address)) != 0) {
+    auto error = std::string(std::strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw std::runtime_error("can not connect to " + socket_path + ": " +
+                             error);
+  }
+}
+
+InferenceClient::~InferenceClient() { close(fd); }
+
+std::vector<WireTensor> InferenceClient::run(
+    const std::vector<WireTensor> &inputs) {
+  FramePrefix prefix;
+  std::vector<uint8_t> header;
+  for (auto &t : inputs) {
+    AppendHeader(header, t.dtype, t.shape.data(), t.shape.size());
+    prefix.payload_bytes += t.data.size();
+  }
+  prefix.header_bytes = static_cast<uint32_t>(header.size());
+  Transfer request;
+  request.add(&prefix, sizeof(prefix));
+  request.add(header.data(), header.size());
+  for (auto &t : inputs) {
+    request.add(t.data.data(), t.data.size());
+  }
+  SendAll(fd, request);
+
+  Transfer response;
+  response.add(&prefix, sizeof(prefix));
+  RecvAll(fd, response);
+  header.resize(prefix.header_bytes);
+  response = {};
+  response.add(header.data(), header.size());
+  RecvAll(fd, response);
+  if (prefix.status != 0) {
+    std::string error(prefix.payload_bytes, '\0');
+    response = {};
+    response.add(&error[0], error.size());
+    RecvAll(fd, response);
+    throw std::runtime_error(error);
+  }
+  std::vector<TensorHeader> tensors;
+  if (!ParseHeader(header, tensors)) {
+    throw std::runtime_error("malformed response.");
+  }
+  std::vector<WireTensor> outputs(tensors.size());
+  response = {};
+  uint64_t payload_bytes = 0;
+  for (std::size_t i = 0; i != tensors.size(); ++i) {
+    uint64_t bytes;
+    if (!ByteSize(tensors[i], prefix.payload_bytes - payload_bytes, bytes)) {
+      throw std::runtime_error("malformed response.");
+    }
+    outputs[i].dtype = tensors[i].dtype;
+    outputs[i].data.resize(bytes);
+    outputs[i].shape = std::move(tensors[i].shape);
+    payload_bytes += outputs[i].data.size();
+    response.add(outputs[i].data.data(), outputs[i].data.size());
+  }
+  if (payload_bytes != prefix.payload_bytes) {
+    throw std::runtime_error("malformed response.");
+  }
+  RecvAll(fd, response);
+  return outputs;
+}
+}  // namespace tf_cpp
@@ -0,0 +1,139 @@
+// Serves a Model to other processes of the host over a Unix domain socket.
+
+#ifndef TENSORFLOW_C_INFERENCE_SERVER_H
+#define TENSORFLOW_C_INFERENCE_SERVER_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "tensor.h"
+#include "thread_pool.h"
+
+namespace tf_cpp {
+
+// the protocol, every integer in host byte order:
+//   frame:  uint32 header bytes, uint32 status, uint64 payload bytes,
+//           header, payload.
+//   header: per tensor uint32 dtype, uint32 dims, int64 dim[dims].
+//   payload: the buffers of the tensors, one after the other.
+// a request carries the inputs, a response the outputs. a response with
+// status 1 has no tensors and its payload is the error message.
+
+// a tensor as it travels over the socket.
+struct WireTensor {
+  TF_DataType dtype = TF_FLOAT;
+  std::vector<int64_t> shape;
+  std::vector<uint8_t> data;
+};
+
+struct InferenceServerOptions {
+  std::string socket_path;
+  // the names of the tensors a request feeds, in order.
+  std::vector<std::string> inputs;
+  // the names of the tensors a response returns, in order.
+  std::vector<std::string> outputs;
+  // session runs at a time.
+  std::size_t workers = 4;
+  // bigger frames close the connection.
+  std::size_t max_frame_bytes = std::size_t(1) << 30;
+};
+
+struct InferenceServerStats {
+  std::size_t connections = 0;
+  std::size_t requests = 0;
+  // requests whose run failed, they get an error response.
+  std::size_t errors = 0;
+  // malformed requests, they close the connection.
+  std::size_t protocol_errors = 0;
+};
+
+// an epoll loop serving model to local clients. every connection has its
+// own input Tensors, reused while the request shapes stay the same, and a
+// request payload is read from the socket straight into their buffers.
+// outputs are written to the socket straight from the output tensors.
+// a connection has one request in flight, clients open several
+// connections for more. the runs of all connections share one session and
+// run on a pool of workers.
+class InferenceServer {
+ public:
+  // listens on options.socket_path, replacing a stale socket file.
+  // throws std::runtime_error if the socket can not be set up.
+  InferenceServer(Model &model, const InferenceServerOptions &options);
+
+  InferenceServer(const InferenceServer &server) = delete;
+  InferenceServer &operator=(const InferenceServer &server) = delete;
+
+  // closes the connections and removes the socket file.
+  ~InferenceServer();
+
+  // serve on this thread until stop.
+  void serve();
+  // make serve return. safe to call from any thread and from a signal
+  // handler.
+  void stop();
+
+  InferenceServerStats stats() const;
+
+ private:
+  struct Connection;
+
+  void accept_connections();
+  // false once the connection is to be closed.
+  bool on_readable(Connection &c);
+  bool on_writable(Connection &c);
+  bool on_request(Connection &c);
+  void on_done(Connection &c);
+  void close_connection(int fd);
+  // 0 takes the connection out of the epoll set, e.g. while it runs.
+  void watch(Connection &c, uint32_t events);
+
+  Model &model;
+  InferenceServerOptions options;
+  std::vector<TensorSpec> input_specs;
+  std::vector<TensorSpec> output_specs;
+  // the header of a request with MAX_DIMS dimensions for every input.
+  std::size_t max_header_bytes = 0;
+  int listen_fd = -1;
+  int epoll_fd = -1;
+  // wakes the loop for finished runs and for stop.
+  int event_fd = -1;
+  std::atomic<bool> stopping{false};
+  std::map<int, std::unique_ptr<Connection>> connections;
+  // connections whose run finished, handed from the workers to the loop.
+  std::mutex done_mutex;
+  std::vector<int> done;
+  mutable std::mutex stats_mutex;
+  InferenceServerStats counters;
+  std::unique_ptr<ThreadPool> workers;
+};
+
+// a blocking client of an InferenceServer, one request at a time.
+class InferenceClient {
+ public:
+  // throws std::runtime_error if it can not connect.
+  explicit InferenceClient(const std::string &socket_path);
+
+  InferenceClient(const InferenceClient &client) = delete;
+  InferenceClient &operator=(const InferenceClient &client) = delete;
+
+  ~InferenceClient();
+
+  // the outputs of the model for inputs.
+  // throws std::runtime_error with the message of the server if the run
+  // failed, or if the connection broke.
+  std::vector<WireTensor> run(const std::vector<WireTensor> &inputs);
+
+ private:
+  int fd = -1;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_INFERENCE_SERVER_H
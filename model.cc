@@ -3,24 +3,96 @@
 // Reconstructed by Weiming Liu in 04/05/20.
 
 #include "model.h"
+
+#include <atomic>
+
+#include "scope_guard.h"
 #include "tf_utils.h"
 
 namespace tf_cpp {
 
+namespace {
+
+// the share of GPU memory a session takes, it grows into it as needed.
+constexpr double kGpuMemoryFraction = 0.2;
+
+std::atomic<std::uint64_t> next_model_id{1};
+
+ModelOptions DeviceOptions(const std::string& device) {
+  ModelOptions options;
+  options.device = device;
+  return options;
+}
+
+}  // namespace
+
 Model::Model(const std::string& model_filename, const std::string& device)
-    : device(device),
+    : Model(model_filename, DeviceOptions(device)) {}
+
+Model::Model(const std::string& model_filename, const ModelOptions& options)
+    : device(options.device),
       status(nullptr),
       graph(nullptr),
       opts(nullptr),
-      session(nullptr) {
+      session(nullptr),
+      id(next_model_id++) {
   status = TF_NewStatus();
-  graph = tf_utils::LoadGraph(model_filename.c_str(), status);
-  if (graph == nullptr) {
-    throw std::runtime_error("tf_utils::LoadGraph error");
+  graph = TF_NewGraph();
+  auto import_opts = TF_NewImportGraphDefOptions();
+  SCOPE_EXIT { TF_DeleteImportGraphDefOptions(import_opts); };
+  if (!device.empty()) {
+    TF_ImportGraphDefOptionsSetDefaultDevice(import_opts, device.c_str());
+  }
+  if (!options.prefix.empty()) {
+    TF_ImportGraphDefOptionsSetPrefix(import_opts, options.prefix.c_str());
+  }
+
+  // the preprocessing graphs go first, the model inputs are mapped to them.
+  for (auto& splice : options.preprocess) {
+    if (splice.prefix.empty()) {
+      throw std::runtime_error("preprocessing graph " + splice.filename +
+                               " has no prefix");
+    }
+    auto splice_opts = TF_NewImportGraphDefOptions();
+    SCOPE_EXIT { TF_DeleteImportGraphDefOptions(splice_opts); };
+    TF_ImportGraphDefOptionsSetPrefix(splice_opts, splice.prefix.c_str());
+    if (!device.empty()) {
+      TF_ImportGraphDefOptionsSetDefaultDevice(splice_opts, device.c_str());
+    }
+    auto tf_code = tf_utils::ImportGraph(graph, splice.filename.c_str(),
+                                         splice_opts, status);
+    if (tf_code != TF_OK) {
+      throw std::runtime_error("tf_utils::ImportGraph error: " +
+                               splice.filename);
+    }
+    for (auto& input : splice.inputs) {
+      auto src = tf_utils::SplitTensorName(input.first);
+      auto dst = tf_utils::SplitTensorName(splice.prefix + "/" + input.second);
+      TF_Output out{TF_GraphOperationByName(graph, dst.first.c_str()),
+                    dst.second};
+      if (out.oper == nullptr) {
+        throw std::runtime_error("no preprocessing output " + dst.first);
+      }
+      TF_ImportGraphDefOptionsAddInputMapping(import_opts, src.first.c_str(),
+                                              src.second, out);
+    }
   }
 
-  // Create the session.
-  opts = tf_utils::CreateSessionOptions(0.2, status);
+  auto tf_code = tf_utils::ImportGraph(graph, model_filename.c_str(),
+                                       import_opts, status);
+  if (tf_code != TF_OK) {
+    throw std::runtime_error("tf_utils::ImportGraph error");
+  }
+
+  // Create the session. both kinds of options keep the same gpu options.
+  if (options.cpu_devices > 0 || options.intra_op_threads > 0 ||
+      options.inter_op_threads > 0) {
+    opts = tf_utils::CreateCpuSessionOptions(
+        options.cpu_devices, options.intra_op_threads, options.inter_op_threads,
+        kGpuMemoryFraction, status);
+  } else {
+    opts = tf_utils::CreateSessionOptions(kGpuMemoryFraction, status);
+  }
   if (opts == nullptr) {
     throw std::runtime_error("tf_utils::CreateSessionOptions error");
   }
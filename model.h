@@ -8,20 +8,61 @@
 #include <tensorflow/c/c_api.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <fstream>
+#include <initializer_list>
 #include <iostream>
+#include <map>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
+#include "shared_tensor.h"
 #include "tensor.h"
 
 namespace tf_cpp {
 
+// a preprocessing graph imported in front of a model, e.g. normalization.
+// its outputs are wired straight into the model placeholders, so one run
+// goes from the raw inputs to the model outputs without host copies.
+struct GraphSplice {
+  // GraphDef file of the preprocessing graph.
+  std::string filename;
+  // its nodes are named prefix/<name>, e.g. "pre/raw" to feed its input.
+  // must not be empty, the constructor throws std::runtime_error.
+  std::string prefix;
+  // model placeholder -> preprocessing output, without the prefix,
+  // e.g. {{"input", "normalized"}} or {{"input:0", "split:1"}}.
+  // an empty map only imports the graph next to the model.
+  std::map<std::string, std::string> inputs;
+};
+
+struct ModelOptions {
+  // device of the nodes that do not name one, e.g. "/cpu:0" or "/gpu:1".
+  // empty leaves the placement to tensorflow.
+  std::string device;
+  // the model nodes are named prefix/<name>, empty keeps the names.
+  std::string prefix;
+  // number of CPU devices, /cpu:0 to /cpu:<cpu_devices - 1>, e.g. to pin
+  // sub-towers to different devices. these are logical devices, they all
+  // share the intra op pool of the session and get no threads of their own,
+  // only the global pool sizes below can be set.
+  // 0 keeps the default of one.
+  int cpu_devices = 0;
+  // sizes of the session thread pools, 0 keeps the default of tensorflow.
+  int intra_op_threads = 0;
+  int inter_op_threads = 0;
+  // graphs imported first, whose outputs feed the model inputs.
+  std::vector<GraphSplice> preprocess;
+};
+
 class Model {
  public:
+  // device is the default device of the imported nodes, see ModelOptions.
   explicit Model(const std::string& model_filename,
-                 const std::string& device = "/cpu:0");
+                 const std::string& device = "");
+  Model(const std::string& model_filename, const ModelOptions& options);
 
   Model(const Model& model) = delete;
   Model(Model&& model) = default;
@@ -31,12 +72,16 @@ class Model {
   ~Model();
 
   TF_Graph* get_graph() { return graph; }
+  // unique among the Models of the process, also once a Model is destroyed
+  // and another one gets its graph at the same addresses.
+  std::uint64_t get_id() const { return id; }
   void restore(const std::string& ckpt);
   void save(const std::string& ckpt);
   void save_graph(const std::string& graph_path);
   std::vector<std::string> get_operations() const;
 
   // inputs should containts datas for evaluating.
+  // run is thread safe as long as every thread uses its own Tensors.
   // outputs and operations will be evaluated.
   // after that, the users can access outputs' data.
   // we does not need to know the type of Tensors, so we use a std::variant
@@ -44,6 +89,64 @@ class Model {
   void run(const std::vector<Tensor*>& inputs,
            const std::vector<Tensor*>& outputs,
            const std::vector<TF_Operation*>& operations = {}) {
+    run_tensors(inputs, outputs, operations, nullptr);
+  }
+
+  // like run, but tensorflow cancels the run and it throws
+  // std::runtime_error("TF_DEADLINE_EXCEEDED") once it takes longer than
+  // timeout_in_ms. 0 means no timeout.
+  void run_with_timeout(const std::vector<Tensor*>& inputs,
+                        const std::vector<Tensor*>& outputs,
+                        std::int64_t timeout_in_ms,
+                        const std::vector<TF_Operation*>& operations = {}) {
+    auto run_options = tf_utils::CreateRunOptions(timeout_in_ms);
+    try {
+      run_tensors(inputs, outputs, operations, run_options);
+    } catch (...) {
+      TF_DeleteBuffer(run_options);
+      throw;
+    }
+    TF_DeleteBuffer(run_options);
+  }
+
+  // like run, feeding SharedTensors without copying them, e.g. an output of
+  // the last run bound to an input with SharedTensor::bind.
+  // inputs is a std::vector or a braced list of SharedTensor. this is a
+  // template, so braced lists of Tensor* still pick the overload above.
+  template <typename SharedTensors,
+            typename = std::enable_if_t<std::is_same<
+                typename SharedTensors::value_type, SharedTensor>::value>>
+  void run(const SharedTensors& inputs, const std::vector<Tensor*>& outputs,
+           const std::vector<TF_Operation*>& operations = {}) {
+    std::vector<TF_Output> io;
+    std::vector<TF_Tensor*> iv;
+    io.reserve(inputs.size());
+    iv.reserve(inputs.size());
+    for (auto& i : inputs) {
+      io.push_back(i.op());
+      iv.push_back(i.get());
+    }
+    run_session(io, iv, outputs, operations);
+  }
+
+  void run(std::initializer_list<SharedTensor> inputs,
+           const std::vector<Tensor*>& outputs,
+           const std::vector<TF_Operation*>& operations = {}) {
+    run<std::initializer_list<SharedTensor>>(inputs, outputs, operations);
+  }
+
+  void run_operation(TF_Operation* op) {
+    run(std::vector<Tensor*>{}, {}, {op});
+  }
+
+ private:
+  friend class PartialRun;
+  friend class PrefixCache;
+
+  void run_tensors(const std::vector<Tensor*>& inputs,
+                   const std::vector<Tensor*>& outputs,
+                   const std::vector<TF_Operation*>& operations,
+                   const TF_Buffer* run_options) {
     // Get input operations
     std::vector<TF_Output> io(inputs.size());
     std::transform(inputs.begin(), inputs.end(), io.begin(),
@@ -54,6 +157,14 @@ class Model {
     std::transform(inputs.begin(), inputs.end(), iv.begin(),
                    [](auto i) { return i->tf_tensor; });
 
+    run_session(io, iv, outputs, operations, run_options);
+  }
+
+  void run_session(const std::vector<TF_Output>& io,
+                   const std::vector<TF_Tensor*>& iv,
+                   const std::vector<Tensor*>& outputs,
+                   const std::vector<TF_Operation*>& operations,
+                   const TF_Buffer* run_options = nullptr) {
     // Get output operations
     std::vector<TF_Output> oo(outputs.size());
     std::transform(outputs.begin(), outputs.end(), oo.begin(),
@@ -61,8 +172,9 @@ class Model {
 
     // Get output values
     std::vector<TF_Tensor*> ov(outputs.size());
-    auto tf_code =
-        tf_utils::RunSession(session, io, iv, oo, ov, operations, status);
+    // no shared status, so several threads can run the session at once.
+    auto tf_code = tf_utils::RunSession(session, io, iv, oo, ov, operations,
+                                        nullptr, run_options);
     if (tf_code != TF_OK) {
       throw std::runtime_error(tf_utils::CodeToString(tf_code));
     }
@@ -73,14 +185,12 @@ class Model {
     }
   }
 
-  void run_operation(TF_Operation* op) { run({}, {}, {op}); }
-
- private:
   TF_Status* status;
   TF_Graph* graph;
   TF_SessionOptions* opts;
   TF_Session* session;
   std::string device;
+  std::uint64_t id;
 
   // Read a file from a string
   static TF_Buffer* read(const std::string&);
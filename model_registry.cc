@@ -0,0 +1,253 @@
+// Loads models on demand within a memory budget, evicting unused ones.
+
+#include "model_registry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "scope_guard.h"
+
+namespace tf_cpp {
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+std::size_t FileSize(const std::string &filename) {
+  std::ifstream f(filename, std::ios::binary | std::ios::ate);
+  return f ? static_cast<std::size_t>(f.tellg()) : 0;
+}
+
+// bytes of the variables of graph, from the shape and dtype attributes of
+// the variable ops. variables of unknown shape are not counted.
+std::size_t VariableBytes(TF_Graph *graph) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT { TF_DeleteStatus(status); };
+  std::size_t bytes = 0;
+  std::size_t pos = 0;
+  TF_Operation *oper;
+  while ((oper = TF_GraphNextOperation(graph, &pos)) != nullptr) {
+    std::string type = TF_OperationOpType(oper);
+    if (type != "VariableV2" && type != "Variable" && type != "VarHandleOp") {
+      continue;
+    }
+    auto meta = TF_OperationGetAttrMetadata(oper, "shape", status);
+    if (TF_GetCode(status) != TF_OK || meta.total_size < 0) {
+      continue;
+    }
+    std::vector<int64_t> dims(meta.total_size);
+    TF_OperationGetAttrShape(oper, "shape", dims.data(),
+                             static_cast<int>(dims.size()), status);
+    TF_DataType dtype;
+    TF_OperationGetAttrType(oper, "dtype", &dtype, status);
+    if (TF_GetCode(status) != TF_OK) {
+      continue;
+    }
+    std::size_t n = TF_DataTypeSize(dtype);
+    for (auto d : dims) {
+      n *= std::max<int64_t>(d, 0);
+    }
+    bytes += n;
+  }
+  return bytes;
+}
+
+}  // namespace
+
+ModelRegistry::ModelRegistry(const ModelRegistryOptions &options)
+    : options(options), prefetch_pool(options.prefetch_threads) {}
+
+void ModelRegistry::add(const std::string &name,
+                        const std::string &filename) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!entries.emplace(name, Entry()).second) {
+    throw std::runtime_error("model " + name + " is registered twice.");
+  }
+  entries[name].filename = filename;
+}
+
+ModelRegistry::Entry &ModelRegistry::entry(const std::string &name) {
+  auto it = entries.find(name);
+  if (it == entries.end()) {
+    throw std::runtime_error("no model " + name + " is registered.");
+  }
+  return it->second;
+}
+
+std::shared_ptr<Model> ModelRegistry::get(const std::string &name) {
+  return acquire(name, false);
+}
+
+void ModelRegistry::prefetch(const std::string &name) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &e = entry(name);
+    // a model known not to fit would only make room by evicting models used
+    // more recently than it.
+    if (e.model.valid() || options.prefetch_threads == 0 ||
+        counters.bytes + e.footprint() > options.memory_budget) {
+      return;
+    }
+  }
+  prefetch_pool.enqueue([this, name]() {
+    try {
+      acquire(name, true);
+    } catch (const std::exception &) {
+      // the next get of the model loads it again and reports the error.
+    }
+  });
+}
+
+std::shared_ptr<Model> ModelRegistry::acquire(const std::string &name,
+                                              bool prefetching) {
+  std::promise<std::shared_ptr<Model>> promise;
+  std::string filename;
+  std::string predicted;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto &e = entry(name);
+    if (!prefetching) {
+      if (!last_requested.empty() && last_requested != name) {
+        ++entries[last_requested].next[name];
+      }
+      last_requested = name;
+      if (options.predict && !e.next.empty()) {
+        predicted = std::max_element(e.next.begin(), e.next.end(),
+                                     [](auto &a, auto &b) {
+                                       return a.second < b.second;
+                                     })
+                        ->first;
+      }
+    }
+    if (e.model.valid()) {
+      if (prefetching) {
+        return nullptr;
+      }
+      ++counters.hits;
+      lru.splice(lru.begin(), lru, e.lru_pos);
+      auto model = e.model;
+      lock.unlock();
+      if (!predicted.empty()) {
+        prefetch(predicted);
+      }
+      return model.get();
+    }
+    e.model = promise.get_future().share();
+    if (prefetching) {
+      // the least recently used until a get asks for it, so a prefetch that
+      // does not fit evicts itself rather than the models in use.
+      lru.push_back(name);
+      e.lru_pos = std::prev(lru.end());
+      ++counters.prefetches;
+    } else {
+      lru.push_front(name);
+      e.lru_pos = lru.begin();
+    }
+    filename = e.filename;
+  }
+  if (!predicted.empty()) {
+    prefetch(predicted);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::shared_ptr<Model> model;
+  std::size_t variable_bytes;
+  try {
+    model = std::make_shared<Model>(filename, options.model_options);
+    variable_bytes = VariableBytes(model->get_graph());
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto &e = entries[name];
+      e.model = {};
+      lru.erase(e.lru_pos);
+    }
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  double seconds = Seconds(start);
+
+  // models evicted to make room are destroyed after the lock is released.
+  std::vector<std::shared_future<std::shared_ptr<Model>>> evicted;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &e = entries[name];
+    e.loaded = true;
+    e.graph_bytes = FileSize(filename);
+    e.variable_bytes = variable_bytes;
+    counters.bytes += e.footprint();
+    ++counters.loads;
+    counters.load_seconds += seconds;
+    counters.max_load_seconds = std::max(counters.max_load_seconds, seconds);
+    evicted = evict(prefetching ? std::string() : name);
+  }
+  promise.set_value(model);
+  return model;
+}
+
+std::vector<std::shared_future<std::shared_ptr<Model>>> ModelRegistry::evict(
+    const std::string &keep) {
+  std::vector<std::shared_future<std::shared_ptr<Model>>> evicted;
+  for (auto it = lru.end();
+       counters.bytes > options.memory_budget && it != lru.begin();) {
+    --it;
+    auto &e = entries[*it];
+    if (*it == keep || !e.loaded) {
+      continue;
+    }
+    counters.bytes -= e.footprint();
+    e.loaded = false;
+    evicted.push_back(std::move(e.model));
+    e.model = {};
+    ++counters.evictions;
+    it = lru.erase(it);
+  }
+  return evicted;
+}
+
+void ModelRegistry::observe_peak(const std::string &name, std::size_t bytes) {
+  std::vector<std::shared_future<std::shared_ptr<Model>>> evicted;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto &e = entry(name);
+  if (bytes <= e.peak_bytes) {
+    return;
+  }
+  if (e.loaded) {
+    counters.bytes += bytes - e.peak_bytes;
+  }
+  e.peak_bytes = bytes;
+  evicted = evict(name);
+}
+
+std::size_t ModelRegistry::footprint(const std::string &name) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(name);
+  return it == entries.end() || !it->second.loaded ? 0
+                                                   : it->second.footprint();
+}
+
+bool ModelRegistry::resident(const std::string &name) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(name);
+  return it != entries.end() && it->second.loaded;
+}
+
+ModelRegistryStats ModelRegistry::stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto stats = counters;
+  stats.resident = 0;
+  for (auto &e : entries) {
+    stats.resident += e.second.loaded;
+  }
+  return stats;
+}
+}  // namespace tf_cpp
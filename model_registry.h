@@ -0,0 +1,126 @@
+// Loads models on demand within a memory budget, evicting unused ones.
+
+#ifndef TENSORFLOW_C_MODEL_REGISTRY_H
+#define TENSORFLOW_C_MODEL_REGISTRY_H
+
+#include <cstddef>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "thread_pool.h"
+
+namespace tf_cpp {
+
+struct ModelRegistryOptions {
+  // bound on the estimated footprint of the loaded models.
+  std::size_t memory_budget = std::size_t(1) << 30;
+  // options of every Model the registry loads.
+  ModelOptions model_options;
+  // threads loading prefetched models in the background, 0 disables
+  // prefetching.
+  std::size_t prefetch_threads = 1;
+  // after get(a), prefetch the model most often requested after a.
+  bool predict = true;
+};
+
+struct ModelRegistryStats {
+  // get calls that found the model loaded or loading.
+  std::size_t hits = 0;
+  // models loaded, by get on a miss or by prefetch.
+  std::size_t loads = 0;
+  std::size_t prefetches = 0;
+  std::size_t evictions = 0;
+  std::size_t resident = 0;
+  std::size_t bytes = 0;
+  // time spent loading models, creating their session included.
+  double load_seconds = 0;
+  double max_load_seconds = 0;
+
+  double mean_load_seconds() const {
+    return loads == 0 ? 0 : load_seconds / loads;
+  }
+};
+
+// the models of many tenants, loaded when first requested. the estimated
+// footprint of a model is its GraphDef bytes, the bytes of its variables
+// and the peak bytes reported by observe_peak. while the sum is over the
+// budget the least recently used models are evicted. a Model handed out by
+// get stays alive until its last user drops it, so evicting never breaks
+// a run in flight.
+// thread safe.
+class ModelRegistry {
+ public:
+  explicit ModelRegistry(const ModelRegistryOptions &options = {});
+
+  ModelRegistry(const ModelRegistry &registry) = delete;
+  ModelRegistry &operator=(const ModelRegistry &registry) = delete;
+
+  // register a model by name, it is loaded by the first get.
+  void add(const std::string &name, const std::string &filename);
+
+  // the model, loaded now if it is not loaded yet. callers that ask for a
+  // model while it loads wait for that load.
+  // throws std::runtime_error if name is unknown or the model fails to load.
+  std::shared_ptr<Model> get(const std::string &name);
+
+  // load the model in the background if it is not loaded yet and is not
+  // known to overflow the budget. a prefetched model is the least recently
+  // used until a get asks for it, so it never evicts a model in use.
+  void prefetch(const std::string &name);
+
+  // report the peak bytes a model allocates while running, e.g. measured
+  // under load, so its footprint covers more than the weights.
+  void observe_peak(const std::string &name, std::size_t bytes);
+
+  // the estimated footprint of a loaded model, 0 if it is not loaded.
+  std::size_t footprint(const std::string &name) const;
+  bool resident(const std::string &name) const;
+
+  ModelRegistryStats stats() const;
+
+ private:
+  struct Entry {
+    std::string filename;
+    // valid while the model is loading or loaded.
+    std::shared_future<std::shared_ptr<Model>> model;
+    bool loaded = false;
+    std::size_t graph_bytes = 0;
+    std::size_t variable_bytes = 0;
+    std::size_t peak_bytes = 0;
+    std::list<std::string>::iterator lru_pos;
+    // how often each model was requested right after this one.
+    std::map<std::string, std::size_t> next;
+
+    std::size_t footprint() const {
+      return graph_bytes + variable_bytes + peak_bytes;
+    }
+  };
+
+  // the model of name, loading it on this thread if needed.
+  std::shared_ptr<Model> acquire(const std::string &name, bool prefetching);
+  Entry &entry(const std::string &name);
+  // evict the least recently used loaded models, but keep, while the
+  // footprint is over budget. must be called with mutex held. the evicted
+  // models are returned, to be dropped once mutex is released.
+  std::vector<std::shared_future<std::shared_ptr<Model>>> evict(
+      const std::string &keep);
+
+  ModelRegistryOptions options;
+  mutable std::mutex mutex;
+  std::map<std::string, Entry> entries;
+  // loaded or loading models, most recently used first.
+  std::list<std::string> lru;
+  std::string last_requested;
+  ModelRegistryStats counters;
+  // last member, its destructor finishes the prefetches before the rest
+  // of the registry goes away.
+  ThreadPool prefetch_pool;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_MODEL_REGISTRY_H
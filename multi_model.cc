@@ -0,0 +1,63 @@
+// Several independent models in one graph and one session.
+
+#include "multi_model.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace tf_cpp {
+
+namespace {
+
+std::vector<std::string> Names(const std::vector<ModelFile> &models) {
+  if (models.empty()) {
+    throw std::runtime_error("MultiModel needs at least one model.");
+  }
+  std::vector<std::string> names;
+  for (auto &m : models) {
+    if (m.first.empty()) {
+      throw std::runtime_error("model names can not be empty.");
+    }
+    if (std::find(names.begin(), names.end(), m.first) != names.end()) {
+      throw std::runtime_error("model " + m.first + " is loaded twice.");
+    }
+    names.push_back(m.first);
+  }
+  return names;
+}
+
+// the first model is the Model, the others are imported next to it.
+ModelOptions Options(const std::vector<ModelFile> &models,
+                     ModelOptions options) {
+  if (!options.prefix.empty() || !options.preprocess.empty()) {
+    throw std::runtime_error(
+        "MultiModel sets the prefix and the graphs of its models.");
+  }
+  options.prefix = models.front().first;
+  for (std::size_t i = 1; i != models.size(); ++i) {
+    options.preprocess.push_back({models[i].second, models[i].first, {}});
+  }
+  return options;
+}
+
+}  // namespace
+
+MultiModel::MultiModel(const std::vector<ModelFile> &models,
+                       const ModelOptions &options)
+    : names(Names(models)),
+      model(models.front().second, Options(models, options)) {}
+
+std::string MultiModel::name(const std::string &model,
+                             const std::string &name) const {
+  if (std::find(names.begin(), names.end(), model) == names.end()) {
+    throw std::runtime_error("no model " + model + ".");
+  }
+  return model + "/" + name;
+}
+
+Tensor MultiModel::tensor(const std::string &model, const std::string &name,
+                          const std::vector<int64_t> &shape,
+                          TF_DataType dtype) {
+  return Tensor(get_graph(), this->name(model, name), shape, dtype);
+}
+}  // namespace tf_cpp
@@ -0,0 +1,62 @@
+// Several independent models in one graph and one session.
+
+#ifndef TENSORFLOW_C_MULTI_MODEL_H
+#define TENSORFLOW_C_MULTI_MODEL_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "model.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+// a model name and the GraphDef file it is loaded from.
+using ModelFile = std::pair<std::string, std::string>;
+
+// imports several graphs into one TF_Graph, each under its name as prefix,
+// and runs them in one session. one run fetches the outputs of any number
+// of the models with a single TF_SessionRun, and tensorflow evaluates the
+// independent models in parallel on its inter op pool.
+// the tensors of a model keep their names within it, see tensor and name.
+// run is thread safe as long as every thread uses its own Tensors.
+class MultiModel {
+ public:
+  // e.g. MultiModel({{"ctr", "ctr.pb"}, {"cvr", "cvr.pb"}}).
+  // options apply to the session and to every graph, its prefix and
+  // preprocess must be empty.
+  explicit MultiModel(const std::vector<ModelFile> &models,
+                      const ModelOptions &options = {});
+
+  // the graph name of the tensor name of model, "model/name".
+  // throws std::runtime_error if there is no such model.
+  std::string name(const std::string &model, const std::string &name) const;
+
+  // a Tensor bound to a tensor of model by its name in the model graph.
+  Tensor tensor(const std::string &model, const std::string &name,
+                const std::vector<int64_t> &shape, TF_DataType dtype);
+  Tensor tensor(const std::string &model, const TensorSpec &spec) {
+    return tensor(model, spec.name, spec.shape, spec.dtype);
+  }
+
+  // inputs and outputs of any of the models, in one session run.
+  void run(const std::vector<Tensor *> &inputs,
+           const std::vector<Tensor *> &outputs,
+           const std::vector<TF_Operation *> &operations = {}) {
+    model.run(inputs, outputs, operations);
+  }
+
+  const std::vector<std::string> &models() const { return names; }
+  TF_Graph *get_graph() { return model.get_graph(); }
+  // the Model holding every graph, e.g. for SharedTensor runs.
+  Model &get_model() { return model; }
+
+ private:
+  std::vector<std::string> names;
+  Model model;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_MULTI_MODEL_H
@@ -0,0 +1,356 @@
+// Memory-mapped .npy / .npz datasets, sliced into tensors without copies.
+
+#include "npy_dataset.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace tf_cpp {
+
+namespace {
+
+template <typename T>
+T Load(const char *p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+// the value of key in the python dict literal of a .npy header.
+std::string HeaderValue(const std::string &header, const std::string &key) {
+  auto pos = header.find("'" + key + "'");
+  if (pos == std::string::npos) {
+    throw std::runtime_error("npy header has no " + key + ".");
+  }
+  pos = header.find(':', pos);
+  if (pos == std::string::npos) {
+    throw std::runtime_error("malformed npy header.");
+  }
+  pos = header.find_first_not_of(' ', pos + 1);
+  if (pos == std::string::npos) {
+    throw std::runtime_error("malformed npy header.");
+  }
+  std::size_t end;
+  if (header[pos] == '\'' || header[pos] == '"') {
+    end = header.find(header[pos], pos + 1);
+    ++pos;
+  } else if (header[pos] == '(') {
+    end = header.find(')', pos);
+    ++pos;
+  } else {
+    end = header.find_first_of(",}", pos);
+  }
+  if (end == std::string::npos) {
+    throw std::runtime_error("malformed npy header.");
+  }
+  return header.substr(pos, end - pos);
+}
+
+TF_DataType DescrToDataType(const std::string &descr) {
+  if (descr.size() < 3) {
+    throw std::runtime_error("unsupported npy dtype " + descr + ".");
+  }
+  char order = descr[0];
+  char kind = descr[1];
+  int size = std::atoi(descr.c_str() + 2);
+  if (order == '>' && size > 1) {
+    throw std::runtime_error("big endian npy dtype " + descr +
+                             " is not supported.");
+  }
+  switch (kind) {
+    case 'f':
+      if (size == 2) return TF_HALF;
+      if (size == 4) return TF_FLOAT;
+      if (size == 8) return TF_DOUBLE;
+      break;
+    case 'i':
+      if (size == 1) return TF_INT8;
+      if (size == 2) return TF_INT16;
+      if (size == 4) return TF_INT32;
+      if (size == 8) return TF_INT64;
+      break;
+    case 'u':
+      if (size == 1) return TF_UINT8;
+      if (size == 2) return TF_UINT16;
+      if (size == 4) return TF_UINT32;
+      if (size == 8) return TF_UINT64;
+      break;
+    case 'b':
+      if (size == 1) return TF_BOOL;
+      break;
+    case 'c':
+      if (size == 8) return TF_COMPLEX64;
+      if (size == 16) return TF_COMPLEX128;
+      break;
+  }
+  throw std::runtime_error("unsupported npy dtype " + descr + ".");
+}
+
+}  // namespace
+
+struct NpyDataset::Mapping {
+  char *data = nullptr;
+  std::size_t size = 0;
+
+  ~Mapping() {
+    if (data != nullptr) {
+      munmap(data, size);
+    }
+  }
+};
+
+NpyDataset::NpyDataset(const std::string &filename,
+                       const std::string &array_name)
+    : filename(filename),
+      mapping(std::make_shared<Mapping>()),
+      array_data(nullptr),
+      n_row_bytes(0),
+      tf_type(TF_FLOAT) {
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("can not open " + filename + ".");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 8) {
+    ::close(fd);
+    throw std::runtime_error(filename + " is not a npy or npz file.");
+  }
+  // private writable pages: writing through Tensor::at only touches a copy.
+  void *addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    throw std::runtime_error("can not mmap " + filename + ".");
+  }
+  mapping->data = static_cast<char *>(addr);
+  mapping->size = static_cast<std::size_t>(st.st_size);
+  // datasets are mostly read front to back, possibly larger than memory.
+  madvise(addr, mapping->size, MADV_SEQUENTIAL);
+
+  if (std::memcmp(mapping->data, "\x93NUMPY", 6) == 0) {
+    parse_npy(mapping->data, mapping->size);
+  } else if (std::memcmp(mapping->data, "PK\x03\x04", 4) == 0) {
+    parse_npz(array_name);
+  } else {
+    throw std::runtime_error(filename + " is not a npy or npz file.");
+  }
+}
+
+void NpyDataset::parse_npy(const char *p, std::size_t size) {
+  if (size < 10 || std::memcmp(p, "\x93NUMPY", 6) != 0) {
+    throw std::runtime_error("malformed npy array in " + filename + ".");
+  }
+  std::size_t header_len, header_start;
+  if (p[6] == 1) {
+    header_len = Load<uint16_t>(p + 8);
+    header_start = 10;
+  } else {
+    if (size < 12) {
+      throw std::runtime_error("malformed npy array in " + filename + ".");
+    }
+    header_len = Load<uint32_t>(p + 8);
+    header_start = 12;
+  }
+  if (header_start + header_len > size) {
+    throw std::runtime_error("malformed npy array in " + filename + ".");
+  }
+  std::string header(p + header_start, header_len);
+
+  tf_type = DescrToDataType(HeaderValue(header, "descr"));
+  if (HeaderValue(header, "fortran_order").compare(0, 5, "False") != 0) {
+    throw std::runtime_error("fortran ordered npy arrays are not supported.");
+  }
+  tf_shape.clear();
+  std::string shape = HeaderValue(header, "shape");
+  for (std::size_t pos = 0; pos < shape.size();) {
+    auto end = shape.find(',', pos);
+    if (end == std::string::npos) {
+      end = shape.size();
+    }
+    auto dim = shape.substr(pos, end - pos);
+    if (dim.find_first_of("0123456789") != std::string::npos) {
+      tf_shape.push_back(std::stoll(dim));
+    }
+    pos = end + 1;
+  }
+  if (tf_shape.empty() || tf_shape.size() > MAX_DIMS) {
+    throw std::runtime_error("npy array must have 1 to " +
+                             std::to_string(MAX_DIMS) + " dimensions.");
+  }
+
+  n_row_bytes = TF_DataTypeSize(tf_type);
+  for (std::size_t d = 1; d < tf_shape.size(); ++d) {
+    n_row_bytes *= tf_shape[d];
+  }
+  array_data = p + header_start + header_len;
+  if (n_row_bytes * tf_shape[0] > size - header_start - header_len) {
+    throw std::runtime_error("npy array in " + filename + " is truncated.");
+  }
+}
+
+void NpyDataset::parse_npz(const std::string &array_name) {
+  const char *base = mapping->data;
+  const std::size_t size = mapping->size;
+  auto need = [&](uint64_t offset, uint64_t len) {
+    if (offset > size || len > size - offset) {
+      throw std::runtime_error("malformed npz file " + filename + ".");
+    }
+  };
+
+  // end of central directory record, followed by a comment of <64k.
+  need(0, 22);
+  std::size_t eocd = size - 22;
+  std::size_t lowest = size > 22 + 65535 ? size - 22 - 65535 : 0;
+  while (Load<uint32_t>(base + eocd) != 0x06054b50) {
+    if (eocd == lowest) {
+      throw std::runtime_error("malformed npz file " + filename + ".");
+    }
+    --eocd;
+  }
+  uint64_t n_entries = Load<uint16_t>(base + eocd + 10);
+  uint64_t cd_offset = Load<uint32_t>(base + eocd + 16);
+  if (n_entries == 0xffff || cd_offset == 0xffffffff) {
+    // zip64, written by numpy for large arrays.
+    need(eocd - 20, 20);
+    std::size_t locator = eocd - 20;
+    if (Load<uint32_t>(base + locator) != 0x07064b50) {
+      throw std::runtime_error("malformed npz file " + filename + ".");
+    }
+    uint64_t eocd64 = Load<uint64_t>(base + locator + 8);
+    need(eocd64, 56);
+    if (Load<uint32_t>(base + eocd64) != 0x06064b50) {
+      throw std::runtime_error("malformed npz file " + filename + ".");
+    }
+    n_entries = Load<uint64_t>(base + eocd64 + 32);
+    cd_offset = Load<uint64_t>(base + eocd64 + 48);
+  }
+
+  std::string wanted = array_name + ".npy";
+  uint64_t p = cd_offset;
+  for (uint64_t i = 0; i != n_entries; ++i) {
+    need(p, 46);
+    if (Load<uint32_t>(base + p) != 0x02014b50) {
+      throw std::runtime_error("malformed npz file " + filename + ".");
+    }
+    uint16_t method = Load<uint16_t>(base + p + 10);
+    uint64_t data_size = Load<uint32_t>(base + p + 20);
+    uint64_t raw_size = Load<uint32_t>(base + p + 24);
+    uint16_t name_len = Load<uint16_t>(base + p + 28);
+    uint16_t extra_len = Load<uint16_t>(base + p + 30);
+    uint16_t comment_len = Load<uint16_t>(base + p + 32);
+    uint64_t local = Load<uint32_t>(base + p + 42);
+    need(p + 46, name_len + extra_len);
+    std::string name(base + p + 46, name_len);
+
+    // zip64 extended information overrides the saturated 32 bit fields.
+    const char *extra = base + p + 46 + name_len;
+    for (std::size_t e = 0; e + 4 <= extra_len;) {
+      uint16_t id = Load<uint16_t>(extra + e);
+      uint16_t len = Load<uint16_t>(extra + e + 2);
+      if (id == 1) {
+        const char *field = extra + e + 4;
+        const char *field_end = field + std::min<std::size_t>(len, extra_len - e - 4);
+        if (raw_size == 0xffffffff && field + 8 <= field_end) {
+          raw_size = Load<uint64_t>(field);
+          field += 8;
+        }
+        if (data_size == 0xffffffff && field + 8 <= field_end) {
+          data_size = Load<uint64_t>(field);
+          field += 8;
+        }
+        if (local == 0xffffffff && field + 8 <= field_end) {
+          local = Load<uint64_t>(field);
+        }
+      }
+      e += 4 + len;
+    }
+
+    if (array_name.empty() || name == wanted || name == array_name) {
+      if (method != 0) {
+        throw std::runtime_error(name + " in " + filename +
+                                 " is compressed, save it with np.savez.");
+      }
+      need(local, 30);
+      if (Load<uint32_t>(base + local) != 0x04034b50) {
+        throw std::runtime_error("malformed npz file " + filename + ".");
+      }
+      uint64_t data = local + 30 + Load<uint16_t>(base + local + 26) +
+                      Load<uint16_t>(base + local + 28);
+      need(data, data_size);
+      parse_npy(base + data, data_size);
+      return;
+    }
+    p += 46 + name_len + extra_len + comment_len;
+  }
+  throw std::runtime_error("no array " + array_name + " in " + filename + ".");
+}
+
+bool NpyDataset::zero_copy(int64_t begin) const {
+  auto addr = reinterpret_cast<uintptr_t>(array_data) + begin * n_row_bytes;
+  return addr % 64 == 0;
+}
+
+void NpyDataset::check(Tensor &tensor) const {
+  if (tensor.dtype() != tf_type) {
+    throw std::runtime_error("dataset dtype is incompatible with tensor. [" +
+                             tf_utils::DataTypeToString(tf_type) + " vs. " +
+                             tf_utils::DataTypeToString(tensor.dtype()) +
+                             "].");
+  }
+  auto shape = tensor.shape();
+  bool compatible = shape.size() == tf_shape.size();
+  for (std::size_t d = 1; compatible && d < shape.size(); ++d) {
+    compatible = shape[d] == -1 || shape[d] == tf_shape[d];
+  }
+  if (!compatible) {
+    throw std::runtime_error(
+        "dataset shape is incompatible with tensor shape. [" +
+        to_string(tf_shape) + " vs. " + to_string(shape) + "].");
+  }
+}
+
+void NpyDataset::slice(int64_t begin, int64_t n, Tensor *tensor) const {
+  check(*tensor);
+  if (begin < 0 || begin >= num_rows() || n <= 0) {
+    throw std::runtime_error("slice [" + std::to_string(begin) + ", " +
+                             std::to_string(begin + n) +
+                             ") is out of range of " +
+                             std::to_string(num_rows()) + " rows.");
+  }
+  n = std::min(n, num_rows() - begin);
+  auto dims = tf_shape;
+  dims[0] = n;
+  // every tensor holds a reference on the mapping.
+  auto holder = new std::shared_ptr<Mapping>(mapping);
+  auto tf_tensor = TF_NewTensor(
+      tf_type, dims.data(), static_cast<int>(dims.size()),
+      const_cast<char *>(array_data) + begin * n_row_bytes, n * n_row_bytes,
+      [](void *, std::size_t, void *arg) {
+        delete static_cast<std::shared_ptr<Mapping> *>(arg);
+      },
+      holder);
+  if (tf_tensor == nullptr) {
+    delete holder;
+    throw std::runtime_error("TF_NewTensor error");
+  }
+  tensor->set_tensor(tf_tensor);
+}
+
+void NpyDataset::prefetch(int64_t begin, int64_t n) const {
+  if (begin < 0 || begin >= num_rows() || n <= 0) {
+    return;
+  }
+  n = std::min(n, num_rows() - begin);
+  static const std::size_t page = sysconf(_SC_PAGESIZE);
+  auto start = reinterpret_cast<uintptr_t>(array_data) + begin * n_row_bytes;
+  auto aligned = start / page * page;
+  madvise(reinterpret_cast<void *>(aligned),
+          start - aligned + n * n_row_bytes, MADV_WILLNEED);
+}
+}  // namespace tf_cpp
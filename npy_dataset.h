@@ -0,0 +1,62 @@
+// Memory-mapped .npy / .npz datasets, sliced into tensors without copies.
+
+#ifndef TENSORFLOW_C_NPY_DATASET_H
+#define TENSORFLOW_C_NPY_DATASET_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensor.h"
+
+namespace tf_cpp {
+
+// a C-ordered array of a .npy file, or of one member of a stored
+// (np.savez, not np.savez_compressed) .npz file. the file is mapped, batch
+// slices along the first dimension are handed out as tensors whose data
+// points into the mapping. the mapping lives until the last tensor is gone.
+//
+// tensorflow copies tensor data that is not 64 byte aligned. np.save pads
+// the header to 64 bytes, so slices of .npy files are zero-copy when the
+// slice offset (begin * row_bytes()) is a multiple of 64. members of .npz
+// files are usually not aligned.
+class NpyDataset {
+ public:
+  // array_name selects the member of a .npz file, e.g. "x" for x.npy.
+  explicit NpyDataset(const std::string &filename,
+                      const std::string &array_name = "");
+
+  TF_DataType dtype() const { return tf_type; }
+  const std::vector<int64_t> &shape() const { return tf_shape; }
+  int64_t num_rows() const { return tf_shape[0]; }
+  std::size_t row_bytes() const { return n_row_bytes; }
+  bool zero_copy(int64_t begin) const;
+
+  // throw if dtype or the non-batch dimensions differ from tensor.
+  void check(Tensor &tensor) const;
+
+  // make tensor hold rows [begin, begin + n), n is clipped at the end.
+  void slice(int64_t begin, int64_t n, Tensor *tensor) const;
+
+  // ask the kernel to read rows [begin, begin + n) ahead.
+  void prefetch(int64_t begin, int64_t n) const;
+
+ private:
+  struct Mapping;
+
+  void parse_npy(const char *p, std::size_t size);
+  void parse_npz(const std::string &array_name);
+
+  std::string filename;
+  std::shared_ptr<Mapping> mapping;
+  const char *array_data;
+  std::size_t n_row_bytes;
+  TF_DataType tf_type;
+  std::vector<int64_t> tf_shape;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_NPY_DATASET_H
@@ -0,0 +1,64 @@
+// Partial runs: feed and fetch one execution of a model step by step.
+
+#include "partial_run.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace tf_cpp {
+
+PartialRun::PartialRun(Model &model, const std::vector<Tensor *> &inputs,
+                       const std::vector<Tensor *> &outputs,
+                       const std::vector<TF_Operation *> &operations)
+    : session(model.session), status(TF_NewStatus()), handle(nullptr) {
+  std::vector<TF_Output> io(inputs.size());
+  std::transform(inputs.begin(), inputs.end(), io.begin(),
+                 [](auto i) { return i->tf_op; });
+  std::vector<TF_Output> oo(outputs.size());
+  std::transform(outputs.begin(), outputs.end(), oo.begin(),
+                 [](auto o) { return o->tf_op; });
+  TF_SessionPRunSetup(session, io.data(), static_cast<int>(io.size()),
+                      oo.data(), static_cast<int>(oo.size()),
+                      operations.data(), static_cast<int>(operations.size()),
+                      &handle, status);
+  if (TF_GetCode(status) != TF_OK) {
+    std::string message = TF_Message(status);
+    TF_DeleteStatus(status);
+    throw std::runtime_error("partial run setup error: " + message);
+  }
+}
+
+PartialRun::~PartialRun() {
+  if (handle != nullptr) {
+    TF_DeletePRunHandle(handle);
+  }
+  TF_DeleteStatus(status);
+}
+
+void PartialRun::run(const std::vector<Tensor *> &inputs,
+                     const std::vector<Tensor *> &outputs,
+                     const std::vector<TF_Operation *> &operations) {
+  std::vector<TF_Output> io(inputs.size());
+  std::transform(inputs.begin(), inputs.end(), io.begin(),
+                 [](auto i) { return i->tf_op; });
+  std::vector<TF_Tensor *> iv(inputs.size());
+  std::transform(inputs.begin(), inputs.end(), iv.begin(),
+                 [](auto i) { return i->tf_tensor; });
+  std::vector<TF_Output> oo(outputs.size());
+  std::transform(outputs.begin(), outputs.end(), oo.begin(),
+                 [](auto o) { return o->tf_op; });
+  std::vector<TF_Tensor *> ov(outputs.size());
+  TF_SessionPRun(session, handle, io.data(), iv.data(),
+                 static_cast<int>(io.size()), oo.data(), ov.data(),
+                 static_cast<int>(oo.size()), operations.data(),
+                 static_cast<int>(operations.size()), status);
+  if (TF_GetCode(status) != TF_OK) {
+    throw std::runtime_error(std::string("partial run error: ") +
+                             TF_Message(status));
+  }
+  for (std::size_t i = 0; i != outputs.size(); ++i) {
+    outputs[i]->set_tensor(ov[i]);
+  }
+}
+}  // namespace tf_cpp
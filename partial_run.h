@@ -0,0 +1,48 @@
+// Partial runs: feed and fetch one execution of a model step by step.
+
+#ifndef TENSORFLOW_C_PARTIAL_RUN_H
+#define TENSORFLOW_C_PARTIAL_RUN_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <vector>
+
+#include "model.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+// one execution of a model whose feeds arrive in several steps, see
+// TF_SessionPRunSetup. every tensor the run will ever feed or fetch is
+// declared up front. each call to run then feeds some of the inputs and
+// fetches the outputs they allow. nodes computed by an earlier call are
+// not computed again, e.g. an encoder is evaluated once for several heads
+// whose inputs arrive later.
+// each input is fed and each output is fetched at most once. one PartialRun
+// must not be used by several threads at once. the model must outlive it.
+class PartialRun {
+ public:
+  // throws std::runtime_error if the session rejects the setup.
+  PartialRun(Model &model, const std::vector<Tensor *> &inputs,
+             const std::vector<Tensor *> &outputs,
+             const std::vector<TF_Operation *> &operations = {});
+
+  PartialRun(const PartialRun &run) = delete;
+  PartialRun &operator=(const PartialRun &run) = delete;
+
+  // frees the handle, an unfinished run is abandoned.
+  ~PartialRun();
+
+  // feed inputs and fetch outputs, both subsets of the tensors given to the
+  // constructor, and run operations.
+  void run(const std::vector<Tensor *> &inputs,
+           const std::vector<Tensor *> &outputs,
+           const std::vector<TF_Operation *> &operations = {});
+
+ private:
+  TF_Session *session;
+  TF_Status *status;
+  const char *handle;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_PARTIAL_RUN_H
@@ -0,0 +1,129 @@
+// Caches intermediate tensors so runs that share a prefix skip its subgraph.
+
+#include "prefix_cache.h"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include "hash.h"
+
+namespace tf_cpp {
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+}  // namespace
+
+PrefixCache::PrefixCache(Model &model, const std::vector<TensorSpec> &cached,
+                         std::size_t capacity)
+    : model(model), cached(cached), capacity(capacity) {
+  if (cached.empty()) {
+    throw std::runtime_error("PrefixCache needs a tensor to cache.");
+  }
+  // fail early on names that are not in the graph.
+  for (auto &spec : cached) {
+    Tensor(model.get_graph(), spec);
+  }
+}
+
+void PrefixCache::run(const std::vector<Tensor *> &prefix_inputs,
+                      const std::vector<Tensor *> &inputs,
+                      const std::vector<Tensor *> &outputs) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t key = 0;
+  for (auto i : prefix_inputs) {
+    if (i->tf_tensor == nullptr) {
+      throw std::runtime_error("prefix input is empty.");
+    }
+    key = hash_combine(key, hash_tensor(i->tf_tensor));
+  }
+
+  // the prefix inputs are fed on a hit too, the head may read them.
+  std::vector<TF_Output> io;
+  std::vector<TF_Tensor *> iv;
+  for (auto v : {&prefix_inputs, &inputs}) {
+    for (auto i : *v) {
+      io.push_back(i->tf_op);
+      iv.push_back(i->tf_tensor);
+    }
+  }
+
+  auto values = find(key);
+  if (!values.empty()) {
+    for (auto &v : values) {
+      io.push_back(v.op());
+      iv.push_back(v.get());
+    }
+    model.run_session(io, iv, outputs, {});
+    std::lock_guard<std::mutex> lock(mutex);
+    ++counters.hits;
+    counters.hit_seconds += Seconds(start);
+    return;
+  }
+
+  std::vector<std::unique_ptr<Tensor>> fetched;
+  std::vector<Tensor *> fetches(outputs);
+  for (auto &spec : cached) {
+    fetched.emplace_back(new Tensor(model.get_graph(), spec));
+    fetches.push_back(fetched.back().get());
+  }
+  model.run_session(io, iv, fetches, {});
+  for (auto &t : fetched) {
+    // keeps the operation of the internal tensor, so it is fed in its place.
+    values.emplace_back(std::move(*t));
+  }
+  insert(key, std::move(values));
+  std::lock_guard<std::mutex> lock(mutex);
+  ++counters.misses;
+  counters.miss_seconds += Seconds(start);
+}
+
+std::vector<SharedTensor> PrefixCache::find(uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    return {};
+  }
+  lru.splice(lru.begin(), lru, it->second);
+  return it->second->second;
+}
+
+void PrefixCache::insert(uint64_t key, std::vector<SharedTensor> values) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(key);
+  if (it != entries.end()) {
+    // another thread missed on the same prefix at the same time.
+    lru.splice(lru.begin(), lru, it->second);
+    return;
+  }
+  lru.emplace_front(key, std::move(values));
+  entries[key] = lru.begin();
+  while (lru.size() > capacity) {
+    entries.erase(lru.back().first);
+    lru.pop_back();
+    ++counters.evictions;
+  }
+}
+
+PrefixCacheStats PrefixCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return counters;
+}
+
+std::size_t PrefixCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return lru.size();
+}
+
+void PrefixCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  lru.clear();
+  entries.clear();
+}
+}  // namespace tf_cpp
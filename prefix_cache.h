@@ -0,0 +1,88 @@
+// Caches intermediate tensors so runs that share a prefix skip its subgraph.
+
+#ifndef TENSORFLOW_C_PREFIX_CACHE_H
+#define TENSORFLOW_C_PREFIX_CACHE_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "model.h"
+#include "shared_tensor.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+struct PrefixCacheStats {
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  std::size_t evictions = 0;
+  // wall time spent in runs that hit and in runs that missed.
+  double hit_seconds = 0;
+  double miss_seconds = 0;
+
+  double hit_rate() const {
+    auto runs = hits + misses;
+    return runs == 0 ? 0 : static_cast<double>(hits) / runs;
+  }
+  // compute saved, estimated as hits times the extra time of a miss.
+  double saved_seconds() const {
+    if (hits == 0 || misses == 0) {
+      return 0;
+    }
+    return hits * (miss_seconds / misses - hit_seconds / hits);
+  }
+};
+
+// runs a model whose requests often share a prefix, e.g. the same user
+// features feeding a large tower with a cheap head on top.
+// on a miss the chosen internal tensors are fetched along with the outputs
+// and kept under a hash of the prefix inputs. on a hit they are fed
+// directly, and tensorflow prunes the subgraph that computes them.
+// the cached tensors must depend on nothing but the prefix inputs.
+// run is thread safe as long as every thread uses its own Tensors.
+class PrefixCache {
+ public:
+  // cached are the internal tensors, e.g. {"tower/Relu", TF_FLOAT, {1, 256}}
+  // or "tower/split:1" for another output than 0. at most capacity prefixes
+  // are kept, the least recently used is evicted first.
+  PrefixCache(Model &model, const std::vector<TensorSpec> &cached,
+              std::size_t capacity);
+
+  PrefixCache(const PrefixCache &cache) = delete;
+  PrefixCache &operator=(const PrefixCache &cache) = delete;
+
+  // like Model::run feeding prefix_inputs and inputs.
+  void run(const std::vector<Tensor *> &prefix_inputs,
+           const std::vector<Tensor *> &inputs,
+           const std::vector<Tensor *> &outputs);
+
+  PrefixCacheStats stats() const;
+  std::size_t size() const;
+  void clear();
+
+ private:
+  using Entry = std::pair<uint64_t, std::vector<SharedTensor>>;
+
+  // the cached tensors of key, or an empty vector. marks them recently used.
+  std::vector<SharedTensor> find(uint64_t key);
+  void insert(uint64_t key, std::vector<SharedTensor> values);
+
+  Model &model;
+  std::vector<TensorSpec> cached;
+  std::size_t capacity;
+
+  mutable std::mutex mutex;
+  // most recently used first.
+  std::list<Entry> lru;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> entries;
+  PrefixCacheStats counters;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_PREFIX_CACHE_H
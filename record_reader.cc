@@ -0,0 +1,569 @@
+// TFRecord reading, decoding tf.train.Example records straight into batch
+// tensors.
+
+#include "record_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "simd.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define TF_CPP_CRC32C_SSE42
+#endif
+
+namespace tf_cpp {
+
+namespace {
+
+// record framing: uint64 length, uint32 masked crc of length, data,
+// uint32 masked crc of data.
+constexpr std::size_t kHeaderSize = sizeof(uint64_t) + sizeof(uint32_t);
+constexpr std::size_t kFooterSize = sizeof(uint32_t);
+constexpr std::size_t kMaxFeatures = 64;
+
+struct Crc32cTable {
+  uint32_t t[8][256];
+
+  Crc32cTable() {
+    for (uint32_t i = 0; i != 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k != 8; ++k) {
+        c = (c >> 1) ^ (0x82f63b78u & (0u - (c & 1u)));
+      }
+      t[0][i] = c;
+    }
+    for (uint32_t i = 0; i != 256; ++i) {
+      for (int s = 1; s != 8; ++s) {
+        t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+      }
+    }
+  }
+};
+
+// slicing-by-8, for cpus without the crc32 instruction.
+uint32_t Crc32cSoftware(uint32_t crc, const unsigned char *p, std::size_t n) {
+  static const Crc32cTable table;
+  const auto &t = table.t;
+  while (n >= 8) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    v ^= crc;
+    crc = t[7][v & 0xff] ^ t[6][(v >> 8) & 0xff] ^ t[5][(v >> 16) & 0xff] ^
+          t[4][(v >> 24) & 0xff] ^ t[3][(v >> 32) & 0xff] ^
+          t[2][(v >> 40) & 0xff] ^ t[1][(v >> 48) & 0xff] ^ t[0][v >> 56];
+    p += 8;
+    n -= 8;
+  }
+  while (n-- != 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+  }
+  return crc;
+}
+
+#if defined(TF_CPP_CRC32C_SSE42)
+__attribute__((target("sse4.2"))) uint32_t Crc32cHardware(
+    uint32_t crc, const unsigned char *p, std::size_t n) {
+  uint64_t c = crc;
+  while (n >= 8) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    c = _mm_crc32_u64(c, v);
+    p += 8;
+    n -= 8;
+  }
+  auto c32 = static_cast<uint32_t>(c);
+  while (n-- != 0) {
+    c32 = _mm_crc32_u8(c32, *p++);
+  }
+  return c32;
+}
+#endif
+
+bool ReadVarint(const char *&p, const char *end, uint64_t *value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uint64_t byte = static_cast<unsigned char>(*p++);
+    result |= (byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+// read a length delimited field into [*begin, *stop).
+bool ReadBytes(const char *&p, const char *end, const char **begin,
+               const char **stop) {
+  uint64_t len;
+  if (!ReadVarint(p, end, &len) || len > static_cast<uint64_t>(end - p)) {
+    return false;
+  }
+  *begin = p;
+  p += len;
+  *stop = p;
+  return true;
+}
+
+bool SkipField(const char *&p, const char *end, uint64_t wire_type) {
+  uint64_t value;
+  const char *begin, *stop;
+  switch (wire_type) {
+    case 0:
+      return ReadVarint(p, end, &value);
+    case 1:
+      if (end - p < 8) return false;
+      p += 8;
+      return true;
+    case 2:
+      return ReadBytes(p, end, &begin, &stop);
+    case 5:
+      if (end - p < 4) return false;
+      p += 4;
+      return true;
+    default:
+      return false;
+  }
+}
+
+void Malformed() {
+  throw std::runtime_error("malformed tf.train.Example record.");
+}
+
+// decode a FloatList or Int64List message into dst, returns the value count.
+int64_t DecodeList(const char *p, const char *end, TF_DataType dtype,
+                   const std::string &name, int64_t size, char *dst) {
+  int64_t count = 0;
+  auto check_count = [&](int64_t n) {
+    if (count + n > size) {
+      throw std::runtime_error("feature " + name + " has more than " +
+                               std::to_string(size) + " values.");
+    }
+  };
+  while (p < end) {
+    uint64_t tag;
+    if (!ReadVarint(p, end, &tag)) Malformed();
+    if ((tag >> 3) != 1) {
+      if (!SkipField(p, end, tag & 7)) Malformed();
+      continue;
+    }
+    if (dtype == TF_FLOAT) {
+      auto out = reinterpret_cast<float *>(dst);
+      if ((tag & 7) == 2) {
+        const char *begin, *stop;
+        if (!ReadBytes(p, end, &begin, &stop) || (stop - begin) % 4 != 0) {
+          Malformed();
+        }
+        int64_t n = (stop - begin) / 4;
+        check_count(n);
+        std::memcpy(out + count, begin, stop - begin);
+        count += n;
+      } else if ((tag & 7) == 5) {
+        if (end - p < 4) Malformed();
+        check_count(1);
+        std::memcpy(out + count, p, 4);
+        p += 4;
+        count += 1;
+      } else {
+        Malformed();
+      }
+    } else {
+      auto out = reinterpret_cast<int64_t *>(dst);
+      uint64_t value;
+      if ((tag & 7) == 2) {
+        const char *begin, *stop;
+        if (!ReadBytes(p, end, &begin, &stop)) Malformed();
+        while (begin < stop) {
+          if (!ReadVarint(begin, stop, &value)) Malformed();
+          check_count(1);
+          out[count++] = static_cast<int64_t>(value);
+        }
+      } else if ((tag & 7) == 0) {
+        if (!ReadVarint(p, end, &value)) Malformed();
+        check_count(1);
+        out[count++] = static_cast<int64_t>(value);
+      } else {
+        Malformed();
+      }
+    }
+  }
+  return count;
+}
+
+// decode a Feature message, the oneof must match the spec's dtype.
+void DecodeFeature(const char *p, const char *end, const FeatureSpec &spec,
+                   char *dst) {
+  const uint64_t expected = spec.dtype == TF_FLOAT ? 2 : 3;
+  int64_t count = 0;
+  while (p < end) {
+    uint64_t tag;
+    if (!ReadVarint(p, end, &tag)) Malformed();
+    uint64_t field = tag >> 3;
+    if (field < 1 || field > 3) {
+      if (!SkipField(p, end, tag & 7)) Malformed();
+      continue;
+    }
+    if (field != expected) {
+      throw std::runtime_error("feature " + spec.name +
+                               " has a different type than " +
+                               tf_utils::DataTypeToString(spec.dtype) + ".");
+    }
+    const char *begin, *stop;
+    if ((tag & 7) != 2 || !ReadBytes(p, end, &begin, &stop)) Malformed();
+    count = DecodeList(begin, stop, spec.dtype, spec.name, spec.size, dst);
+  }
+  if (count != spec.size) {
+    throw std::runtime_error("feature " + spec.name + " has " +
+                             std::to_string(count) + " values, expected " +
+                             std::to_string(spec.size) + ".");
+  }
+}
+
+// decode an Example message, feature j is written to rows[j].
+void DecodeExample(const char *p, std::size_t n,
+                   const std::vector<FeatureSpec> &schema, char *const *rows) {
+  const char *end = p + n;
+  uint64_t found = 0;
+  while (p < end) {
+    uint64_t tag;
+    if (!ReadVarint(p, end, &tag)) Malformed();
+    if (tag != ((1 << 3) | 2)) {
+      if (!SkipField(p, end, tag & 7)) Malformed();
+      continue;
+    }
+    // Features message.
+    const char *features, *features_end;
+    if (!ReadBytes(p, end, &features, &features_end)) Malformed();
+    while (features < features_end) {
+      if (!ReadVarint(features, features_end, &tag)) Malformed();
+      if (tag != ((1 << 3) | 2)) {
+        if (!SkipField(features, features_end, tag & 7)) Malformed();
+        continue;
+      }
+      // map<string, Feature> entry.
+      const char *entry, *entry_end;
+      if (!ReadBytes(features, features_end, &entry, &entry_end)) Malformed();
+      const char *key = nullptr, *key_end = nullptr;
+      const char *value = nullptr, *value_end = nullptr;
+      while (entry < entry_end) {
+        if (!ReadVarint(entry, entry_end, &tag)) Malformed();
+        if (tag == ((1 << 3) | 2)) {
+          if (!ReadBytes(entry, entry_end, &key, &key_end)) Malformed();
+        } else if (tag == ((2 << 3) | 2)) {
+          if (!ReadBytes(entry, entry_end, &value, &value_end)) Malformed();
+        } else if (!SkipField(entry, entry_end, tag & 7)) {
+          Malformed();
+        }
+      }
+      if (key == nullptr || value == nullptr) {
+        continue;
+      }
+      std::size_t key_len = key_end - key;
+      for (std::size_t j = 0; j != schema.size(); ++j) {
+        if (schema[j].name.size() == key_len &&
+            std::memcmp(schema[j].name.data(), key, key_len) == 0) {
+          DecodeFeature(value, value_end, schema[j], rows[j]);
+          found |= uint64_t(1) << j;
+          break;
+        }
+      }
+    }
+  }
+  for (std::size_t j = 0; j != schema.size(); ++j) {
+    if ((found & (uint64_t(1) << j)) == 0) {
+      throw std::runtime_error("record has no feature " + schema[j].name +
+                               ".");
+    }
+  }
+}
+
+}  // namespace
+
+uint32_t crc32c(const char *data, std::size_t n) {
+  auto p = reinterpret_cast<const unsigned char *>(data);
+#if defined(TF_CPP_CRC32C_SSE42)
+  // every cpu above kScalar has sse4.2, the scalar level uses the tables.
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  if (has_sse42 && simd_level() != SimdLevel::kScalar) {
+    return ~Crc32cHardware(~0u, p, n);
+  }
+#endif
+  return ~Crc32cSoftware(~0u, p, n);
+}
+
+uint32_t masked_crc32c(const char *data, std::size_t n) {
+  uint32_t crc = crc32c(data, n);
+  return ((crc >> 15) | (crc << 17)) + 0xa282ead8u;
+}
+
+RecordWriter::RecordWriter(const std::string &filename)
+    : file(filename, std::ios::out | std::ios::binary) {
+  if (file.fail() || !file.is_open()) {
+    throw std::runtime_error("can not open " + filename + " for writing.");
+  }
+}
+
+void RecordWriter::write(const char *data, std::size_t n) {
+  char header[kHeaderSize];
+  uint64_t len = n;
+  std::memcpy(header, &len, sizeof(len));
+  uint32_t len_crc = masked_crc32c(header, sizeof(len));
+  std::memcpy(header + sizeof(len), &len_crc, sizeof(len_crc));
+  uint32_t data_crc = masked_crc32c(data, n);
+  file.write(header, kHeaderSize);
+  file.write(data, n);
+  file.write(reinterpret_cast<const char *>(&data_crc), kFooterSize);
+  if (file.fail()) {
+    throw std::runtime_error("RecordWriter write error.");
+  }
+}
+
+void RecordWriter::close() { file.close(); }
+
+struct RecordReader::MappedFile {
+  std::string filename;
+  const char *data = nullptr;
+  std::size_t size = 0;
+  std::size_t offset = 0;
+
+  ~MappedFile() {
+    if (data != nullptr) {
+      munmap(const_cast<char *>(data), size);
+    }
+  }
+};
+
+RecordReader::RecordReader(const std::vector<std::string> &filenames,
+                           const std::vector<FeatureSpec> &schema,
+                           const RecordReaderOptions &options)
+    : filenames(filenames),
+      schema(schema),
+      options(options),
+      rng(options.seed),
+      next_file(0),
+      cycle_pos(0),
+      n_records(0),
+      n_bytes(0) {
+  if (schema.empty() || schema.size() > kMaxFeatures) {
+    throw std::runtime_error("RecordReader supports 1 to " +
+                             std::to_string(kMaxFeatures) + " features.");
+  }
+  for (auto &spec : schema) {
+    if (spec.dtype != TF_FLOAT && spec.dtype != TF_INT64) {
+      throw std::runtime_error("feature " + spec.name + " has dtype " +
+                               tf_utils::DataTypeToString(spec.dtype) +
+                               ", only TF_FLOAT and TF_INT64 are supported.");
+    }
+    if (spec.size <= 0) {
+      throw std::runtime_error("feature " + spec.name +
+                               " must have a positive size.");
+    }
+  }
+  this->options.cycle_length = std::max<std::size_t>(options.cycle_length, 1);
+  this->options.shuffle_buffer =
+      std::max<std::size_t>(options.shuffle_buffer, 1);
+  std::size_t num_threads = options.num_threads;
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  pool.reset(new ThreadPool(num_threads - 1));
+  reset();
+}
+
+RecordReader::~RecordReader() = default;
+
+void RecordReader::reset() {
+  file_order.resize(filenames.size());
+  std::iota(file_order.begin(), file_order.end(), 0);
+  if (options.shuffle) {
+    std::shuffle(file_order.begin(), file_order.end(), rng);
+  }
+  next_file = 0;
+  cycle_pos = 0;
+  active.clear();
+  shuffle_buffer.clear();
+}
+
+std::shared_ptr<RecordReader::MappedFile> RecordReader::open_file(
+    const std::string &filename) {
+  auto file = std::make_shared<MappedFile>();
+  file->filename = filename;
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("can not open " + filename + ".");
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("can not stat " + filename + ".");
+  }
+  file->size = static_cast<std::size_t>(st.st_size);
+  if (file->size > 0) {
+    void *addr = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("can not mmap " + filename + ".");
+    }
+    madvise(addr, file->size, MADV_SEQUENTIAL);
+    file->data = static_cast<const char *>(addr);
+  }
+  ::close(fd);
+  return file;
+}
+
+bool RecordReader::read_record(MappedFile &file, Record *record) {
+  if (file.offset == file.size) {
+    return false;
+  }
+  const char *p = file.data + file.offset;
+  std::size_t left = file.size - file.offset;
+  if (left < kHeaderSize + kFooterSize) {
+    throw std::runtime_error("truncated record in " + file.filename + ".");
+  }
+  uint64_t len;
+  uint32_t len_crc;
+  std::memcpy(&len, p, sizeof(len));
+  std::memcpy(&len_crc, p + sizeof(len), sizeof(len_crc));
+  if (masked_crc32c(p, sizeof(len)) != len_crc) {
+    throw std::runtime_error("corrupted record length in " + file.filename +
+                             ".");
+  }
+  if (len > left - kHeaderSize - kFooterSize) {
+    throw std::runtime_error("truncated record in " + file.filename + ".");
+  }
+  record->data = p + kHeaderSize;
+  record->size = static_cast<std::size_t>(len);
+  file.offset += kHeaderSize + len + kFooterSize;
+  return true;
+}
+
+bool RecordReader::next_interleaved(Record *record) {
+  while (true) {
+    while (active.size() < options.cycle_length &&
+           next_file < file_order.size()) {
+      active.push_back(open_file(filenames[file_order[next_file++]]));
+    }
+    if (active.empty()) {
+      return false;
+    }
+    if (cycle_pos >= active.size()) {
+      cycle_pos = 0;
+    }
+    if (read_record(*active[cycle_pos], record)) {
+      record->file = active[cycle_pos];
+      ++cycle_pos;
+      return true;
+    }
+    // the mapping lives on while records of it are buffered.
+    active.erase(active.begin() + cycle_pos);
+  }
+}
+
+bool RecordReader::next_record(Record *record) {
+  if (!options.shuffle) {
+    return next_interleaved(record);
+  }
+  while (shuffle_buffer.size() < options.shuffle_buffer) {
+    Record r;
+    if (!next_interleaved(&r)) {
+      break;
+    }
+    shuffle_buffer.push_back(std::move(r));
+  }
+  if (shuffle_buffer.empty()) {
+    return false;
+  }
+  std::uniform_int_distribution<std::size_t> pick(0,
+                                                  shuffle_buffer.size() - 1);
+  std::swap(shuffle_buffer[pick(rng)], shuffle_buffer.back());
+  *record = std::move(shuffle_buffer.back());
+  shuffle_buffer.pop_back();
+  return true;
+}
+
+std::size_t RecordReader::next_batch(const std::vector<Tensor *> &batch) {
+  if (batch.size() != schema.size()) {
+    throw std::runtime_error("batch has " + std::to_string(batch.size()) +
+                             " tensors, schema has " +
+                             std::to_string(schema.size()) + " features.");
+  }
+  int64_t batch_size = -1;
+  std::vector<char *> base(schema.size());
+  std::vector<std::size_t> row_bytes(schema.size());
+  for (std::size_t j = 0; j != schema.size(); ++j) {
+    auto shape = batch[j]->shape();
+    if (shape.empty()) {
+      throw std::runtime_error("batch tensor of feature " + schema[j].name +
+                               " has no batch dimension.");
+    }
+    int64_t row_size = 1;
+    for (std::size_t d = 1; d < shape.size(); ++d) {
+      row_size *= shape[d];
+    }
+    if (row_size != schema[j].size) {
+      throw std::runtime_error("batch tensor of feature " + schema[j].name +
+                               " has rows of " + std::to_string(row_size) +
+                               " values, expected " +
+                               std::to_string(schema[j].size) + ".");
+    }
+    if (batch_size != -1 && shape[0] != batch_size) {
+      throw std::runtime_error("batch tensors have different batch sizes.");
+    }
+    batch_size = shape[0];
+    if (schema[j].dtype == TF_FLOAT) {
+      base[j] = reinterpret_cast<char *>(batch[j]->data<float>());
+    } else {
+      base[j] = reinterpret_cast<char *>(batch[j]->data<int64_t>());
+    }
+    row_bytes[j] = schema[j].size * TF_DataTypeSize(schema[j].dtype);
+  }
+
+  pending.clear();
+  Record record;
+  while (static_cast<int64_t>(pending.size()) < batch_size &&
+         next_record(&record)) {
+    pending.push_back(std::move(record));
+  }
+
+  pool->parallel_for(
+      0, pending.size(),
+      [&](std::size_t begin, std::size_t end) {
+        char *rows[kMaxFeatures];
+        for (std::size_t i = begin; i != end; ++i) {
+          auto &r = pending[i];
+          if (options.verify_crc) {
+            uint32_t data_crc;
+            std::memcpy(&data_crc, r.data + r.size, sizeof(data_crc));
+            if (masked_crc32c(r.data, r.size) != data_crc) {
+              throw std::runtime_error("corrupted record data in " +
+                                       r.file->filename + ".");
+            }
+          }
+          for (std::size_t j = 0; j != schema.size(); ++j) {
+            rows[j] = base[j] + i * row_bytes[j];
+          }
+          DecodeExample(r.data, r.size, schema, rows);
+        }
+      },
+      16);
+
+  std::size_t n = pending.size();
+  n_records += n;
+  for (auto &r : pending) {
+    n_bytes += r.size;
+  }
+  // drop the references to finished files.
+  pending.clear();
+  return n;
+}
+}  // namespace tf_cpp
@@ -0,0 +1,122 @@
+// TFRecord reading, decoding tf.train.Example records straight into batch
+// tensors.
+
+#ifndef TENSORFLOW_C_RECORD_READER_H
+#define TENSORFLOW_C_RECORD_READER_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tensor.h"
+#include "thread_pool.h"
+
+namespace tf_cpp {
+
+// crc32c (Castagnoli) as used by TFRecord files. it uses the sse4.2 crc32
+// instruction unless simd_level() is kScalar.
+uint32_t crc32c(const char *data, std::size_t n);
+// the masked crc stored in TFRecord files.
+uint32_t masked_crc32c(const char *data, std::size_t n);
+
+// a fixed length feature of a tf.train.Example.
+// it is decoded into one row of a [batch, ...] tensor, the product of the
+// non-batch dimensions must equal size.
+// TF_FLOAT reads a float_list, TF_INT64 reads an int64_list.
+struct FeatureSpec {
+  std::string name;
+  TF_DataType dtype;
+  int64_t size;
+};
+
+struct RecordReaderOptions {
+  // check the crc of every record's data. the length crc is always checked.
+  bool verify_crc = false;
+  // shuffle the file order every epoch, and the records through a buffer of
+  // shuffle_buffer records.
+  bool shuffle = false;
+  std::size_t shuffle_buffer = 1024;
+  // number of files read round-robin at the same time.
+  std::size_t cycle_length = 1;
+  // number of decoding threads, including the calling thread.
+  // 0 means one per core.
+  std::size_t num_threads = 0;
+  unsigned int seed = 0;
+};
+
+class RecordWriter {
+ public:
+  explicit RecordWriter(const std::string &filename);
+
+  void write(const char *data, std::size_t n);
+  void write(const std::string &record) { write(record.data(), record.size()); }
+  void close();
+
+ private:
+  std::ofstream file;
+};
+
+// reads TFRecord files through mmap. records are framed on the calling
+// thread and decoded by a pool of threads into the batch tensors, so the
+// record bytes are never copied before landing in the tensor buffers.
+class RecordReader {
+ public:
+  RecordReader(const std::vector<std::string> &filenames,
+               const std::vector<FeatureSpec> &schema,
+               const RecordReaderOptions &options = RecordReaderOptions());
+
+  RecordReader(const RecordReader &reader) = delete;
+  RecordReader &operator=(const RecordReader &reader) = delete;
+
+  ~RecordReader();
+
+  // decode the next records into batch, one tensor per FeatureSpec.
+  // the first dimension of the tensors is the batch size.
+  // returns the number of decoded records, which is smaller than the batch
+  // size at the end of the epoch and 0 after it. rows after the returned
+  // count are left untouched.
+  std::size_t next_batch(const std::vector<Tensor *> &batch);
+
+  // start a new epoch.
+  void reset();
+
+  std::size_t records_read() const { return n_records; }
+  std::size_t bytes_read() const { return n_bytes; }
+
+ private:
+  struct MappedFile;
+  struct Record {
+    const char *data;
+    std::size_t size;
+    std::shared_ptr<MappedFile> file;
+  };
+
+  bool next_record(Record *record);
+  bool next_interleaved(Record *record);
+  bool read_record(MappedFile &file, Record *record);
+  std::shared_ptr<MappedFile> open_file(const std::string &filename);
+
+  std::vector<std::string> filenames;
+  std::vector<FeatureSpec> schema;
+  RecordReaderOptions options;
+  std::unique_ptr<ThreadPool> pool;
+  std::mt19937 rng;
+
+  std::vector<std::size_t> file_order;
+  std::size_t next_file;
+  std::vector<std::shared_ptr<MappedFile>> active;
+  std::size_t cycle_pos;
+  std::vector<Record> shuffle_buffer;
+  std::vector<Record> pending;
+
+  std::size_t n_records;
+  std::size_t n_bytes;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_RECORD_READER_H
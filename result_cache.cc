@@ -0,0 +1,238 @@
+// Memoizes model results by a hash of the inputs, for repeated requests.
+
+#include "result_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "hash.h"
+
+namespace tf_cpp {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// counters per shard of the frequency sketch.
+constexpr std::size_t kSketchWidth = 4096;
+constexpr std::size_t kSketchRows = 4;
+constexpr uint8_t kMaxCount = 15;
+
+// approximate request counts of recently seen keys, a count-min sketch.
+// the counts are halved every 10 * width requests, so keys that were
+// popular long ago lose against the current ones.
+class FrequencySketch {
+ public:
+  FrequencySketch() : counters(kSketchRows * kSketchWidth), samples(0) {}
+
+  void add(uint64_t key) {
+    for (std::size_t row = 0; row != kSketchRows; ++row) {
+      auto &c = counters[Index(key, row)];
+      if (c < kMaxCount) {
+        ++c;
+      }
+    }
+    if (++samples == 10 * kSketchWidth) {
+      for (auto &c : counters) {
+        c >>= 1;
+      }
+      samples /= 2;
+    }
+  }
+
+  int estimate(uint64_t key) const {
+    int count = kMaxCount;
+    for (std::size_t row = 0; row != kSketchRows; ++row) {
+      count = std::min<int>(count, counters[Index(key, row)]);
+    }
+    return count;
+  }
+
+ private:
+  static std::size_t Index(uint64_t key, std::size_t row) {
+    return row * kSketchWidth +
+           (hash_combine(key, row) & (kSketchWidth - 1));
+  }
+
+  std::vector<uint8_t> counters;
+  std::size_t samples;
+};
+
+uint64_t HashOutput(uint64_t seed, const TF_Output &op) {
+  seed = hash_combine(seed, reinterpret_cast<uintptr_t>(op.oper));
+  return hash_combine(seed, op.index);
+}
+
+}  // namespace
+
+struct ResultCache::Shard {
+  struct Entry {
+    uint64_t key;
+    std::vector<SharedTensor> results;
+    std::size_t bytes;
+    Clock::time_point expires;
+  };
+
+  void erase(std::list<Entry>::iterator it) {
+    bytes -= it->bytes;
+    index.erase(it->key);
+    lru.erase(it);
+  }
+
+  std::mutex mutex;
+  // most recently used first.
+  std::list<Entry> lru;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+  FrequencySketch sketch;
+  std::size_t bytes = 0;
+  ResultCacheStats counters;
+};
+
+ResultCache::ResultCache(const ResultCacheOptions &options)
+    : options(options) {
+  if (options.shards == 0) {
+    throw std::runtime_error("ResultCache needs at least one shard.");
+  }
+  for (std::size_t i = 0; i != options.shards; ++i) {
+    shards.emplace_back(new Shard);
+  }
+}
+
+ResultCache::~ResultCache() = default;
+
+uint64_t ResultCache::request_key(const Model &model,
+                                  const std::vector<Tensor *> &inputs,
+                                  const std::vector<Tensor *> &outputs) {
+  uint64_t key = hash_combine(model.get_id(), inputs.size());
+  key = hash_combine(key, outputs.size());
+  for (auto i : inputs) {
+    if (i->tf_tensor == nullptr) {
+      throw std::runtime_error("can not hash an empty input.");
+    }
+    key = HashOutput(key, i->tf_op);
+    key = hash_tensor(i->tf_tensor, key);
+  }
+  for (auto o : outputs) {
+    key = HashOutput(key, o->tf_op);
+  }
+  return key;
+}
+
+std::vector<SharedTensor> ResultCache::run(
+    Model &model, const std::vector<Tensor *> &inputs,
+    const std::vector<Tensor *> &outputs) {
+  auto key = request_key(model, inputs, outputs);
+  std::vector<SharedTensor> results;
+  if (lookup(key, results)) {
+    return results;
+  }
+  model.run(inputs, outputs);
+  results.reserve(outputs.size());
+  for (auto o : outputs) {
+    results.emplace_back(std::move(*o));
+  }
+  insert(key, results);
+  return results;
+}
+
+ResultCache::Shard &ResultCache::shard(uint64_t key) const {
+  // the high bits, the sketch indexes with the low ones.
+  return *shards[(key >> 40) % shards.size()];
+}
+
+bool ResultCache::lookup(uint64_t key, std::vector<SharedTensor> &results) {
+  auto &s = shard(key);
+  std::lock_guard<std::mutex> lock(s.mutex);
+  s.sketch.add(key);
+  auto it = s.index.find(key);
+  if (it == s.index.end()) {
+    ++s.counters.misses;
+    return false;
+  }
+  if (options.ttl.count() != 0 && Clock::now() >= it->second->expires) {
+    s.erase(it->second);
+    ++s.counters.expirations;
+    ++s.counters.misses;
+    return false;
+  }
+  s.lru.splice(s.lru.begin(), s.lru, it->second);
+  results = it->second->results;
+  ++s.counters.hits;
+  return true;
+}
+
+void ResultCache::insert(uint64_t key,
+                         const std::vector<SharedTensor> &results) {
+  std::size_t bytes = sizeof(Shard::Entry);
+  for (auto &r : results) {
+    bytes += TF_TensorByteSize(r.get());
+  }
+  const std::size_t budget = options.max_bytes / shards.size();
+  auto &s = shard(key);
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (bytes > budget) {
+    ++s.counters.rejections;
+    return;
+  }
+  auto it = s.index.find(key);
+  if (it != s.index.end()) {
+    // another thread ran the same request at the same time.
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    return;
+  }
+  auto now = Clock::now();
+  auto expired = [&](const Shard::Entry &e) {
+    return options.ttl.count() != 0 && now >= e.expires;
+  };
+  // find every victim before erasing any, so a candidate that a later
+  // victim keeps out does not cost the cache the victims before it.
+  auto victims = s.lru.end();
+  std::size_t freed = 0;
+  while (s.bytes - freed + bytes > budget) {
+    --victims;
+    if (!expired(*victims) && options.admission &&
+        s.sketch.estimate(key) <= s.sketch.estimate(victims->key)) {
+      ++s.counters.rejections;
+      return;
+    }
+    freed += victims->bytes;
+  }
+  while (victims != s.lru.end()) {
+    auto victim = victims++;
+    ++(expired(*victim) ? s.counters.expirations : s.counters.evictions);
+    s.erase(victim);
+  }
+  s.lru.push_front({key, results, bytes, now + options.ttl});
+  s.index[key] = s.lru.begin();
+  s.bytes += bytes;
+}
+
+ResultCacheStats ResultCache::stats() const {
+  ResultCacheStats total;
+  for (auto &s : shards) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    total.hits += s->counters.hits;
+    total.misses += s->counters.misses;
+    total.evictions += s->counters.evictions;
+    total.expirations += s->counters.expirations;
+    total.rejections += s->counters.rejections;
+    total.entries += s->lru.size();
+    total.bytes += s->bytes;
+  }
+  return total;
+}
+
+void ResultCache::clear() {
+  for (auto &s : shards) {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    s->lru.clear();
+    s->index.clear();
+    s->bytes = 0;
+  }
+}
+}  // namespace tf_cpp
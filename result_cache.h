@@ -0,0 +1,93 @@
+// Memoizes model results by a hash of the inputs, for repeated requests.
+
+#ifndef TENSORFLOW_C_RESULT_CACHE_H
+#define TENSORFLOW_C_RESULT_CACHE_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "model.h"
+#include "shared_tensor.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+struct ResultCacheOptions {
+  // bound on the bytes of the cached output buffers, split over the shards.
+  std::size_t max_bytes = 256 << 20;
+  // independent locks, several threads rarely wait for each other.
+  std::size_t shards = 16;
+  // entries older than ttl are dropped, zero keeps them until evicted.
+  std::chrono::milliseconds ttl{0};
+  // admit a new entry into a full shard only if its key was requested more
+  // often than the least recently used entry it would evict (TinyLFU).
+  // one off requests then do not flush the popular ones.
+  bool admission = true;
+};
+
+struct ResultCacheStats {
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  std::size_t evictions = 0;
+  std::size_t expirations = 0;
+  // new entries turned away by the admission policy.
+  std::size_t rejections = 0;
+  std::size_t entries = 0;
+  std::size_t bytes = 0;
+
+  double hit_rate() const {
+    auto lookups = hits + misses;
+    return lookups == 0 ? 0 : static_cast<double>(hits) / lookups;
+  }
+};
+
+// an LRU cache of output buffers keyed by a 64 bit hash of the inputs.
+// a hit hands out the cached buffers as SharedTensors without entering
+// TF_SessionRun; they are read only, mutable_data copies them first.
+// the hash covers the model, the operations, dtypes, shapes and bytes of
+// the inputs and the operations of the outputs. two different requests with the same
+// hash, about one in 2^64, would share a result.
+// thread safe. the model must be deterministic for the cache to be exact.
+class ResultCache {
+ public:
+  explicit ResultCache(const ResultCacheOptions &options = {});
+  ~ResultCache();
+
+  ResultCache(const ResultCache &cache) = delete;
+  ResultCache &operator=(const ResultCache &cache) = delete;
+
+  // the results of model.run(inputs, outputs), from the cache or from a run
+  // whose results are then cached. outputs only name the tensors to fetch,
+  // after a run they are left empty.
+  std::vector<SharedTensor> run(Model &model,
+                                const std::vector<Tensor *> &inputs,
+                                const std::vector<Tensor *> &outputs);
+
+  // the key run uses for a request to model. the id of model is part of it,
+  // a model loaded later at the same addresses does not get these results.
+  static uint64_t request_key(const Model &model,
+                              const std::vector<Tensor *> &inputs,
+                              const std::vector<Tensor *> &outputs);
+
+  // the cached results of key, counting a hit or a miss.
+  bool lookup(uint64_t key, std::vector<SharedTensor> &results);
+  // cache results under key, if they fit and are admitted.
+  void insert(uint64_t key, const std::vector<SharedTensor> &results);
+
+  ResultCacheStats stats() const;
+  void clear();
+
+ private:
+  struct Shard;
+  Shard &shard(uint64_t key) const;
+
+  ResultCacheOptions options;
+  std::vector<std::unique_ptr<Shard>> shards;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_RESULT_CACHE_H
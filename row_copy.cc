@@ -0,0 +1,109 @@
+// Batch assembly: copy request rows into and out of one batch buffer.
+
+#include "row_copy.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "simd.h"
+#include "thread_pool.h"
+
+#if defined(TF_CPP_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace tf_cpp {
+
+namespace {
+
+constexpr std::size_t kMinParallelBytes = 1 << 20;
+constexpr std::size_t kStreamingRowBytes = 1 << 20;
+// rows are split in chunks of this size, so a few huge rows still spread
+// over the pool.
+constexpr std::size_t kChunkBytes = 256 << 10;
+
+void Memcpy(void *dst, const void *src, std::size_t n) {
+  std::memcpy(dst, src, n);
+}
+
+// copy n_rows rows from src(i) to dst(i), split in chunks of kChunkBytes.
+template <typename Src, typename Dst>
+void CopyRows(std::size_t n_rows, std::size_t row_bytes, Src src, Dst dst) {
+  auto copy = row_bytes >= kStreamingRowBytes ? stream_copy : Memcpy;
+  const std::size_t chunks_per_row =
+      (row_bytes + kChunkBytes - 1) / kChunkBytes;
+  const std::size_t chunk = std::min(row_bytes, kChunkBytes);
+  auto fn = [&](std::size_t first, std::size_t last) {
+    for (std::size_t k = first; k != last; ++k) {
+      std::size_t i = k / chunks_per_row;
+      std::size_t offset = k % chunks_per_row * chunk;
+      copy(static_cast<char *>(dst(i)) + offset,
+           static_cast<const char *>(src(i)) + offset,
+           std::min(chunk, row_bytes - offset));
+    }
+  };
+  const std::size_t units = n_rows * chunks_per_row;
+  if (n_rows * row_bytes < kMinParallelBytes) {
+    fn(0, units);
+    return;
+  }
+  // small rows are grouped so every task copies about kChunkBytes.
+  ThreadPool::default_pool().parallel_for(
+      0, units, fn, std::max<std::size_t>(1, kChunkBytes / row_bytes));
+}
+
+}  // namespace
+
+void stream_copy(void *dst, const void *src, std::size_t n) {
+#if defined(TF_CPP_X86_SIMD)
+  auto d = static_cast<char *>(dst);
+  auto s = static_cast<const char *>(src);
+  // align the destination, streaming stores need 16 byte alignment.
+  std::size_t head = (16 - reinterpret_cast<uintptr_t>(d) % 16) % 16;
+  head = std::min(head, n);
+  std::memcpy(d, s, head);
+  d += head;
+  s += head;
+  n -= head;
+  std::size_t body = n - n % 64;
+  for (std::size_t i = 0; i != body; i += 64) {
+    auto p = reinterpret_cast<const __m128i *>(s + i);
+    auto q = reinterpret_cast<__m128i *>(d + i);
+    __m128i v0 = _mm_loadu_si128(p);
+    __m128i v1 = _mm_loadu_si128(p + 1);
+    __m128i v2 = _mm_loadu_si128(p + 2);
+    __m128i v3 = _mm_loadu_si128(p + 3);
+    _mm_stream_si128(q, v0);
+    _mm_stream_si128(q + 1, v1);
+    _mm_stream_si128(q + 2, v2);
+    _mm_stream_si128(q + 3, v3);
+  }
+  // make the streamed data visible before the session reads it.
+  _mm_sfence();
+  std::memcpy(d + body, s + body, n - body);
+#else
+  std::memcpy(dst, src, n);
+#endif
+}
+
+void gather_rows(const void *const *rows, std::size_t n_rows,
+                 std::size_t row_bytes, void *batch) {
+  CopyRows(
+      n_rows, row_bytes, [&](std::size_t i) { return rows[i]; },
+      [&](std::size_t i) {
+        return static_cast<void *>(static_cast<char *>(batch) + i * row_bytes);
+      });
+}
+
+void scatter_rows(const void *batch, std::size_t n_rows,
+                  std::size_t row_bytes, void *const *rows) {
+  CopyRows(
+      n_rows, row_bytes,
+      [&](std::size_t i) {
+        return static_cast<const void *>(static_cast<const char *>(batch) +
+                                         i * row_bytes);
+      },
+      [&](std::size_t i) { return rows[i]; });
+}
+}  // namespace tf_cpp
@@ -0,0 +1,24 @@
+// Batch assembly: copy request rows into and out of one batch buffer.
+
+#ifndef TENSORFLOW_C_ROW_COPY_H
+#define TENSORFLOW_C_ROW_COPY_H
+
+#include <cstddef>
+
+namespace tf_cpp {
+
+// copy rows[i], row_bytes each, to batch + i * row_bytes for i < n_rows.
+// from 1MB in total the copy is split over ThreadPool::default_pool().
+// rows of 1MB or more are written with non-temporal stores, so a huge
+// batch does not flush the caches the session is about to use.
+void gather_rows(const void *const *rows, std::size_t n_rows,
+                 std::size_t row_bytes, void *batch);
+
+// the inverse of gather_rows, copy batch + i * row_bytes to rows[i].
+void scatter_rows(const void *batch, std::size_t n_rows,
+                  std::size_t row_bytes, void *const *rows);
+
+// memcpy with non-temporal stores, falls back to memcpy off x86.
+void stream_copy(void *dst, const void *src, std::size_t n);
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_ROW_COPY_H
@@ -0,0 +1,56 @@
+// Read only views of tensor rows that share ownership of the TF_Tensor.
+
+#ifndef TENSORFLOW_C_ROW_VIEW_H
+#define TENSORFLOW_C_ROW_VIEW_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tf_cpp {
+
+// take ownership of tensor, TF_DeleteTensor runs when the last owner dies.
+// the reference count is atomic, owners may live on different threads.
+inline std::shared_ptr<TF_Tensor> share_tensor(TF_Tensor *tensor) {
+  return std::shared_ptr<TF_Tensor>(tensor, TF_DeleteTensor);
+}
+
+// size() elements of type T inside a shared TF_Tensor, e.g. the result of
+// one request in a batched output. the view keeps the tensor alive, so it
+// can be handed to another thread or outlive the Tensor it came from.
+template <typename T>
+class RowView {
+ public:
+  RowView() : ptr(nullptr), n(0) {}
+  RowView(std::shared_ptr<TF_Tensor> tensor, const T *data, std::size_t size)
+      : tensor(std::move(tensor)), ptr(data), n(size) {}
+
+  const T *data() const { return ptr; }
+  std::size_t size() const { return n; }
+  bool empty() const { return n == 0; }
+  const T *begin() const { return ptr; }
+  const T *end() const { return ptr + n; }
+  const T &operator[](std::size_t i) const { return ptr[i]; }
+  const T &at(std::size_t i) const {
+    if (i >= n) {
+      throw std::runtime_error("index " + std::to_string(i) +
+                               " is out of range of a row of " +
+                               std::to_string(n) + ".");
+    }
+    return ptr[i];
+  }
+
+  std::vector<T> to_vector() const { return {ptr, ptr + n}; }
+
+ private:
+  std::shared_ptr<TF_Tensor> tensor;
+  const T *ptr;
+  std::size_t n;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_ROW_VIEW_H
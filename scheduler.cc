@@ -0,0 +1,114 @@
+// Runs requests on a Model by priority class and deadline.
+
+#include "scheduler.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace tf_cpp {
+
+Scheduler::Scheduler(const SchedulerOptions &options)
+    : queues(std::max<std::size_t>(options.classes, 1)),
+      counters(queues.size()) {
+  for (std::size_t i = 0; i < std::max<std::size_t>(options.workers, 1); ++i) {
+    workers.emplace_back([this]() { worker_loop(); });
+  }
+}
+
+Scheduler::~Scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  cv.notify_all();
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+
+std::future<void> Scheduler::submit(Model &model,
+                                    const std::vector<Tensor *> &inputs,
+                                    const std::vector<Tensor *> &outputs,
+                                    std::size_t priority,
+                                    Clock::time_point deadline) {
+  if (priority >= queues.size()) {
+    throw std::runtime_error("no priority class " + std::to_string(priority) +
+                             ".");
+  }
+  Request request{&model, inputs, outputs, {}};
+  auto result = request.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queues[priority].emplace(std::make_pair(deadline, arrivals++),
+                             std::move(request));
+  }
+  cv.notify_one();
+  return result;
+}
+
+void Scheduler::worker_loop() {
+  while (true) {
+    Queue::node_type node;
+    std::size_t priority = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      auto waiting = [this]() {
+        return std::find_if(queues.begin(), queues.end(), [](auto &q) {
+          return !q.empty();
+        });
+      };
+      cv.wait(lock, [&]() { return stopping || waiting() != queues.end(); });
+      auto queue = waiting();
+      if (queue == queues.end()) {
+        return;
+      }
+      priority = queue - queues.begin();
+      node = queue->extract(queue->begin());
+    }
+
+    auto deadline = node.key().first;
+    auto &request = node.mapped();
+    auto now = Clock::now();
+    if (deadline <= now) {
+      // counted first, a caller that returns from get sees it in stats.
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++counters[priority].dropped;
+      }
+      request.done.set_exception(std::make_exception_ptr(
+          DeadlineExceeded("deadline exceeded before the run.")));
+      continue;
+    }
+    // the time left, rounded up, as the timeout of the run.
+    std::int64_t timeout_in_ms = 0;
+    if (deadline != Clock::time_point::max()) {
+      timeout_in_ms =
+          std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+    }
+    std::exception_ptr error;
+    try {
+      request.model->run_with_timeout(request.inputs, request.outputs,
+                                      timeout_in_ms);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++counters[priority].runs;
+      counters[priority].timed_out += error && Clock::now() >= deadline;
+    }
+    if (error) {
+      request.done.set_exception(error);
+    } else {
+      request.done.set_value();
+    }
+  }
+}
+
+SchedulerStats Scheduler::stats(std::size_t priority) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto stats = counters.at(priority);
+  stats.queued = queues[priority].size();
+  return stats;
+}
+}  // namespace tf_cpp
@@ -0,0 +1,106 @@
+// Runs requests on a Model by priority class and deadline.
+
+#ifndef TENSORFLOW_C_SCHEDULER_H
+#define TENSORFLOW_C_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "model.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+// the error of a request dropped because its deadline passed before it ran.
+class DeadlineExceeded : public std::runtime_error {
+ public:
+  explicit DeadlineExceeded(const std::string &what)
+      : std::runtime_error(what) {}
+};
+
+struct SchedulerOptions {
+  // session runs at a time.
+  std::size_t workers = 1;
+  // priority classes, 0 is the highest.
+  std::size_t classes = 2;
+};
+
+struct SchedulerStats {
+  std::size_t runs = 0;
+  // dropped before their run since the deadline had passed.
+  std::size_t dropped = 0;
+  // runs tensorflow cancelled at the deadline.
+  std::size_t timed_out = 0;
+  std::size_t queued = 0;
+};
+
+// a queue in front of Model::run. a free worker takes the request of the
+// highest priority class that waits, and within a class the one with the
+// earliest deadline, requests without deadline last and in order of
+// arrival. a request whose deadline has passed is dropped without a run,
+// otherwise it runs with the time left as RunOptions timeout_in_ms, so a
+// run past its deadline is cancelled instead of holding a worker.
+// thread safe.
+class Scheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit Scheduler(const SchedulerOptions &options = {});
+
+  Scheduler(const Scheduler &scheduler) = delete;
+  Scheduler &operator=(const Scheduler &scheduler) = delete;
+
+  // runs the requests still queued before it returns.
+  ~Scheduler();
+
+  // queue model.run(inputs, outputs). the future throws DeadlineExceeded if
+  // the request was dropped, or the error of the run. the Tensors must
+  // stay alive until the future is ready.
+  // throws std::runtime_error if priority is not a class.
+  std::future<void> submit(
+      Model &model, const std::vector<Tensor *> &inputs,
+      const std::vector<Tensor *> &outputs, std::size_t priority,
+      Clock::time_point deadline = Clock::time_point::max());
+
+  // submit and wait.
+  void run(Model &model, const std::vector<Tensor *> &inputs,
+           const std::vector<Tensor *> &outputs, std::size_t priority,
+           Clock::time_point deadline = Clock::time_point::max()) {
+    submit(model, inputs, outputs, priority, deadline).get();
+  }
+
+  SchedulerStats stats(std::size_t priority) const;
+
+ private:
+  struct Request {
+    Model *model;
+    std::vector<Tensor *> inputs;
+    std::vector<Tensor *> outputs;
+    std::promise<void> done;
+  };
+
+  // ordered by deadline, then by arrival.
+  using Queue = std::map<std::pair<Clock::time_point, std::uint64_t>, Request>;
+
+  void worker_loop();
+
+  mutable std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<Queue> queues;
+  std::vector<SchedulerStats> counters;
+  std::uint64_t arrivals = 0;
+  bool stopping = false;
+  std::vector<std::thread> workers;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_SCHEDULER_H
@@ -0,0 +1,74 @@
+// Immutable, reference counted tensor handles with copy on write.
+
+#include "shared_tensor.h"
+
+namespace tf_cpp {
+
+SharedTensor::SharedTensor(Tensor &&tensor)
+    : tf_op(tensor.tf_op), tf_type(tensor.tf_type) {
+  if (tensor.tf_tensor == nullptr) {
+    throw std::runtime_error("can not share an empty tensor.");
+  }
+  this->tensor = share_tensor(tensor.tf_tensor);
+  tensor.tf_tensor = nullptr;
+}
+
+std::vector<int64_t> SharedTensor::shape() const {
+  std::vector<int64_t> dims;
+  if (tensor != nullptr) {
+    for (int i = 0; i != TF_NumDims(tensor.get()); ++i) {
+      dims.push_back(TF_Dim(tensor.get(), i));
+    }
+  }
+  return dims;
+}
+
+std::size_t SharedTensor::num_elements() const {
+  return tensor == nullptr ? 0 : TF_TensorElementCount(tensor.get());
+}
+
+SharedTensor SharedTensor::bind(const Tensor &input) const {
+  if (tensor == nullptr) {
+    throw std::runtime_error("can not bind an empty SharedTensor.");
+  }
+  if (input.tf_type != tf_type) {
+    throw std::runtime_error("dtype is incompatible with the input. [" +
+                             tf_utils::DataTypeToString(tf_type) + " vs. " +
+                             tf_utils::DataTypeToString(input.tf_type) + "].");
+  }
+  if (input.tf_shape != shape()) {
+    throw std::runtime_error("shape is incompatible with the input. [" +
+                             to_string(shape()) + " vs. " +
+                             to_string(input.tf_shape) + "].");
+  }
+  SharedTensor bound(*this);
+  bound.tf_op = input.tf_op;
+  return bound;
+}
+
+void SharedTensor::detach() {
+  if (tensor == nullptr) {
+    throw std::runtime_error("can not write to an empty SharedTensor.");
+  }
+  // only this handle can make new references to a buffer it owns alone,
+  // so a count of 1 can not change under us.
+  if (tensor.use_count() > 1) {
+    auto copy = tf_utils::CopyTensor(tensor.get());
+    if (copy == nullptr) {
+      throw std::runtime_error("tf_utils::CopyTensor error");
+    }
+    tensor = share_tensor(copy);
+  }
+}
+
+void SharedTensor::check_type(TF_DataType type) const {
+  if (tensor == nullptr) {
+    throw std::runtime_error("can not access an empty SharedTensor.");
+  }
+  if (type != tf_type) {
+    throw std::runtime_error(
+        "can not access tf_tensor in this type. tf_tensor type is " +
+        tf_utils::DataTypeToString(tf_type) + ".");
+  }
+}
+}  // namespace tf_cpp
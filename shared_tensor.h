@@ -0,0 +1,89 @@
+// Immutable, reference counted tensor handles with copy on write.
+
+#ifndef TENSORFLOW_C_SHARED_TENSOR_H
+#define TENSORFLOW_C_SHARED_TENSOR_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "row_view.h"
+#include "tensor.h"
+#include "tf_utils.h"
+
+namespace tf_cpp {
+
+// a TF_Tensor shared by any number of handles, e.g. one output fanned out
+// to several consumers, or fed back to the next Model::run.
+// copying a handle only bumps an atomic reference count. mutable_data
+// copies the buffer first if other handles (or RowViews) share it, so a
+// holder never sees the writes of another one.
+// a handle also remembers the graph operation it is fed to, see bind.
+class SharedTensor {
+ public:
+  SharedTensor() : tf_op{nullptr, 0}, tf_type(TF_FLOAT) {}
+  // take the TF_Tensor of tensor, which is left empty and can be the
+  // output of the next run, e.g. SharedTensor(std::move(output)).
+  explicit SharedTensor(Tensor &&tensor);
+
+  explicit operator bool() const { return tensor != nullptr; }
+  long use_count() const { return tensor.use_count(); }
+
+  TF_DataType dtype() const { return tf_type; }
+  std::vector<int64_t> shape() const;
+  std::size_t num_elements() const;
+
+  // read only access, no copies.
+  template <typename T>
+  const T *data() const {
+    check_type(Tensor::deduce_type<T>());
+    return static_cast<const T *>(TF_TensorData(tensor.get()));
+  }
+
+  // write access, copies the buffer if it is shared.
+  template <typename T>
+  T *mutable_data() {
+    check_type(Tensor::deduce_type<T>());
+    detach();
+    return static_cast<T *>(TF_TensorData(tensor.get()));
+  }
+
+  // views of the rows of the first dimension, sharing the buffer.
+  template <typename T>
+  std::vector<RowView<T>> rows() const {
+    const T *base = data<T>();
+    auto dims = shape();
+    std::size_t n_rows = dims.empty() ? 1 : dims[0];
+    std::size_t row_size = n_rows == 0 ? 0 : num_elements() / n_rows;
+    std::vector<RowView<T>> views;
+    views.reserve(n_rows);
+    for (std::size_t i = 0; i != n_rows; ++i) {
+      views.emplace_back(tensor, base + i * row_size, row_size);
+    }
+    return views;
+  }
+
+  // a handle on the same buffer that Model::run feeds to the operation of
+  // input, e.g. to feed an output of the last run to the next one.
+  // throws if the dtype or shape does not match input.
+  SharedTensor bind(const Tensor &input) const;
+
+  // make the buffer unique to this handle, copying it if needed.
+  void detach();
+
+  TF_Tensor *get() const { return tensor.get(); }
+  const TF_Output &op() const { return tf_op; }
+
+ private:
+  void check_type(TF_DataType type) const;
+
+  std::shared_ptr<TF_Tensor> tensor;
+  TF_Output tf_op;
+  TF_DataType tf_type;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_SHARED_TENSOR_H
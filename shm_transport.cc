@@ -0,0 +1,505 @@
+// Passes tensors between processes of one host through shared memory.
+
+#include "shm_transport.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include "tf_utils.h"
+
+namespace tf_cpp {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x74667368;
+constexpr std::size_t kMaxTensors = 16;
+constexpr std::size_t kErrorBytes = 256;
+constexpr std::size_t kPage = 4096;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "the slot handoff needs lock free atomics");
+
+// a slot goes kFree -> kWriting (client) -> kReady -> kRunning (server)
+// -> kDone -> kFree (client).
+enum SlotState : uint32_t { kFree, kWriting, kReady, kRunning, kDone };
+
+std::size_t RoundUp(std::size_t n, std::size_t to) {
+  return (n + to - 1) / to * to;
+}
+
+// the futex calls work on the 32 bit word inside the atomic.
+uint32_t *Word(std::atomic<uint32_t> &a) {
+  return reinterpret_cast<uint32_t *>(&a);
+}
+
+void FutexWait(std::atomic<uint32_t> &a, uint32_t value) {
+  // a timeout, so a side that died does not leave the other asleep forever.
+  timespec timeout = {0, 100 * 1000 * 1000};
+  syscall(SYS_futex, Word(a), FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32_t> &a, int n) {
+  syscall(SYS_futex, Word(a), FUTEX_WAKE, n, nullptr, nullptr, 0);
+}
+
+// a tensor in a slot, its buffer at offset from the start of the slot.
+struct ShmTensor {
+  uint32_t dtype;
+  uint32_t n_dims;
+  int64_t dims[MAX_DIMS];
+  uint64_t offset;
+  uint64_t bytes;
+};
+
+struct alignas(64) ShmSlot {
+  std::atomic<uint32_t> state;
+  uint32_t n_inputs;
+  uint32_t n_outputs;
+  // 0, or 1 with the message in error.
+  uint32_t status;
+  ShmTensor inputs[kMaxTensors];
+  ShmTensor outputs[kMaxTensors];
+  char error[kErrorBytes];
+};
+
+// waiters sleep until seq moves. a notifier only makes the futex call if
+// someone may be asleep.
+struct ShmEvent {
+  std::atomic<uint32_t> seq;
+  std::atomic<uint32_t> waiters;
+
+  void notify(int n) {
+    ++seq;
+    if (waiters.load() != 0) {
+      FutexWake(seq, n);
+    }
+  }
+};
+
+// the bytes of the buffer of t in size, false if a dimension is negative,
+// if the dtype has no fixed size, e.g. TF_STRING, or if they are more than
+// limit.
+bool ByteSize(const ShmTensor &t, uint64_t limit, uint64_t &size) {
+  size = TF_DataTypeSize(static_cast<TF_DataType>(t.dtype));
+  if (size == 0) {
+    return false;
+  }
+  bool empty = false;
+  for (uint32_t i = 0; i != t.n_dims; ++i) {
+    if (t.dims[i] < 0) {
+      return false;
+    }
+    empty |= t.dims[i] == 0;
+  }
+  if (empty) {
+    size = 0;
+    return true;
+  }
+  for (uint32_t i = 0; i != t.n_dims; ++i) {
+    if (static_cast<uint64_t>(t.dims[i]) > limit / size) {
+      return false;
+    }
+    size *= t.dims[i];
+  }
+  return size <= limit;
+}
+
+// false if the graph tensor of spec can not take t. a spec without
+// dimensions may be of unknown rank, the session checks those.
+bool Accepts(const TensorSpec &spec, const ShmTensor &t) {
+  if (spec.dtype != static_cast<TF_DataType>(t.dtype)) {
+    return false;
+  }
+  if (spec.shape.empty()) {
+    return true;
+  }
+  if (spec.shape.size() != t.n_dims) {
+    return false;
+  }
+  for (uint32_t i = 0; i != t.n_dims; ++i) {
+    if (spec.shape[i] != -1 && spec.shape[i] != t.dims[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void NoDeallocate(void *, std::size_t, void *) {}
+
+}  // namespace
+
+// the shared memory object: this header, the slot headers, then the data
+// of every slot, page aligned.
+struct alignas(64) ShmRing {
+  uint32_t magic;
+  uint32_t slots;
+  uint64_t slot_bytes;
+  uint64_t data_offset;
+  // slots that became ready, the server sleeps on it.
+  ShmEvent ready;
+  // slots that became free, clients waiting for a slot sleep on it.
+  ShmEvent released;
+
+  ShmSlot &slot(std::size_t i) {
+    return reinterpret_cast<ShmSlot *>(this + 1)[i];
+  }
+  uint8_t *data(std::size_t i) {
+    return reinterpret_cast<uint8_t *>(this) + data_offset + i * slot_bytes;
+  }
+};
+
+ShmServer::ShmServer(Model &model, const ShmServerOptions &options)
+    : model(model), options(options) {
+  for (auto &name : options.inputs) {
+    input_specs.push_back(graph_spec(model.get_graph(), name));
+  }
+  for (auto &name : options.outputs) {
+    output_specs.push_back(graph_spec(model.get_graph(), name));
+  }
+  for (auto specs : {&input_specs, &output_specs}) {
+    for (auto &spec : *specs) {
+      if (TF_DataTypeSize(spec.dtype) == 0) {
+        throw std::runtime_error(spec.name + " of type " +
+                                 tf_utils::DataTypeToString(spec.dtype) +
+                                 " can not be passed through a slot.");
+      }
+    }
+  }
+  if (options.inputs.size() > kMaxTensors ||
+      options.outputs.size() > kMaxTensors || options.slots == 0) {
+    throw std::runtime_error("at most " + std::to_string(kMaxTensors) +
+                             " inputs and outputs and at least one slot.");
+  }
+  std::size_t slot_bytes = RoundUp(options.slot_bytes, kPage);
+  std::size_t data_offset =
+      RoundUp(sizeof(ShmRing) + options.slots * sizeof(ShmSlot), kPage);
+  mapped_bytes = data_offset + options.slots * slot_bytes;
+
+  shm_unlink(options.name.c_str());
+  int fd = shm_open(options.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0 || ftruncate(fd, mapped_bytes) != 0) {
+    auto error = std::string(std::strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+      shm_unlink(options.name.c_str());
+    }
+    throw std::runtime_error("can not create " + options.name + ": " + error);
+  }
+  void *p = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    shm_unlink(options.name.c_str());
+    throw std::runtime_error("can not map " + options.name + ": " +
+                             std::strerror(errno));
+  }
+  ring = new (p) ShmRing();
+  ring->slots = static_cast<uint32_t>(options.slots);
+  ring->slot_bytes = slot_bytes;
+  ring->data_offset = data_offset;
+  for (std::size_t i = 0; i != options.slots; ++i) {
+    new (&ring->slot(i)) ShmSlot();
+  }
+  // clients check the magic last.
+  std::atomic_thread_fence(std::memory_order_release);
+  ring->magic = kMagic;
+}
+
+ShmServer::~ShmServer() {
+  munmap(ring, mapped_bytes);
+  shm_unlink(options.name.c_str());
+}
+
+void ShmServer::serve() {
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < options.workers; ++i) {
+    threads.emplace_back([this]() { worker_loop(); });
+  }
+  worker_loop();
+  for (auto &t : threads) {
+    t.join();
+  }
+}
+
+void ShmServer::stop() {
+  stopping = true;
+  ring->ready.notify(INT_MAX);
+}
+
+void ShmServer::worker_loop() {
+  std::vector<Tensor> inputs, outputs;
+  for (auto &spec : input_specs) {
+    inputs.emplace_back(model.get_graph(), spec);
+  }
+  for (auto &spec : output_specs) {
+    outputs.emplace_back(model.get_graph(), spec);
+  }
+  std::size_t start = 0;
+  while (!stopping) {
+    // announce the wait before looking, a client that marks a slot ready
+    // after the look sees the waiter and wakes it.
+    ++ring->ready.waiters;
+    uint32_t seq = ring->ready.seq.load();
+    std::size_t claimed = options.slots;
+    for (std::size_t k = 0; k != options.slots; ++k) {
+      std::size_t i = (start + k) % options.slots;
+      uint32_t expected = kReady;
+      if (ring->slot(i).state.compare_exchange_strong(expected, kRunning)) {
+        claimed = i;
+        break;
+      }
+    }
+    if (claimed == options.slots) {
+      FutexWait(ring->ready.seq, seq);
+      --ring->ready.waiters;
+      continue;
+    }
+    --ring->ready.waiters;
+    start = claimed + 1;
+    auto &slot = ring->slot(claimed);
+    ++requests;
+    errors += !handle(claimed, inputs, outputs);
+    slot.state = kDone;
+    FutexWake(slot.state, 1);
+  }
+}
+
+bool ShmServer::handle(std::size_t i, std::vector<Tensor> &inputs,
+                       std::vector<Tensor> &outputs) {
+  auto &slot = ring->slot(i);
+  auto data = ring->data(i);
+  slot.n_outputs = 0;
+  try {
+    if (slot.n_inputs != inputs.size()) {
+      throw std::runtime_error("expected " + std::to_string(inputs.size()) +
+                               " inputs.");
+    }
+    std::size_t used = 0;
+    for (std::size_t k = 0; k != inputs.size(); ++k) {
+      // a copy, the client could change the slot while it is checked.
+      ShmTensor t = slot.inputs[k];
+      uint64_t bytes;
+      if (t.n_dims > MAX_DIMS || !Accepts(input_specs[k], t) ||
+          t.offset % 64 != 0 || t.offset > ring->slot_bytes ||
+          t.bytes > ring->slot_bytes - t.offset ||
+          !ByteSize(t, ring->slot_bytes, bytes) || t.bytes != bytes) {
+        throw std::runtime_error("malformed input " + std::to_string(k) + ".");
+      }
+      // the session reads the input where the client wrote it.
+      inputs[k].set_tensor(TF_NewTensor(static_cast<TF_DataType>(t.dtype),
+                                        t.dims, t.n_dims, data + t.offset,
+                                        t.bytes, NoDeallocate, nullptr));
+      used = std::max<std::size_t>(used, t.offset + t.bytes);
+    }
+    std::vector<Tensor *> in, out;
+    for (auto &t : inputs) {
+      in.push_back(&t);
+    }
+    for (auto &t : outputs) {
+      out.push_back(&t);
+    }
+    model.run(in, out);
+
+    for (std::size_t k = 0; k != outputs.size(); ++k) {
+      auto tensor = outputs[k].tf_tensor;
+      auto &t = slot.outputs[k];
+      if (tensor == nullptr || TF_DataTypeSize(TF_TensorType(tensor)) == 0) {
+        throw std::runtime_error("output " + options.outputs[k] +
+                                 " can not be sent.");
+      }
+      t.dtype = TF_TensorType(tensor);
+      t.n_dims = TF_NumDims(tensor);
+      for (uint32_t d = 0; d != t.n_dims; ++d) {
+        t.dims[d] = TF_Dim(tensor, d);
+      }
+      t.offset = RoundUp(used, 64);
+      t.bytes = TF_TensorByteSize(tensor);
+      if (t.offset + t.bytes > ring->slot_bytes) {
+        throw std::runtime_error("outputs do not fit in a slot of " +
+                                 std::to_string(ring->slot_bytes) + " bytes.");
+      }
+      std::memcpy(data + t.offset, TF_TensorData(tensor), t.bytes);
+      used = t.offset + t.bytes;
+    }
+    slot.n_outputs = static_cast<uint32_t>(outputs.size());
+    slot.status = 0;
+  } catch (const std::exception &e) {
+    slot.status = 1;
+    std::strncpy(slot.error, e.what(), kErrorBytes - 1);
+    slot.error[kErrorBytes - 1] = '\0';
+  }
+  // no tensor may point into the slot once the client has it back.
+  for (auto &t : inputs) {
+    t.set_tensor(nullptr);
+  }
+  for (auto &t : outputs) {
+    t.set_tensor(nullptr);
+  }
+  return slot.status == 0;
+}
+
+ShmServerStats ShmServer::stats() const {
+  ShmServerStats stats;
+  stats.requests = requests;
+  stats.errors = errors;
+  return stats;
+}
+
+ShmClient::ShmClient(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    auto error = std::string(std::strerror(errno));
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw std::runtime_error("can not open " + name + ": " + error);
+  }
+  mapped_bytes = st.st_size;
+  void *p = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    throw std::runtime_error("can not map " + name + ": " +
+                             std::strerror(errno));
+  }
+  ring = static_cast<ShmRing *>(p);
+  if (mapped_bytes < sizeof(ShmRing) || ring->magic != kMagic) {
+    munmap(p, mapped_bytes);
+    throw std::runtime_error(name + " is not served by a ShmServer.");
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+ShmClient::~ShmClient() { munmap(ring, mapped_bytes); }
+
+ShmClient::Request ShmClient::request() {
+  std::size_t start = next_slot++;
+  while (true) {
+    ++ring->released.waiters;
+    uint32_t seq = ring->released.seq.load();
+    for (std::size_t k = 0; k != ring->slots; ++k) {
+      std::size_t i = (start + k) % ring->slots;
+      auto &slot = ring->slot(i);
+      uint32_t expected = kFree;
+      if (slot.state.compare_exchange_strong(expected, kWriting)) {
+        --ring->released.waiters;
+        slot.n_inputs = 0;
+        slot.n_outputs = 0;
+        slot.status = 0;
+        return Request(this, i);
+      }
+    }
+    FutexWait(ring->released.seq, seq);
+    --ring->released.waiters;
+  }
+}
+
+std::vector<WireTensor> ShmClient::run(const std::vector<WireTensor> &inputs) {
+  auto r = request();
+  for (auto &t : inputs) {
+    std::memcpy(r.input(t.dtype, t.shape), t.data.data(), t.data.size());
+  }
+  r.run();
+  std::vector<WireTensor> outputs(r.outputs());
+  for (std::size_t i = 0; i != outputs.size(); ++i) {
+    outputs[i].dtype = r.output_dtype(i);
+    outputs[i].shape = r.output_shape(i);
+    auto data = static_cast<const uint8_t *>(r.output_data(i));
+    outputs[i].data.assign(data, data + r.output_bytes(i));
+  }
+  return outputs;
+}
+
+ShmClient::Request::Request(Request &&request) noexcept
+    : client(request.client), slot(request.slot), used(request.used) {
+  request.client = nullptr;
+}
+
+ShmClient::Request::~Request() {
+  if (client != nullptr) {
+    client->ring->slot(slot).state = kFree;
+    client->ring->released.notify(1);
+  }
+}
+
+void *ShmClient::Request::input(TF_DataType dtype,
+                                const std::vector<int64_t> &shape) {
+  auto &s = client->ring->slot(slot);
+  if (s.n_inputs == kMaxTensors || shape.size() > MAX_DIMS) {
+    throw std::runtime_error("too many inputs or dimensions.");
+  }
+  auto &t = s.inputs[s.n_inputs];
+  t.dtype = dtype;
+  t.n_dims = static_cast<uint32_t>(shape.size());
+  std::copy(shape.begin(), shape.end(), t.dims);
+  t.offset = RoundUp(used, 64);
+  if (TF_DataTypeSize(dtype) == 0 ||
+      std::any_of(shape.begin(), shape.end(),
+                  [](int64_t d) { return d < 0; })) {
+    throw std::runtime_error("an input of type " +
+                             tf_utils::DataTypeToString(dtype) +
+                             " and shape " + to_string(shape) +
+                             " can not be passed through a slot.");
+  }
+  uint64_t bytes;
+  if (t.offset > client->ring->slot_bytes ||
+      !ByteSize(t, client->ring->slot_bytes - t.offset, bytes)) {
+    throw std::runtime_error("inputs do not fit in a slot of " +
+                             std::to_string(client->ring->slot_bytes) +
+                             " bytes.");
+  }
+  t.bytes = bytes;
+  ++s.n_inputs;
+  used = t.offset + t.bytes;
+  return client->ring->data(slot) + t.offset;
+}
+
+void ShmClient::Request::run() {
+  auto &s = client->ring->slot(slot);
+  s.state = kReady;
+  client->ring->ready.notify(1);
+  uint32_t state;
+  while ((state = s.state.load()) != kDone) {
+    FutexWait(s.state, state);
+  }
+  if (s.status != 0) {
+    throw std::runtime_error(s.error);
+  }
+}
+
+std::size_t ShmClient::Request::outputs() const {
+  return client->ring->slot(slot).n_outputs;
+}
+
+TF_DataType ShmClient::Request::output_dtype(std::size_t i) const {
+  return static_cast<TF_DataType>(client->ring->slot(slot).outputs[i].dtype);
+}
+
+std::vector<int64_t> ShmClient::Request::output_shape(std::size_t i) const {
+  auto &t = client->ring->slot(slot).outputs[i];
+  return std::vector<int64_t>(t.dims, t.dims + t.n_dims);
+}
+
+const void *ShmClient::Request::output_data(std::size_t i) const {
+  return client->ring->data(slot) + client->ring->slot(slot).outputs[i].offset;
+}
+
+std::size_t ShmClient::Request::output_bytes(std::size_t i) const {
+  return client->ring->slot(slot).outputs[i].bytes;
+}
+}  // namespace tf_cpp
@@ -0,0 +1,150 @@
+// Passes tensors between processes of one host through shared memory.
+
+#ifndef TENSORFLOW_C_SHM_TRANSPORT_H
+#define TENSORFLOW_C_SHM_TRANSPORT_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "inference_server.h"
+#include "model.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+// the layout of the shared memory object, see shm_transport.cc.
+struct ShmRing;
+
+struct ShmServerOptions {
+  // the name of the shared memory object, e.g. "/tf_cpp_ring".
+  std::string name;
+  // requests in flight at a time, over all clients.
+  std::size_t slots = 8;
+  // the bytes of the inputs plus the outputs of one request.
+  std::size_t slot_bytes = std::size_t(64) << 20;
+  // the names of the tensors a request feeds, in order.
+  std::vector<std::string> inputs;
+  // the names of the tensors a response returns, in order.
+  std::vector<std::string> outputs;
+  // session runs at a time.
+  std::size_t workers = 2;
+};
+
+struct ShmServerStats {
+  std::size_t requests = 0;
+  // requests whose run failed, or whose outputs did not fit in the slot.
+  std::size_t errors = 0;
+};
+
+// serves model through a ring of slots in a shared memory object, for
+// clients on the same host that move tensors too big to copy through a
+// socket. a client writes the inputs into a free slot and marks it ready,
+// the server feeds them to the session in place, wrapped by TF_NewTensor
+// without a copy, and writes the outputs back into the slot.
+// slots change hands by compare and swap on their state word, no lock is
+// taken on either side. a side with nothing to do sleeps on a futex.
+class ShmServer {
+ public:
+  // creates the shared memory object, replacing a stale one of that name.
+  // throws std::runtime_error if it can not be created, or if an input or
+  // output has a dtype without a fixed size, e.g. TF_STRING.
+  ShmServer(Model &model, const ShmServerOptions &options);
+
+  ShmServer(const ShmServer &server) = delete;
+  ShmServer &operator=(const ShmServer &server) = delete;
+
+  // removes the shared memory object, clients that mapped it keep it.
+  ~ShmServer();
+
+  // serve with options.workers threads, this one included, until stop.
+  void serve();
+  // make serve return. safe to call from any thread.
+  void stop();
+
+  ShmServerStats stats() const;
+
+ private:
+  void worker_loop();
+  // run the request in slot, true if it succeeded.
+  bool handle(std::size_t slot, std::vector<Tensor> &inputs,
+              std::vector<Tensor> &outputs);
+
+  Model &model;
+  ShmServerOptions options;
+  std::vector<TensorSpec> input_specs;
+  std::vector<TensorSpec> output_specs;
+  ShmRing *ring = nullptr;
+  std::size_t mapped_bytes = 0;
+  std::atomic<bool> stopping{false};
+  std::atomic<std::size_t> requests{0};
+  std::atomic<std::size_t> errors{0};
+};
+
+// a client of a ShmServer. thread safe, every thread takes its own slot.
+class ShmClient {
+ public:
+  // a claimed slot. write the inputs with input, then run, then read the
+  // outputs. the slot is released with the Request.
+  class Request {
+   public:
+    Request(Request &&request) noexcept;
+    Request(const Request &request) = delete;
+    Request &operator=(const Request &request) = delete;
+    Request &operator=(Request &&request) = delete;
+    ~Request();
+
+    // the buffer to write input i into, inputs are added in order.
+    // throws std::runtime_error if it does not fit in the slot.
+    void *input(TF_DataType dtype, const std::vector<int64_t> &shape);
+
+    // hand the slot to the server and wait for the outputs.
+    // throws std::runtime_error with the message of the server if the run
+    // failed.
+    void run();
+
+    std::size_t outputs() const;
+    TF_DataType output_dtype(std::size_t i) const;
+    std::vector<int64_t> output_shape(std::size_t i) const;
+    // valid until the Request is destroyed.
+    const void *output_data(std::size_t i) const;
+    std::size_t output_bytes(std::size_t i) const;
+
+   private:
+    friend class ShmClient;
+    Request(ShmClient *client, std::size_t slot)
+        : client(client), slot(slot) {}
+
+    ShmClient *client;
+    std::size_t slot;
+    // the bytes of the slot the inputs use.
+    std::size_t used = 0;
+  };
+
+  // maps the shared memory object of a ShmServer.
+  // throws std::runtime_error if there is none.
+  explicit ShmClient(const std::string &name);
+
+  ShmClient(const ShmClient &client) = delete;
+  ShmClient &operator=(const ShmClient &client) = delete;
+
+  ~ShmClient();
+
+  // claims a free slot, waiting while every slot is in use.
+  Request request();
+
+  // the outputs for inputs, copied into and out of a slot.
+  std::vector<WireTensor> run(const std::vector<WireTensor> &inputs);
+
+ private:
+  ShmRing *ring = nullptr;
+  std::size_t mapped_bytes = 0;
+  // where the search for a free slot starts, spreads the threads.
+  std::atomic<std::size_t> next_slot{0};
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_SHM_TRANSPORT_H
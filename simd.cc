@@ -0,0 +1,65 @@
+// Runtime cpu feature dispatch for the host side kernels.
+
+#include "simd.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace tf_cpp {
+
+namespace {
+
+SimdLevel DetectSimdLevel() {
+#if defined(TF_CPP_X86_SIMD)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+      __builtin_cpu_supports("f16c")) {
+    return SimdLevel::kAvx2;
+  }
+#endif
+  return SimdLevel::kScalar;
+}
+
+SimdLevel InitialSimdLevel() {
+  SimdLevel level = DetectSimdLevel();
+  const char *env = std::getenv("TF_CPP_SIMD");
+  if (env != nullptr) {
+    SimdLevel cap = level;
+    if (std::strcmp(env, "scalar") == 0) cap = SimdLevel::kScalar;
+    if (std::strcmp(env, "avx2") == 0) cap = SimdLevel::kAvx2;
+    if (cap < level) level = cap;
+  }
+  return level;
+}
+
+std::atomic<SimdLevel> &CurrentLevel() {
+  static std::atomic<SimdLevel> level(InitialSimdLevel());
+  return level;
+}
+
+}  // namespace
+
+SimdLevel simd_level() {
+  return CurrentLevel().load(std::memory_order_relaxed);
+}
+
+void set_simd_level(SimdLevel level) {
+  static const SimdLevel best = DetectSimdLevel();
+  CurrentLevel().store(level < best ? level : best);
+}
+
+const char *simd_level_name(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::kAvx512:
+      return "avx512";
+    case SimdLevel::kAvx2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+}  // namespace tf_cpp
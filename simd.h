@@ -0,0 +1,27 @@
+// Runtime cpu feature dispatch for the host side kernels.
+
+#ifndef TENSORFLOW_C_SIMD_H
+#define TENSORFLOW_C_SIMD_H
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define TF_CPP_X86_SIMD
+#endif
+
+namespace tf_cpp {
+
+// ordered, a level implies the ones below it.
+// kAvx2 also requires FMA and F16C, kAvx512 means AVX-512F.
+enum class SimdLevel { kScalar = 0, kAvx2 = 1, kAvx512 = 2 };
+
+// the level the kernels dispatch to. it is the best level of the cpu,
+// capped by the TF_CPP_SIMD environment variable (scalar, avx2, avx512)
+// and by set_simd_level.
+SimdLevel simd_level();
+
+// cap the dispatch level, e.g. to compare kernels. levels above what the
+// cpu supports are clipped.
+void set_simd_level(SimdLevel level);
+
+const char *simd_level_name(SimdLevel level);
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_SIMD_H
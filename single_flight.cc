@@ -0,0 +1,78 @@
+// Deduplicates concurrent identical requests into one session run.
+
+#include "single_flight.h"
+
+#include <exception>
+#include <stdexcept>
+#include <utility>
+
+#include "result_cache.h"
+
+namespace tf_cpp {
+
+SingleFlight::SingleFlight(std::size_t stripes)
+    : stripes(new Stripe[stripes]),
+      n_stripes(stripes),
+      n_runs(0),
+      n_shared(0) {
+  if (stripes == 0) {
+    throw std::runtime_error("SingleFlight needs at least one stripe.");
+  }
+}
+
+std::vector<SharedTensor> SingleFlight::run(
+    Model &model, const std::vector<Tensor *> &inputs,
+    const std::vector<Tensor *> &outputs) {
+  return run(ResultCache::request_key(model, inputs, outputs), [&]() {
+    model.run(inputs, outputs);
+    std::vector<SharedTensor> results;
+    results.reserve(outputs.size());
+    for (auto o : outputs) {
+      results.emplace_back(std::move(*o));
+    }
+    return results;
+  });
+}
+
+std::vector<SharedTensor> SingleFlight::run(
+    uint64_t key, const std::function<std::vector<SharedTensor>()> &fn) {
+  auto &stripe = stripes[(key >> 40) % n_stripes];
+  std::promise<std::vector<SharedTensor>> promise;
+  {
+    std::unique_lock<std::mutex> lock(stripe.mutex);
+    auto it = stripe.calls.find(key);
+    if (it != stripe.calls.end()) {
+      auto results = it->second;
+      lock.unlock();
+      ++n_shared;
+      return results.get();
+    }
+    stripe.calls.emplace(key, promise.get_future().share());
+  }
+
+  ++n_runs;
+  // requests that arrive from here on start their own run.
+  auto finish = [&]() {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    stripe.calls.erase(key);
+  };
+  std::vector<SharedTensor> results;
+  try {
+    results = fn();
+  } catch (...) {
+    finish();
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  finish();
+  promise.set_value(results);
+  return results;
+}
+
+SingleFlightStats SingleFlight::stats() const {
+  SingleFlightStats stats;
+  stats.runs = n_runs;
+  stats.shared = n_shared;
+  return stats;
+}
+}  // namespace tf_cpp
@@ -0,0 +1,70 @@
+// Deduplicates concurrent identical requests into one session run.
+
+#ifndef TENSORFLOW_C_SINGLE_FLIGHT_H
+#define TENSORFLOW_C_SINGLE_FLIGHT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "model.h"
+#include "shared_tensor.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+struct SingleFlightStats {
+  // requests that ran the session, and requests that waited for one of them.
+  std::size_t runs = 0;
+  std::size_t shared = 0;
+};
+
+// while a request is running, identical requests that arrive wait for it
+// and share its output buffers instead of running the session again.
+// requests are identical if ResultCache::request_key matches. unlike a
+// ResultCache nothing is kept once the run is done.
+// in flight requests live in lock striped tables, a request that does not
+// collide only takes one uncontended lock twice.
+// thread safe.
+class SingleFlight {
+ public:
+  explicit SingleFlight(std::size_t stripes = 64);
+
+  SingleFlight(const SingleFlight &flight) = delete;
+  SingleFlight &operator=(const SingleFlight &flight) = delete;
+
+  // the results of model.run(inputs, outputs), shared with every identical
+  // request in flight. outputs only name the tensors to fetch, after a run
+  // they are left empty. an error of the run is thrown to every waiter.
+  std::vector<SharedTensor> run(Model &model,
+                                const std::vector<Tensor *> &inputs,
+                                const std::vector<Tensor *> &outputs);
+
+  // the results of fn, or of the call of fn with the same key in flight.
+  std::vector<SharedTensor> run(
+      uint64_t key, const std::function<std::vector<SharedTensor>()> &fn);
+
+  SingleFlightStats stats() const;
+
+ private:
+  using Results = std::shared_future<std::vector<SharedTensor>>;
+
+  // one line each, threads on different stripes do not share a line.
+  struct alignas(64) Stripe {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Results> calls;
+  };
+
+  std::unique_ptr<Stripe[]> stripes;
+  std::size_t n_stripes;
+  std::atomic<std::size_t> n_runs;
+  std::atomic<std::size_t> n_shared;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_SINGLE_FLIGHT_H
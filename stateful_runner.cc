@@ -0,0 +1,54 @@
+// Step by step runs of recurrent models that carry state between steps.
+
+#include "stateful_runner.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace tf_cpp {
+
+StatefulRunner::StatefulRunner(Model &model,
+                               const std::vector<StateSpec> &states)
+    : model(model), n_steps(0) {
+  for (auto &s : states) {
+    if (!index.emplace(s.input.name, state_in.size()).second) {
+      throw std::runtime_error("state " + s.input.name + " is bound twice.");
+    }
+    state_in.emplace_back(new Tensor(model.get_graph(), s.input));
+    state_out.emplace_back(new Tensor(model.get_graph(), s.output,
+                                      s.input.shape, s.input.dtype));
+  }
+  reset();
+}
+
+Tensor &StatefulRunner::state(const std::string &input_name) {
+  auto it = index.find(input_name);
+  if (it == index.end()) {
+    throw std::runtime_error("no state " + input_name + ".");
+  }
+  return *state_in[it->second];
+}
+
+void StatefulRunner::reset() {
+  for (auto &s : state_in) {
+    s->set_zero();
+  }
+  n_steps = 0;
+}
+
+void StatefulRunner::step(const std::vector<Tensor *> &inputs,
+                          const std::vector<Tensor *> &outputs,
+                          const std::vector<TF_Operation *> &operations) {
+  std::vector<Tensor *> feeds(inputs);
+  std::vector<Tensor *> fetches(outputs);
+  for (std::size_t i = 0; i != state_in.size(); ++i) {
+    feeds.push_back(state_in[i].get());
+    fetches.push_back(state_out[i].get());
+  }
+  model.run(feeds, fetches, operations);
+  for (std::size_t i = 0; i != state_in.size(); ++i) {
+    state_in[i]->adopt(std::move(*state_out[i]));
+  }
+  ++n_steps;
+}
+}  // namespace tf_cpp
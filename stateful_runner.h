@@ -0,0 +1,60 @@
+// Step by step runs of recurrent models that carry state between steps.
+
+#ifndef TENSORFLOW_C_STATEFUL_RUNNER_H
+#define TENSORFLOW_C_STATEFUL_RUNNER_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+// a state of a recurrent model: the input it is fed to and the operation
+// that produces its next value. both have the dtype and shape of input.
+struct StateSpec {
+  TensorSpec input;
+  std::string output;
+};
+
+// runs a model one step at a time. the state outputs of a step become the
+// state inputs of the next one through Tensor::adopt, without copies.
+// like a Model with its own Tensors, one runner must not be used by several
+// threads at once.
+class StatefulRunner {
+ public:
+  // the states start at zero.
+  StatefulRunner(Model &model, const std::vector<StateSpec> &states);
+
+  StatefulRunner(const StatefulRunner &runner) = delete;
+  StatefulRunner &operator=(const StatefulRunner &runner) = delete;
+
+  // the input Tensor of a state by input name, e.g. to set an initial state
+  // or to read the state after a step.
+  Tensor &state(const std::string &input_name);
+
+  // set every state back to zero.
+  void reset();
+
+  // feed inputs and the states, fetch outputs and the next states.
+  void step(const std::vector<Tensor *> &inputs,
+            const std::vector<Tensor *> &outputs,
+            const std::vector<TF_Operation *> &operations = {});
+
+  std::size_t steps() const { return n_steps; }
+
+ private:
+  Model &model;
+  std::map<std::string, std::size_t> index;
+  std::vector<std::unique_ptr<Tensor>> state_in;
+  std::vector<std::unique_ptr<Tensor>> state_out;
+  std::size_t n_steps;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_STATEFUL_RUNNER_H
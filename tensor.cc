@@ -5,20 +5,42 @@
 
 #include "tensor.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "convert.h"
 #include "model.h"
+#include "row_copy.h"
+#include "scope_guard.h"
 #include "tf_utils.h"
 
 namespace tf_cpp {
 
+namespace {
+
+std::size_t NumElements(const std::vector<int64_t> &shape) {
+  std::size_t size = 1;
+  for (auto &s : shape) {
+    size *= std::abs(s);
+  }
+  return size;
+}
+
+}  // namespace
+
 Tensor::Tensor(TF_Graph *graph, const std::string &oper_name,
                const std::vector<int64_t> &shape, const TF_DataType &dtype)
     : status(nullptr), tf_tensor(nullptr) {
   status = TF_NewStatus();
+  // the destructor does not run if this throws.
+  MAKE_SCOPE_EXIT(free_status) {
+    TF_DeleteStatus(status);
+    status = nullptr;
+  };
   int n_dims;
   int64_t dims[MAX_DIMS];
   auto tf_code = tf_utils::GetTGraphOperation(graph, oper_name.c_str(), &tf_op,
@@ -32,6 +54,12 @@ Tensor::Tensor(TF_Graph *graph, const std::string &oper_name,
         tf_utils::DataTypeToString(dtype) + " vs. " +
         tf_utils::DataTypeToString(tf_type) + "].");
   }
+  if (n_dims < 0) {
+    // unknown rank, e.g. an internal tensor, take the shape as given.
+    tf_shape = shape;
+    free_status.dismiss();
+    return;
+  }
   tf_shape = std::vector<int64_t>(dims, dims + n_dims);
   if (shape.size() != n_dims) {
     throw std::runtime_error(
@@ -48,6 +76,29 @@ Tensor::Tensor(TF_Graph *graph, const std::string &oper_name,
     }
     tf_shape[i] = shape[i];
   }
+  free_status.dismiss();
+}
+
+Tensor::Tensor(Tensor &&tensor)
+    : status(tensor.status),
+      tf_tensor(tensor.tf_tensor),
+      tf_op(tensor.tf_op),
+      tf_type(tensor.tf_type),
+      tf_shape(std::move(tensor.tf_shape)) {
+  tensor.status = nullptr;
+  tensor.tf_tensor = nullptr;
+}
+
+Tensor &Tensor::operator=(Tensor &&tensor) {
+  if (this != &tensor) {
+    // the moved from tensor frees what this one owned.
+    std::swap(status, tensor.status);
+    std::swap(tf_tensor, tensor.tf_tensor);
+    tf_op = tensor.tf_op;
+    tf_type = tensor.tf_type;
+    tf_shape = std::move(tensor.tf_shape);
+  }
+  return *this;
 }
 
 Tensor::~Tensor() {
@@ -59,6 +110,228 @@ Tensor::~Tensor() {
   }
 }
 
+void Tensor::set_strings(const std::vector<std::string_view> &strings) {
+  if (tf_type != TF_STRING) {
+    throw std::runtime_error("tf_tensor type is " +
+                             tf_utils::DataTypeToString(tf_type) +
+                             ", not TF_STRING.");
+  }
+  auto new_tensor = tf_utils::CreateStringTensor(strings, tf_shape, status);
+  if (new_tensor == nullptr) {
+    throw std::runtime_error(
+        "tf_utils::CreateStringTensor error, " +
+        std::to_string(strings.size()) + " strings for shape " +
+        to_string(tf_shape) + ".");
+  }
+  if (tf_tensor != nullptr) {
+    TF_DeleteTensor(tf_tensor);
+  }
+  tf_tensor = new_tensor;
+}
+
+std::vector<std::string_view> Tensor::strings() {
+  if (tf_tensor == nullptr) {
+    return {};
+  }
+  if (tf_type != TF_STRING) {
+    throw std::runtime_error("tf_tensor type is " +
+                             tf_utils::DataTypeToString(tf_type) +
+                             ", not TF_STRING.");
+  }
+  return tf_utils::GetStringTensorData(tf_tensor, status);
+}
+
+void Tensor::from_float(const float *src, std::size_t n) {
+  if (n != NumElements(tf_shape)) {
+    throw std::runtime_error("from_float got " + std::to_string(n) +
+                             " values for shape " + to_string(tf_shape) + ".");
+  }
+  switch (tf_type) {
+    case TF_FLOAT:
+      std::memcpy(data<float>(), src, n * sizeof(float));
+      break;
+    case TF_HALF:
+      float_to_half(src, data<half>(), n);
+      break;
+    case TF_BFLOAT16:
+      float_to_bfloat16(src, data<bfloat16>(), n);
+      break;
+    default:
+      throw std::runtime_error("from_float does not support " +
+                               tf_utils::DataTypeToString(tf_type) + ".");
+  }
+}
+
+void Tensor::to_float(float *dst, std::size_t n) {
+  if (tf_tensor == nullptr) {
+    throw std::runtime_error("to_float on an empty tensor.");
+  }
+  std::size_t size = TF_TensorElementCount(tf_tensor);
+  if (n != size) {
+    throw std::runtime_error("to_float got room for " + std::to_string(n) +
+                             " values, tensor has " + std::to_string(size) +
+                             ".");
+  }
+  switch (tf_type) {
+    case TF_FLOAT:
+      std::memcpy(dst, data<float>(), n * sizeof(float));
+      break;
+    case TF_HALF:
+      half_to_float(data<half>(), dst, n);
+      break;
+    case TF_BFLOAT16:
+      bfloat16_to_float(data<bfloat16>(), dst, n);
+      break;
+    default:
+      throw std::runtime_error("to_float does not support " +
+                               tf_utils::DataTypeToString(tf_type) + ".");
+  }
+}
+
+template <typename S>
+void Tensor::fill_from_impl(const S *src, std::size_t n, double scale,
+                            double offset) {
+  if (n != NumElements(tf_shape)) {
+    throw std::runtime_error("fill_from got " + std::to_string(n) +
+                             " values for shape " + to_string(tf_shape) + ".");
+  }
+  switch (tf_type) {
+    case TF_FLOAT:
+      convert(src, data<float>(), n, static_cast<float>(scale),
+              static_cast<float>(offset));
+      break;
+    case TF_DOUBLE:
+      convert(src, data<double>(), n, scale, offset);
+      break;
+    case TF_HALF:
+    case TF_BFLOAT16: {
+      // through a small float buffer that stays in L1.
+      constexpr std::size_t kChunk = 1024;
+      float buffer[kChunk];
+      bool is_half = tf_type == TF_HALF;
+      auto dst = is_half ? static_cast<void *>(data<half>())
+                         : static_cast<void *>(data<bfloat16>());
+      for (std::size_t i = 0; i < n; i += kChunk) {
+        std::size_t m = std::min(kChunk, n - i);
+        convert(src + i, buffer, m, static_cast<float>(scale),
+                static_cast<float>(offset));
+        if (is_half) {
+          float_to_half(buffer, static_cast<half *>(dst) + i, m);
+        } else {
+          float_to_bfloat16(buffer, static_cast<bfloat16 *>(dst) + i, m);
+        }
+      }
+      break;
+    }
+    default:
+      throw std::runtime_error("fill_from does not support " +
+                               tf_utils::DataTypeToString(tf_type) + ".");
+  }
+}
+
+void Tensor::fill_from(const uint8_t *src, std::size_t n, double scale,
+                       double offset) {
+  fill_from_impl(src, n, scale, offset);
+}
+
+void Tensor::fill_from(const int16_t *src, std::size_t n, double scale,
+                       double offset) {
+  fill_from_impl(src, n, scale, offset);
+}
+
+void Tensor::fill_from(const float *src, std::size_t n, double scale,
+                       double offset) {
+  fill_from_impl(src, n, scale, offset);
+}
+
+void Tensor::fill_from(const double *src, std::size_t n, double scale,
+                       double offset) {
+  fill_from_impl(src, n, scale, offset);
+}
+
+void Tensor::adopt(Tensor &&output) {
+  if (&output == this) {
+    return;
+  }
+  if (output.tf_tensor == nullptr) {
+    throw std::runtime_error("can not adopt an empty tensor.");
+  }
+  if (output.tf_type != tf_type) {
+    throw std::runtime_error(
+        "dtype is incompatible with tf_tensor data type. [" +
+        tf_utils::DataTypeToString(output.tf_type) + " vs. " +
+        tf_utils::DataTypeToString(tf_type) + "].");
+  }
+  std::vector<int64_t> dims(TF_NumDims(output.tf_tensor));
+  for (std::size_t i = 0; i != dims.size(); ++i) {
+    dims[i] = TF_Dim(output.tf_tensor, i);
+  }
+  if (dims != tf_shape) {
+    throw std::runtime_error(
+        std::string("data's shape is incompatible with tf_tensor shape. [") +
+        to_string(dims) + " vs. " + to_string(tf_shape) + "].");
+  }
+  if (tf_tensor != nullptr) {
+    TF_DeleteTensor(tf_tensor);
+  }
+  tf_tensor = output.tf_tensor;
+  output.tf_tensor = nullptr;
+}
+
+void Tensor::set_zero() {
+  void *data = raw_data();
+  std::memset(data, 0, TF_TensorByteSize(tf_tensor));
+}
+
+std::size_t Tensor::row_bytes() const {
+  if (tf_shape.empty()) {
+    throw std::runtime_error("a scalar tensor has no rows.");
+  }
+  std::size_t size = TF_DataTypeSize(tf_type);
+  for (std::size_t i = 1; i < tf_shape.size(); ++i) {
+    size *= std::abs(tf_shape[i]);
+  }
+  return size;
+}
+
+void *Tensor::raw_data() {
+  if (tf_tensor == nullptr) {
+    std::size_t size = TF_DataTypeSize(tf_type);
+    if (size == 0) {
+      throw std::runtime_error("tf_tensor type " +
+                               tf_utils::DataTypeToString(tf_type) +
+                               " has no fixed element size.");
+    }
+    tf_tensor = tf_utils::CreateEmptyTensor(tf_type, tf_shape,
+                                            NumElements(tf_shape) * size);
+    if (tf_tensor == nullptr) {
+      throw std::runtime_error("tf_utils::CreateTensor error");
+    }
+  }
+  return TF_TensorData(tf_tensor);
+}
+
+void Tensor::gather_rows(const void *const *rows, std::size_t n_rows) {
+  std::size_t bytes = row_bytes();
+  if (n_rows > static_cast<std::size_t>(std::abs(tf_shape[0]))) {
+    throw std::runtime_error("gather_rows got " + std::to_string(n_rows) +
+                             " rows for shape " + to_string(tf_shape) + ".");
+  }
+  tf_cpp::gather_rows(rows, n_rows, bytes, raw_data());
+}
+
+void Tensor::scatter_rows(void *const *rows, std::size_t n_rows) {
+  std::size_t bytes = row_bytes();
+  if (tf_tensor == nullptr) {
+    throw std::runtime_error("scatter_rows on an empty tensor.");
+  }
+  if (n_rows > static_cast<std::size_t>(TF_Dim(tf_tensor, 0))) {
+    throw std::runtime_error("scatter_rows got " + std::to_string(n_rows) +
+                             " rows for shape " + to_string(tf_shape) + ".");
+  }
+  tf_cpp::scatter_rows(TF_TensorData(tf_tensor), n_rows, bytes, rows);
+}
+
 void Tensor::set_tensor(TF_Tensor *new_tensor) {
   if (tf_tensor != nullptr) {
     TF_DeleteTensor(tf_tensor);
@@ -92,4 +365,17 @@ void Tensor::set_tensor(TF_Tensor *new_tensor) {
   }
   // std::cout << n_dims << " " << to_string(tf_shape) << std::endl;
 }
+
+TensorSpec graph_spec(TF_Graph *graph, const std::string &name) {
+  TF_Output op;
+  TF_DataType dtype;
+  int n_dims;
+  int64_t dims[MAX_DIMS];
+  if (tf_utils::GetTGraphOperation(graph, name.c_str(), &op, &dtype, &n_dims,
+                                   dims, nullptr) != TF_OK) {
+    throw std::runtime_error("no tensor " + name + " in the graph.");
+  }
+  return {name, dtype,
+          std::vector<int64_t>(dims, dims + std::max(n_dims, 0))};
+}
 }  // namespace tf_cpp
\ No newline at end of file
@@ -14,17 +14,26 @@
 #include <memory>
 #include <numeric>
 #include <string>
+#include <string_view>
 #include <typeinfo>
 #include <variant>
 #include <vector>
 
+#include "float16.h"
+#include "row_view.h"
 #include "tf_utils.h"
+#include "transpose.h"
 
 #define MAX_DIMS 10
 
 namespace tf_cpp {
 
 class Model;
+class NpyDataset;
+class PartialRun;
+class PrefixCache;
+class ResultCache;
+class SharedTensor;
 
 template <typename T>
 std::string to_string(const std::vector<T> &vec) {
@@ -35,16 +44,32 @@ std::string to_string(const std::vector<T> &vec) {
   return ret;
 }
 
+// name, dtype and shape of a graph tensor, enough to construct a Tensor.
+struct TensorSpec {
+  std::string name;
+  TF_DataType dtype;
+  std::vector<int64_t> shape;
+};
+
+// the spec of the tensor name in graph, with -1 for the dimensions the graph
+// does not know and no dimensions if it does not know the rank.
+// throws std::runtime_error if there is no such tensor.
+TensorSpec graph_spec(TF_Graph *graph, const std::string &name);
+
 class Tensor {
  public:
   // shape and type are used to verify the shape and dtype of tf_tensor.
+  // oper_name is "name" for output 0 of an operation or "name:i" for
+  // output i, e.g. an internal tensor to fetch or to feed.
   Tensor(TF_Graph *graph, const std::string &oper_name,
          const std::vector<int64_t> &shape, const TF_DataType &dtype);
+  Tensor(TF_Graph *graph, const TensorSpec &spec)
+      : Tensor(graph, spec.name, spec.shape, spec.dtype) {}
   // move only.
   Tensor(const Tensor &tensor) = delete;
-  Tensor(Tensor &&tensor) = default;
+  Tensor(Tensor &&tensor);
   Tensor &operator=(const Tensor &tensor) = delete;
-  Tensor &operator=(Tensor &&tensor) = default;
+  Tensor &operator=(Tensor &&tensor);
 
   ~Tensor();
 
@@ -122,8 +147,115 @@ class Tensor {
     return at<T>(std::vector<int>{idx0, idx1, idx2, idx3});
   }
 
+  // raw access to the whole tf_tensor buffer as type T.
+  // useful for bulk copies, where at() would check every element.
+  template <typename T>
+  T *data() {
+    if (tf_tensor == nullptr) {
+      create_tensor<T>();
+    }
+    if (deduce_type<T>() != tf_type) {
+      throw std::runtime_error(
+          "can not access tf_tensor in this type. tf_tensor type is " +
+          tf_utils::DataTypeToString(tf_type) + ".");
+    }
+    return static_cast<T *>(TF_TensorData(tf_tensor));
+  }
+
+  // TF_STRING tensors, one string per element of the tensor's shape.
+  // the views returned by strings() are valid until tf_tensor changes.
+  void set_strings(const std::vector<std::string_view> &strings);
+  std::vector<std::string_view> strings();
+
+  // fill or read a TF_FLOAT, TF_HALF or TF_BFLOAT16 tensor as floats,
+  // converting with the vectorized routines of float16.h.
+  // n must be the number of elements of the tensor.
+  void from_float(const float *src, std::size_t n);
+  void to_float(float *dst, std::size_t n);
+
+  // fill a TF_FLOAT, TF_DOUBLE, TF_HALF or TF_BFLOAT16 tensor from n values,
+  // tf_tensor[i] = src[i] * scale + offset, converted in one vectorized pass,
+  // e.g. fill_from(pixels, 784, 1.0 / 255) for uint8 images.
+  // n must be the number of elements of the tensor.
+  void fill_from(const uint8_t *src, std::size_t n, double scale = 1,
+                 double offset = 0);
+  void fill_from(const int16_t *src, std::size_t n, double scale = 1,
+                 double offset = 0);
+  void fill_from(const float *src, std::size_t n, double scale = 1,
+                 double offset = 0);
+  void fill_from(const double *src, std::size_t n, double scale = 1,
+                 double offset = 0);
+
+  // batch assembly along the first dimension: copy rows[i] into row i of
+  // the tensor, or row i of the tensor out to rows[i], for i < n_rows.
+  // every row is row_bytes() long and n_rows must not exceed the batch size,
+  // rows past n_rows are left alone. see gather_rows in row_copy.h.
+  void gather_rows(const void *const *rows, std::size_t n_rows);
+  void gather_rows(const std::vector<const void *> &rows) {
+    gather_rows(rows.data(), rows.size());
+  }
+  void scatter_rows(void *const *rows, std::size_t n_rows);
+  void scatter_rows(const std::vector<void *> &rows) {
+    scatter_rows(rows.data(), rows.size());
+  }
+  std::size_t row_bytes() const;
+
+  // take over the tf_tensor of output without copying, e.g. to feed the
+  // state fetched by one run to the next. dtype and shape must match.
+  // output is left empty and can be the output of the next run.
+  void adopt(Tensor &&output);
+
+  // allocate tf_tensor if needed and set every byte to zero.
+  void set_zero();
+
+  // hand the rows of tf_tensor out as views, one per entry of the first
+  // dimension, without copying. tf_tensor is released to the views and
+  // freed with the last of them, the Tensor is left empty and can be the
+  // output of the next run. see also SharedTensor.
+  template <typename T>
+  std::vector<RowView<T>> take_rows() {
+    if (tf_tensor == nullptr) {
+      throw std::runtime_error("take_rows on an empty tensor.");
+    }
+    const T *base = data<T>();
+    std::size_t n_rows = tf_shape.empty() ? 1 : TF_Dim(tf_tensor, 0);
+    std::size_t row_size =
+        n_rows == 0 ? 0 : TF_TensorElementCount(tf_tensor) / n_rows;
+    auto owner = share_tensor(tf_tensor);
+    tf_tensor = nullptr;
+    std::vector<RowView<T>> rows;
+    rows.reserve(n_rows);
+    for (std::size_t i = 0; i != n_rows; ++i) {
+      rows.emplace_back(owner, base + i * row_size, row_size);
+    }
+    return rows;
+  }
+
+  // fill the tensor from src, an array of shape src_shape, with its axes
+  // permuted: axis i of the tensor is axis perm[i] of src.
+  // e.g. permute_from(nchw, {n, c, h, w}, kNchwToNhwc) for an NHWC input.
+  template <typename T>
+  void permute_from(const T *src, const std::vector<int64_t> &src_shape,
+                    const std::vector<int> &perm) {
+    auto shape = permuted_shape(src_shape, perm);
+    if (shape != tf_shape) {
+      throw std::runtime_error("permuted shape " + to_string(shape) +
+                               " does not match tf_tensor shape " +
+                               to_string(tf_shape) + ".");
+    }
+    permute(src, src_shape, perm, data<T>(), sizeof(T));
+  }
+
+  // copy the tensor into dst with its axes permuted: axis i of dst is axis
+  // perm[i] of the tensor, e.g. permute_to(nchw, kNhwcToNchw).
+  template <typename T>
+  void permute_to(T *dst, const std::vector<int> &perm) {
+    permute(data<T>(), tf_shape, perm, dst, sizeof(T));
+  }
+
   std::vector<int64_t> shape() { return tf_shape; }
   std::size_t dim() { return tf_shape.size(); }
+  TF_DataType dtype() const { return tf_type; }
 
  private:
   // create tf_tensor, should be called only once.
@@ -144,10 +276,14 @@ class Tensor {
     }
   }
 
+  // the buffer of tf_tensor, created for tf_type if needed.
+  void *raw_data();
+
   template <typename T>
-  TF_DataType deduce_type() {
-    // we don't support bool type, please do not use TF_BOOL in tensorflow.
-    // (std::is_same<T, bool>::value) return TF_BOOL;
+  static TF_DataType deduce_type() {
+    if (std::is_same<T, bool>::value) return TF_BOOL;
+    if (std::is_same<T, half>::value) return TF_HALF;
+    if (std::is_same<T, bfloat16>::value) return TF_BFLOAT16;
     if (std::is_same<T, float>::value) return TF_FLOAT;
     if (std::is_same<T, double>::value) return TF_DOUBLE;
     if (std::is_same<T, int8_t>::value) return TF_INT8;
@@ -162,9 +298,13 @@ class Tensor {
     throw std::runtime_error{"Could not deduce type!"};
   }
 
+  template <typename S>
+  void fill_from_impl(const S *src, std::size_t n, double scale,
+                      double offset);
+
   // set tf_tensor from new_tensor.
   // useful for accessing data from session out.
-  // should only be called by Model.
+  // should only be called by Model and the datasets.
   void set_tensor(TF_Tensor *new_tensor);
 
  private:
@@ -175,7 +315,15 @@ class Tensor {
   std::vector<int64_t> tf_shape;
 
  public:
+  friend class InferenceServer;
   friend class Model;
+  friend class NpyDataset;
+  friend class PartialRun;
+  friend class PrefixCache;
+  friend class ResultCache;
+  friend class SharedTensor;
+  friend class ShmServer;
+  friend class TextParser;
 };
 }  // namespace tf_cpp
 #endif  // TENSORFLOW_C_TENSOR_H
@@ -0,0 +1,55 @@
+#include "tensor.h"
+#include "tf_utils.h"
+#include "scope_guard.h"
+#include <iostream>
+#include <utility>
+
+int main() {
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "h", TF_FLOAT, {1, 4});
+  tf_utils::AddPlaceholder(graph, "h_next", TF_FLOAT, {1, 4});
+  tf_utils::AddPlaceholder(graph, "ids", TF_INT32, {1, 4});
+
+  tf_cpp::Tensor h(graph, "h", {1, 4}, TF_FLOAT);
+  tf_cpp::Tensor h_next(graph, "h_next", {1, 4}, TF_FLOAT);
+  float* data = h_next.data<float>();
+  for (int i = 0; i < 4; ++i) data[i] = static_cast<float>(i);
+
+  // the buffer moves, no copy.
+  h.adopt(std::move(h_next));
+  if (h.data<float>() != data || h.at<float>(0, 3) != 3) {
+    std::cout << "Wrong adopt" << std::endl;
+    return 1;
+  }
+  // the output can be filled again.
+  if (h_next.data<float>() == data) {
+    std::cout << "Output still owns the buffer" << std::endl;
+    return 2;
+  }
+
+  tf_cpp::Tensor ids(graph, "ids", {1, 4}, TF_INT32);
+  ids.set_zero();
+  try {
+    h.adopt(std::move(ids));
+    std::cout << "Adopt of wrong dtype accepted" << std::endl;
+    return 3;
+  } catch (const std::runtime_error&) {
+  }
+
+  // moving a Tensor moves the ownership of its buffer.
+  tf_cpp::Tensor moved(std::move(h));
+  if (moved.data<float>() != data) {
+    std::cout << "Wrong move" << std::endl;
+    return 4;
+  }
+  h = std::move(moved);
+  if (h.at<float>(0, 2) != 2) {
+    std::cout << "Wrong move assignment" << std::endl;
+    return 5;
+  }
+
+  std::cout << "Success adopt" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,86 @@
+#include "concurrency_limiter.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+int main() {
+  tf_cpp::ConcurrencyLimiterOptions options;
+  options.initial_limit = 2;
+  options.max_queue = 1;
+  tf_cpp::ConcurrencyLimiter limiter(options);
+
+  // two runs hold the limit, a third waits, a fourth is rejected.
+  std::atomic<bool> release(false);
+  std::atomic<int> done(0);
+  auto blocked = [&]() {
+    while (!release) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&]() {
+      limiter.run(blocked);
+      ++done;
+    });
+  }
+  auto start = std::chrono::steady_clock::now();
+  while (limiter.stats().queued != 1 &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto stats = limiter.stats();
+  if (stats.in_flight != 2 || stats.queued != 1) {
+    std::cout << "Runs over the limit did not queue" << std::endl;
+    return 1;
+  }
+  try {
+    limiter.run([]() {});
+    std::cout << "Run over the limit and queue was admitted" << std::endl;
+    return 2;
+  } catch (const tf_cpp::Overloaded&) {
+  }
+  release = true;
+  for (auto& t : threads) t.join();
+  stats = limiter.stats();
+  if (done != 3 || stats.admitted != 3 || stats.rejected != 1 ||
+      stats.in_flight != 0 || stats.queued != 0) {
+    std::cout << "Wrong stats" << std::endl;
+    return 3;
+  }
+
+  // errors of a run pass through and free its slot.
+  try {
+    limiter.run([]() { throw std::runtime_error("session error"); });
+    std::cout << "Run error was swallowed" << std::endl;
+    return 4;
+  } catch (const tf_cpp::Overloaded&) {
+    std::cout << "Run error was taken for a rejection" << std::endl;
+    return 5;
+  } catch (const std::runtime_error&) {
+  }
+  if (limiter.stats().in_flight != 0) {
+    std::cout << "Failed run kept its slot" << std::endl;
+    return 6;
+  }
+
+  // latency far above the no load latency shrinks the limit.
+  options.initial_limit = 16;
+  options.max_queue = 0;
+  tf_cpp::ConcurrencyLimiter slow(options);
+  slow.run([]() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+  for (int i = 0; i < 10; ++i) {
+    slow.run(
+        []() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); });
+  }
+  if (slow.stats().limit >= 16) {
+    std::cout << "Slow runs did not lower the limit" << std::endl;
+    return 7;
+  }
+
+  std::cout << "Success limiting concurrent runs" << std::endl;
+  return 0;
+}
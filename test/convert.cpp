@@ -0,0 +1,54 @@
+#include "convert.h"
+#include "simd.h"
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+template <typename S, typename D>
+static bool Check(const std::vector<S>& src, D scale, D offset, D tolerance) {
+  std::vector<D> dst(src.size());
+  tf_cpp::convert(src.data(), dst.data(), src.size(), scale, offset);
+  for (std::size_t i = 0; i < src.size(); ++i) {
+    D expected = static_cast<D>(src[i]) * scale + offset;
+    if (std::fabs(dst[i] - expected) > tolerance * (1 + std::fabs(expected))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename S>
+static bool CheckAll(const std::vector<S>& src) {
+  return Check<S, float>(src, 1.0f / 255, -0.5f, 1e-6f) && Check<S, float>(src, 1, 0, 0) &&
+         Check<S, double>(src, 1.0 / 255, -0.5, 1e-15) && Check<S, double>(src, 1, 0, 0);
+}
+
+int main() {
+  // 37 elements exercise the vector bodies and the scalar tails.
+  std::vector<std::uint8_t> u8;
+  std::vector<std::int16_t> i16;
+  std::vector<float> f32;
+  std::vector<double> f64;
+  for (int i = 0; i != 37; ++i) {
+    u8.push_back(static_cast<std::uint8_t>(i * 7));
+    i16.push_back(static_cast<std::int16_t>(i * 1000 - 18000));
+    f32.push_back(i * 0.25f - 3);
+    f64.push_back(i * 0.125 - 2);
+  }
+  u8.back() = 255;
+
+  const auto best = tf_cpp::simd_level();
+  for (int l = 0; l <= static_cast<int>(best); ++l) {
+    tf_cpp::set_simd_level(static_cast<tf_cpp::SimdLevel>(l));
+    if (!CheckAll(u8) || !CheckAll(i16) || !CheckAll(f32) || !CheckAll(f64)) {
+      std::cout << "Wrong conversion at level " << tf_cpp::simd_level_name(tf_cpp::simd_level())
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << "Success convert" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include "float16.h"
+#include "simd.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+static std::uint32_t Bits(float f) {
+  std::uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  return x;
+}
+
+int main() {
+  struct Case { float f; std::uint16_t half; std::uint16_t bfloat16; };
+  const float inf = std::numeric_limits<float>::infinity();
+  const std::vector<Case> cases = {
+      {0.0f, 0x0000, 0x0000},
+      {-0.0f, 0x8000, 0x8000},
+      {1.0f, 0x3c00, 0x3f80},
+      {-2.0f, 0xc000, 0xc000},
+      {65504.0f, 0x7bff, 0x4780},
+      {65520.0f, 0x7c00, 0x4780},        // rounds up to inf in half.
+      {inf, 0x7c00, 0x7f80},
+      {-inf, 0xfc00, 0xff80},
+      {std::ldexp(1.0f, -24), 0x0001, 0x3380},  // smallest half subnormal.
+      {std::ldexp(1.0f, -25), 0x0000, 0x3300},  // tie rounds to even zero.
+      {1.0f + std::ldexp(1.0f, -11), 0x3c00, 0x3f80},  // tie to even.
+      {1.0f + 3 * std::ldexp(1.0f, -11), 0x3c02, 0x3f80},  // tie to even.
+  };
+
+  // pad to exercise the vector bodies and the scalar tails.
+  std::vector<float> src;
+  for (int r = 0; r != 3; ++r) {
+    for (auto &c : cases) src.push_back(c.f);
+  }
+  src.push_back(std::numeric_limits<float>::quiet_NaN());
+
+  const auto best = tf_cpp::simd_level();
+  for (int l = 0; l <= static_cast<int>(best); ++l) {
+    tf_cpp::set_simd_level(static_cast<tf_cpp::SimdLevel>(l));
+    std::vector<tf_cpp::half> h(src.size());
+    std::vector<tf_cpp::bfloat16> b(src.size());
+    tf_cpp::float_to_half(src.data(), h.data(), src.size());
+    tf_cpp::float_to_bfloat16(src.data(), b.data(), src.size());
+    for (std::size_t i = 0; i + 1 < src.size(); ++i) {
+      auto &c = cases[i % cases.size()];
+      if (h[i].bits != c.half || b[i].bits != c.bfloat16) {
+        std::cout << "Wrong conversion of " << c.f << " at level " << l << std::endl;
+        return 1;
+      }
+    }
+    std::vector<float> back(src.size());
+    tf_cpp::half_to_float(h.data(), back.data(), src.size());
+    for (std::size_t i = 0; i + 1 < src.size(); ++i) {
+      if (Bits(back[i]) != Bits(static_cast<float>(h[i]))) {
+        std::cout << "Wrong half to float at level " << l << std::endl;
+        return 2;
+      }
+    }
+    if (!std::isnan(back.back())) {
+      std::cout << "NaN lost in half at level " << l << std::endl;
+      return 3;
+    }
+    tf_cpp::bfloat16_to_float(b.data(), back.data(), src.size());
+    for (std::size_t i = 0; i + 1 < src.size(); ++i) {
+      if (Bits(back[i]) != static_cast<std::uint32_t>(b[i].bits) << 16) {
+        std::cout << "Wrong bfloat16 to float at level " << l << std::endl;
+        return 4;
+      }
+    }
+    if (!std::isnan(back.back())) {
+      std::cout << "NaN lost in bfloat16 at level " << l << std::endl;
+      return 5;
+    }
+  }
+
+  // every half converts back to itself.
+  tf_cpp::set_simd_level(best);
+  std::vector<tf_cpp::half> all(1 << 16), again(1 << 16);
+  for (std::uint32_t i = 0; i != all.size(); ++i) all[i].bits = static_cast<std::uint16_t>(i);
+  std::vector<float> floats(all.size());
+  tf_cpp::half_to_float(all.data(), floats.data(), all.size());
+  tf_cpp::float_to_half(floats.data(), again.data(), all.size());
+  for (std::size_t i = 0; i != all.size(); ++i) {
+    bool nan = (all[i].bits & 0x7c00) == 0x7c00 && (all[i].bits & 0x3ff) != 0;
+    if (!nan && again[i].bits != all[i].bits) {
+      std::cout << "Half " << i << " does not round trip" << std::endl;
+      return 6;
+    }
+  }
+
+  std::cout << "Success convert half and bfloat16" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include "hash.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include "scope_guard.h"
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <vector>
+
+int main() {
+  // every length and every changed byte gives another hash.
+  std::vector<uint8_t> bytes(200);
+  for (std::size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<uint8_t>(i * 7);
+  std::set<uint64_t> hashes;
+  for (std::size_t n = 0; n <= bytes.size(); ++n) {
+    hashes.insert(tf_cpp::hash_bytes(bytes.data(), n));
+  }
+  if (hashes.size() != bytes.size() + 1) {
+    std::cout << "Hash collision between lengths" << std::endl;
+    return 1;
+  }
+  uint64_t h = tf_cpp::hash_bytes(bytes.data(), bytes.size());
+  for (std::size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] ^= 1;
+    if (tf_cpp::hash_bytes(bytes.data(), bytes.size()) == h) {
+      std::cout << "Hash ignores byte " << i << std::endl;
+      return 2;
+    }
+    bytes[i] ^= 1;
+  }
+  if (tf_cpp::hash_bytes(bytes.data(), bytes.size()) != h ||
+      tf_cpp::hash_bytes(bytes.data(), bytes.size(), 1) == h) {
+    std::cout << "Wrong seed handling" << std::endl;
+    return 3;
+  }
+
+  // tensors with the same bytes and another shape differ.
+  std::vector<float> values(6, 1.0f);
+  auto a = tf_utils::CreateTensor(TF_FLOAT, {2, 3}, values);
+  auto b = tf_utils::CreateTensor(TF_FLOAT, {3, 2}, values);
+  auto c = tf_utils::CreateTensor(TF_FLOAT, {2, 3}, values);
+  SCOPE_EXIT{ tf_utils::DeleteTensors({a, b, c}); };
+  if (tf_cpp::hash_tensor(a) != tf_cpp::hash_tensor(c)) {
+    std::cout << "Wrong hash of equal tensors" << std::endl;
+    return 4;
+  }
+  if (tf_cpp::hash_tensor(a) == tf_cpp::hash_tensor(b)) {
+    std::cout << "Hash ignores the shape" << std::endl;
+    return 5;
+  }
+
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "a", TF_FLOAT, {-1, -1});
+  tf_cpp::Tensor first(graph, "a:0", {2, 3}, TF_FLOAT);
+
+  // "name:i" binds to output i, outputs past the last one are an error.
+  try {
+    tf_cpp::Tensor second(graph, "a:1", {2, 3}, TF_FLOAT);
+    std::cout << "Missing output accepted" << std::endl;
+    return 6;
+  } catch (const std::runtime_error&) {
+  }
+
+  std::cout << "Success hash" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include "inference_server.h"
+#include "model.h"
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+int main() {
+  tf_cpp::Model model("graph.pb");
+  tf_cpp::InferenceServerOptions options;
+  options.socket_path = "inference_server_test.sock";
+  options.inputs = {"input_4"};
+  options.outputs = {"output_node0"};
+  tf_cpp::InferenceServer server(model, options);
+  std::thread loop([&]() { server.serve(); });
+
+  tf_cpp::WireTensor input;
+  input.dtype = TF_FLOAT;
+  input.shape = {1, 5, 12};
+  input.data.resize(60 * sizeof(float));
+  std::vector<tf_cpp::WireTensor> outputs;
+  {
+    tf_cpp::InferenceClient client(options.socket_path);
+    outputs = client.run({input});
+    // the pooled input tensors are reused by the next request.
+    auto again = client.run({input});
+    if (outputs.size() != 1 || outputs[0].dtype != TF_FLOAT ||
+        outputs[0].data.empty() || again[0].data != outputs[0].data) {
+      std::cout << "Wrong response" << std::endl;
+      return 1;
+    }
+  }
+
+  // a request the graph does not take closes the connection.
+  {
+    tf_cpp::InferenceClient client(options.socket_path);
+    input.shape = {1, 5, 13};
+    input.data.resize(65 * sizeof(float));
+    try {
+      client.run({input});
+      std::cout << "Malformed request was served" << std::endl;
+      return 2;
+    } catch (const std::runtime_error&) {
+    }
+  }
+
+  server.stop();
+  loop.join();
+  auto stats = server.stats();
+  if (stats.connections != 2 || stats.requests != 2 ||
+      stats.protocol_errors != 1) {
+    std::cout << "Wrong stats" << std::endl;
+    return 3;
+  }
+
+  std::cout << "Success serving a model over a Unix socket" << std::endl;
+  return 0;
+}
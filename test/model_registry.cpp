@@ -0,0 +1,124 @@
+#include "model_registry.h"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+int main() {
+  // the footprint of graph.pb, to size the budgets below.
+  std::size_t footprint;
+  {
+    tf_cpp::ModelRegistry registry;
+    registry.add("a", "graph.pb");
+    registry.get("a");
+    footprint = registry.footprint("a");
+  }
+  if (footprint == 0) {
+    std::cout << "Loaded model has no footprint" << std::endl;
+    return 1;
+  }
+
+  // room for two models.
+  tf_cpp::ModelRegistryOptions options;
+  options.memory_budget = 2 * footprint + footprint / 2;
+  options.predict = false;
+  tf_cpp::ModelRegistry registry(options);
+  registry.add("a", "graph.pb");
+  registry.add("b", "graph.pb");
+  registry.add("c", "graph.pb");
+  auto a = registry.get("a");
+  if (registry.get("a") != a) {
+    std::cout << "Loaded model was loaded again" << std::endl;
+    return 2;
+  }
+  registry.get("b");
+  registry.get("c");
+  if (registry.resident("a") || !registry.resident("b") ||
+      !registry.resident("c")) {
+    std::cout << "Least recently used model was not evicted" << std::endl;
+    return 3;
+  }
+  auto stats = registry.stats();
+  if (stats.loads != 3 || stats.hits != 1 || stats.evictions != 1 ||
+      stats.resident != 2 || stats.bytes != 2 * footprint) {
+    std::cout << "Wrong stats" << std::endl;
+    return 4;
+  }
+  // an evicted model stays usable by the callers that hold it.
+  if (a->get_graph() == nullptr) {
+    std::cout << "Evicted model was destroyed" << std::endl;
+    return 5;
+  }
+
+  // b is the least recently used now.
+  registry.get("c");
+  registry.get("a");
+  if (registry.resident("b") || !registry.resident("a")) {
+    std::cout << "Wrong model was evicted" << std::endl;
+    return 6;
+  }
+
+  // a peak too large for two models leaves room for one.
+  registry.observe_peak("c", footprint);
+  if (registry.resident("a") || registry.stats().evictions != 3) {
+    std::cout << "Observed peak did not evict" << std::endl;
+    return 7;
+  }
+
+  // b is known not to fit next to c, prefetching it would evict c.
+  registry.prefetch("b");
+  if (registry.resident("b") || !registry.resident("c") ||
+      registry.stats().prefetches != 0) {
+    std::cout << "Prefetch evicted a more recently used model" << std::endl;
+    return 8;
+  }
+
+  auto wait_loads = [](tf_cpp::ModelRegistry& r, std::size_t loads) {
+    auto start = std::chrono::steady_clock::now();
+    while (r.stats().loads != loads &&
+           std::chrono::steady_clock::now() - start <
+               std::chrono::seconds(10)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  };
+
+  // room for one model. b was never loaded, so it is prefetched, and then
+  // evicted itself instead of a.
+  options.memory_budget = footprint + footprint / 2;
+  tf_cpp::ModelRegistry small(options);
+  small.add("a", "graph.pb");
+  small.add("b", "graph.pb");
+  small.get("a");
+  small.prefetch("b");
+  wait_loads(small, 2);
+  if (!small.resident("a") || small.resident("b") ||
+      small.stats().prefetches != 1) {
+    std::cout << "Prefetched model evicted a model in use" << std::endl;
+    return 9;
+  }
+
+  // with room for both the prefetched model stays.
+  options.memory_budget = 2 * footprint + footprint / 2;
+  tf_cpp::ModelRegistry large(options);
+  large.add("a", "graph.pb");
+  large.add("b", "graph.pb");
+  large.get("a");
+  large.prefetch("b");
+  wait_loads(large, 2);
+  if (!large.resident("a") || !large.resident("b") ||
+      large.stats().prefetches != 1) {
+    std::cout << "Prefetched model was not loaded" << std::endl;
+    return 10;
+  }
+
+  try {
+    registry.get("d");
+    std::cout << "Unknown model did not throw" << std::endl;
+    return 11;
+  } catch (const std::runtime_error&) {
+  }
+
+  std::cout << "Success loading models within a memory budget" << std::endl;
+  return 0;
+}
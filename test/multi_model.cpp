@@ -0,0 +1,94 @@
+#include "multi_model.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// y = <type>(x), x is {1, 4} float.
+void WriteGraph(const std::string& filename, const char* type) {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT{ TF_DeleteStatus(status); };
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); };
+  auto x = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, 4});
+  auto desc = TF_NewOperation(graph, type, "y");
+  TF_AddInput(desc, {x, 0});
+  TF_SetAttrType(desc, "T", TF_FLOAT);
+  TF_FinishOperation(desc, status);
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT{ TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char*>(buffer->data), buffer->length);
+}
+
+int main() {
+  WriteGraph("multi_neg.pb", "Neg");
+  WriteGraph("multi_square.pb", "Square");
+
+  std::vector<tf_cpp::ModelFile> files = {{"neg", "multi_neg.pb"},
+                                           {"square", "multi_square.pb"}};
+  tf_cpp::MultiModel models(files);
+  if (models.models() != std::vector<std::string>{"neg", "square"} ||
+      models.name("square", "y") != "square/y") {
+    std::cout << "Wrong model names" << std::endl;
+    return 1;
+  }
+  try {
+    models.name("cube", "y");
+    std::cout << "Unknown model accepted" << std::endl;
+    return 2;
+  } catch (const std::runtime_error&) {
+  }
+
+  // both models in one run, each with its own input.
+  auto neg_x = models.tensor("neg", "x", {1, 4}, TF_FLOAT);
+  auto neg_y = models.tensor("neg", "y", {1, 4}, TF_FLOAT);
+  auto square_x = models.tensor("square", "x", {1, 4}, TF_FLOAT);
+  auto square_y = models.tensor("square", "y", {1, 4}, TF_FLOAT);
+  for (int i = 0; i < 4; ++i) {
+    neg_x.at<float>(0, i) = i;
+    square_x.at<float>(0, i) = i + 1;
+  }
+  models.run({&neg_x, &square_x}, {&neg_y, &square_y});
+  for (int i = 0; i < 4; ++i) {
+    if (neg_y.at<float>(0, i) != -i ||
+        square_y.at<float>(0, i) != (i + 1) * (i + 1)) {
+      std::cout << "Wrong outputs" << std::endl;
+      return 3;
+    }
+  }
+
+  // a subset of the models only needs its own inputs.
+  square_x.set_zero();
+  models.run({&square_x}, {&square_y});
+  if (square_y.at<float>(0, 3) != 0) {
+    std::cout << "Wrong output of one model" << std::endl;
+    return 4;
+  }
+
+  // no models, duplicate or empty names and a prefix are rejected.
+  tf_cpp::ModelOptions prefixed;
+  prefixed.prefix = "all";
+  std::vector<std::pair<std::vector<tf_cpp::ModelFile>, tf_cpp::ModelOptions>>
+      bad = {{{}, {}},
+             {{{"neg", "multi_neg.pb"}, {"neg", "multi_square.pb"}}, {}},
+             {{{"", "multi_neg.pb"}}, {}},
+             {{{"neg", "multi_neg.pb"}}, prefixed}};
+  for (auto& b : bad) {
+    try {
+      tf_cpp::MultiModel model(b.first, b.second);
+      std::cout << "Bad models accepted" << std::endl;
+      return 5;
+    } catch (const std::runtime_error&) {
+    }
+  }
+
+  std::cout << "Success multi model" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,205 @@
+#include "npy_dataset.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// a .npy file of header_dict and data, padded to 64 bytes as np.save does.
+static std::string Npy(const std::string& header_dict, const std::string& data) {
+  std::string header = header_dict;
+  while ((10 + header.size() + 1) % 64 != 0) header.push_back(' ');
+  header.push_back('\n');
+  std::string npy("\x93NUMPY\x01\x00", 8);
+  npy.push_back(static_cast<char>(header.size() & 0xff));
+  npy.push_back(static_cast<char>(header.size() >> 8));
+  return npy + header + data;
+}
+
+template <typename T>
+static void Put(std::string* s, T value) {
+  s->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// a stored .npz file, as np.savez writes it without zip64.
+static std::string Npz(const std::vector<std::pair<std::string, std::string>>& members) {
+  std::string zip, directory;
+  for (auto& m : members) {
+    uint32_t local = static_cast<uint32_t>(zip.size());
+    auto size = static_cast<uint32_t>(m.second.size());
+    auto name_len = static_cast<uint16_t>(m.first.size());
+    Put<uint32_t>(&zip, 0x04034b50);
+    Put<uint16_t>(&zip, 20);
+    Put<uint16_t>(&zip, 0);
+    Put<uint16_t>(&zip, 0);  // stored.
+    Put<uint32_t>(&zip, 0);
+    Put<uint32_t>(&zip, 0);  // the reader does not check the crc.
+    Put<uint32_t>(&zip, size);
+    Put<uint32_t>(&zip, size);
+    Put<uint16_t>(&zip, name_len);
+    Put<uint16_t>(&zip, 0);
+    zip += m.first + m.second;
+
+    Put<uint32_t>(&directory, 0x02014b50);
+    Put<uint16_t>(&directory, 20);
+    Put<uint16_t>(&directory, 20);
+    Put<uint16_t>(&directory, 0);
+    Put<uint16_t>(&directory, 0);
+    Put<uint32_t>(&directory, 0);
+    Put<uint32_t>(&directory, 0);
+    Put<uint32_t>(&directory, size);
+    Put<uint32_t>(&directory, size);
+    Put<uint16_t>(&directory, name_len);
+    Put<uint16_t>(&directory, 0);
+    Put<uint16_t>(&directory, 0);
+    Put<uint16_t>(&directory, 0);
+    Put<uint16_t>(&directory, 0);
+    Put<uint32_t>(&directory, 0);
+    Put<uint32_t>(&directory, local);
+    directory += m.first;
+  }
+  auto cd_offset = static_cast<uint32_t>(zip.size());
+  zip += directory;
+  Put<uint32_t>(&zip, 0x06054b50);
+  Put<uint16_t>(&zip, 0);
+  Put<uint16_t>(&zip, 0);
+  Put<uint16_t>(&zip, static_cast<uint16_t>(members.size()));
+  Put<uint16_t>(&zip, static_cast<uint16_t>(members.size()));
+  Put<uint32_t>(&zip, static_cast<uint32_t>(directory.size()));
+  Put<uint32_t>(&zip, cd_offset);
+  Put<uint16_t>(&zip, 0);
+  return zip;
+}
+
+static void Write(const std::string& filename, const std::string& bytes) {
+  std::ofstream out(filename, std::ios::binary);
+  out.write(bytes.data(), bytes.size());
+}
+
+static bool Rejected(const std::string& filename, const std::string& bytes) {
+  Write(filename, bytes);
+  try {
+    tf_cpp::NpyDataset dataset(filename);
+    return false;
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+}
+
+int main() {
+  char dir_template[] = "/tmp/npy_dataset_XXXXXX";
+  const std::string dir = mkdtemp(dir_template);
+  const std::string npy = dir + "/x.npy";
+  const std::string npz = dir + "/xy.npz";
+  const std::string bad = dir + "/bad.npy";
+
+  // 4 rows of 3 floats, and 2 rows of 2 int64.
+  std::vector<float> x(12);
+  for (int i = 0; i != 12; ++i) x[i] = i * 0.5f;
+  std::vector<int64_t> y = {1, -2, 3, -4};
+  const std::string x_data(reinterpret_cast<const char*>(x.data()), 12 * sizeof(float));
+  const std::string y_data(reinterpret_cast<const char*>(y.data()), 4 * sizeof(int64_t));
+  const std::string x_header = "{'descr': '<f4', 'fortran_order': False, 'shape': (4, 3), }";
+  const std::string y_header = "{'descr': '<i8', 'fortran_order': False, 'shape': (2, 2), }";
+  Write(npy, Npy(x_header, x_data));
+  Write(npz, Npz({{"x.npy", Npy(x_header, x_data)}, {"y.npy", Npy(y_header, y_data)}}));
+
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {-1, 3});
+  tf_utils::AddPlaceholder(graph, "y", TF_INT64, {-1, 2});
+  tf_utils::AddPlaceholder(graph, "w", TF_FLOAT, {-1, 4});
+
+  // the slices point into the mapping, which outlives the dataset.
+  tf_cpp::Tensor rows(graph, "x", {2, 3}, TF_FLOAT);
+  tf_cpp::Tensor last(graph, "x", {2, 3}, TF_FLOAT);
+  {
+    tf_cpp::NpyDataset dataset(npy);
+    if (dataset.dtype() != TF_FLOAT || dataset.shape() != std::vector<int64_t>{4, 3} ||
+        dataset.row_bytes() != 12) {
+      std::cout << "Wrong npy dtype or shape" << std::endl;
+      return 1;
+    }
+    dataset.slice(1, 2, &rows);
+    // clipped at the end.
+    dataset.slice(3, 2, &last);
+  }
+  if (rows.shape() != std::vector<int64_t>{2, 3} || last.shape() != std::vector<int64_t>{1, 3} ||
+      rows.data<float>()[0] != x[3] || rows.data<float>()[5] != x[8] ||
+      last.data<float>()[2] != x[11]) {
+    std::cout << "Wrong slice" << std::endl;
+    return 2;
+  }
+
+  // dtype, shape and range are checked against the tensor.
+  tf_cpp::NpyDataset dataset(npy);
+  tf_cpp::Tensor ints(graph, "y", {1, 2}, TF_INT64);
+  tf_cpp::Tensor wide(graph, "w", {1, 4}, TF_FLOAT);
+  try {
+    dataset.slice(0, 1, &ints);
+    std::cout << "Wrong dtype accepted" << std::endl;
+    return 3;
+  } catch (const std::runtime_error&) {
+  }
+  try {
+    dataset.slice(0, 1, &wide);
+    std::cout << "Wrong shape accepted" << std::endl;
+    return 3;
+  } catch (const std::runtime_error&) {
+  }
+  try {
+    dataset.slice(4, 1, &rows);
+    std::cout << "Slice out of range accepted" << std::endl;
+    return 4;
+  } catch (const std::runtime_error&) {
+  }
+
+  // a member of a stored npz, by name.
+  tf_cpp::NpyDataset member(npz, "y");
+  if (member.dtype() != TF_INT64 || member.shape() != std::vector<int64_t>{2, 2}) {
+    std::cout << "Wrong npz member" << std::endl;
+    return 5;
+  }
+  member.slice(1, 1, &ints);
+  // npz members are not aligned, tensorflow copies them.
+  int64_t row[2];
+  std::memcpy(row, ints.data<int64_t>(), sizeof(row));
+  if (row[0] != 3 || row[1] != -4) {
+    std::cout << "Wrong npz slice" << std::endl;
+    return 6;
+  }
+  try {
+    tf_cpp::NpyDataset missing(npz, "z");
+    std::cout << "Missing npz member accepted" << std::endl;
+    return 7;
+  } catch (const std::runtime_error&) {
+  }
+
+  // malformed files.
+  if (!Rejected(bad, "not an array") ||
+      !Rejected(bad, Npy("{'descr': '<f4', 'fortran_order': True, 'shape': (4, 3), }", x_data)) ||
+      !Rejected(bad, Npy("{'descr': '<f4', 'fortran_order': False, }", x_data)) ||
+      !Rejected(bad, Npy("{'descr': '<U4', 'fortran_order': False, 'shape': (4, 3), }", x_data)) ||
+      !Rejected(bad, Npy(x_header, x_data.substr(0, 20))) ||
+      !Rejected(bad, Npy(x_header, x_data).substr(0, 40)) ||
+      !Rejected(bad, Npz({{"x.npy", Npy(x_header, x_data)}}).substr(0, 60))) {
+    std::cout << "Malformed file accepted" << std::endl;
+    return 8;
+  }
+
+  std::remove(npy.c_str());
+  std::remove(npz.c_str());
+  std::remove(bad.c_str());
+  rmdir(dir.c_str());
+
+  std::cout << "Success reading npy datasets" << std::endl;
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include "model.h"
+#include "partial_run.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TF_Operation* AddOp(TF_Graph* graph, const char* type, const char* name,
+                    const std::vector<TF_Operation*>& inputs,
+                    TF_Status* status) {
+  auto desc = TF_NewOperation(graph, type, name);
+  for (auto input : inputs) {
+    TF_AddInput(desc, {input, 0});
+  }
+  TF_SetAttrType(desc, "T", TF_FLOAT);
+  return TF_FinishOperation(desc, status);
+}
+
+int main() {
+  // h = -x, head_a = h + a, head_b = h * b.
+  {
+    auto status = TF_NewStatus();
+    SCOPE_EXIT{ TF_DeleteStatus(status); };
+    TF_Graph* graph = TF_NewGraph();
+    SCOPE_EXIT{ tf_utils::DeleteGraph(graph); };
+    auto x = tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, 4});
+    auto a = tf_utils::AddPlaceholder(graph, "a", TF_FLOAT, {1, 4});
+    auto b = tf_utils::AddPlaceholder(graph, "b", TF_FLOAT, {1, 4});
+    auto h = AddOp(graph, "Neg", "h", {x}, status);
+    AddOp(graph, "AddV2", "head_a", {h, a}, status);
+    AddOp(graph, "Mul", "head_b", {h, b}, status);
+    auto buffer = TF_NewBuffer();
+    SCOPE_EXIT{ TF_DeleteBuffer(buffer); };
+    TF_GraphToGraphDef(graph, buffer, status);
+    if (TF_GetCode(status) != TF_OK) {
+      std::cout << "Error building graph: " << TF_Message(status) << std::endl;
+      return 1;
+    }
+    std::ofstream("partial_run.pb", std::ios::binary)
+        .write(static_cast<const char*>(buffer->data), buffer->length);
+  }
+
+  tf_cpp::Model model("partial_run.pb");
+  tf_cpp::Tensor x(model.get_graph(), "x", {1, 4}, TF_FLOAT);
+  tf_cpp::Tensor a(model.get_graph(), "a", {1, 4}, TF_FLOAT);
+  tf_cpp::Tensor b(model.get_graph(), "b", {1, 4}, TF_FLOAT);
+  tf_cpp::Tensor h(model.get_graph(), "h", {1, 4}, TF_FLOAT);
+  tf_cpp::Tensor head_a(model.get_graph(), "head_a", {1, 4}, TF_FLOAT);
+  tf_cpp::Tensor head_b(model.get_graph(), "head_b", {1, 4}, TF_FLOAT);
+  for (int i = 0; i < 4; ++i) {
+    x.at<float>(0, i) = i;
+    a.at<float>(0, i) = 10;
+    b.at<float>(0, i) = 2;
+  }
+
+  // the second head is fed after the first one is fetched.
+  {
+    tf_cpp::PartialRun run(model, {&x, &a, &b}, {&head_a, &head_b});
+    run.run({&x, &a}, {&head_a});
+    for (int i = 0; i < 4; ++i) {
+      if (head_a.at<float>(0, i) != 10 - i) {
+        std::cout << "Wrong first head" << std::endl;
+        return 2;
+      }
+    }
+    run.run({&b}, {&head_b});
+    for (int i = 0; i < 4; ++i) {
+      if (head_b.at<float>(0, i) != -2 * i) {
+        std::cout << "Wrong second head" << std::endl;
+        return 3;
+      }
+    }
+  }
+
+  // a fetch that was not declared in the setup is an error.
+  {
+    tf_cpp::PartialRun run(model, {&x}, {&head_a});
+    try {
+      run.run({&x}, {&h});
+      std::cout << "Undeclared fetch accepted" << std::endl;
+      return 4;
+    } catch (const std::runtime_error&) {
+    }
+  }
+
+  // so is feeding an input twice.
+  {
+    tf_cpp::PartialRun run(model, {&x, &a}, {&head_a});
+    run.run({&x}, {});
+    try {
+      run.run({&x, &a}, {&head_a});
+      std::cout << "Input fed twice" << std::endl;
+      return 5;
+    } catch (const std::runtime_error&) {
+    }
+  }
+
+  std::cout << "Success partial run" << std::endl;
+
+  return 0;
+}
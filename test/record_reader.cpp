@@ -0,0 +1,174 @@
+#include "record_reader.h"
+#include "scope_guard.h"
+#include "simd.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static void PutVarint(std::string* s, uint64_t v) {
+  while (v >= 0x80) {
+    s->push_back(static_cast<char>(v | 0x80));
+    v >>= 7;
+  }
+  s->push_back(static_cast<char>(v));
+}
+
+static void PutBytes(std::string* s, int field, const std::string& bytes) {
+  PutVarint(s, (field << 3) | 2);
+  PutVarint(s, bytes.size());
+  s->append(bytes);
+}
+
+static void PutFixed32(std::string* s, int field, float f) {
+  PutVarint(s, (field << 3) | 5);
+  s->append(reinterpret_cast<const char*>(&f), sizeof(f));
+}
+
+// an Example of one feature, list_field 2 is a FloatList, 3 an Int64List.
+static std::string Example(const std::string& name, int list_field,
+                           const std::string& list) {
+  std::string feature, entry, features, example;
+  PutBytes(&feature, list_field, list);
+  PutBytes(&entry, 1, name);
+  PutBytes(&entry, 2, feature);
+  PutBytes(&features, 1, entry);
+  PutBytes(&example, 1, features);
+  return example;
+}
+
+// the first row read from a file holding record, with the schema of spec.
+template <typename T>
+static std::vector<T> ReadOne(TF_Graph* graph, const std::string& record,
+                              const tf_cpp::FeatureSpec& spec,
+                              const std::string& op) {
+  {
+    tf_cpp::RecordWriter writer("record_reader_test.tfrecord");
+    writer.write(record);
+  }
+  tf_cpp::RecordReaderOptions options;
+  options.verify_crc = true;
+  options.num_threads = 1;
+  tf_cpp::RecordReader reader({"record_reader_test.tfrecord"}, {spec},
+                              options);
+  tf_cpp::Tensor batch(graph, op, {1, spec.size}, spec.dtype);
+  if (reader.next_batch({&batch}) != 1) {
+    throw std::runtime_error("no record read.");
+  }
+  return std::vector<T>(batch.data<T>(), batch.data<T>() + spec.size);
+}
+
+int main() {
+  // the crc32c check value, and lengths around the 8 byte steps against the
+  // scalar tables, at every level.
+  const char* check = "123456789";
+  std::string data;
+  for (int i = 0; i != 100; ++i) data.push_back(static_cast<char>(i * 37));
+  const auto best = tf_cpp::simd_level();
+  tf_cpp::set_simd_level(tf_cpp::SimdLevel::kScalar);
+  std::vector<uint32_t> scalar;
+  for (std::size_t n = 0; n <= 40; ++n) {
+    scalar.push_back(tf_cpp::crc32c(data.data() + 3, n));
+  }
+  for (int l = 0; l <= static_cast<int>(best); ++l) {
+    tf_cpp::set_simd_level(static_cast<tf_cpp::SimdLevel>(l));
+    bool ok = tf_cpp::crc32c(check, 9) == 0xE3069283u &&
+              tf_cpp::crc32c(check, 0) == 0;
+    for (std::size_t n = 0; n <= 40; ++n) {
+      ok = ok && tf_cpp::crc32c(data.data() + 3, n) == scalar[n];
+    }
+    if (!ok) {
+      std::cout << "Wrong crc32c at level "
+                << tf_cpp::simd_level_name(tf_cpp::simd_level()) << std::endl;
+      return 1;
+    }
+  }
+  tf_cpp::set_simd_level(best);
+
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "f", TF_FLOAT, {-1, 3});
+  tf_utils::AddPlaceholder(graph, "i", TF_INT64, {-1, 3});
+  const tf_cpp::FeatureSpec floats{"x", TF_FLOAT, 3};
+  const tf_cpp::FeatureSpec ints{"x", TF_INT64, 3};
+  const std::vector<float> want_floats = {1.5f, -2, 0.25f};
+  const std::vector<int64_t> want_ints = {7, -1, 300};
+
+  // packed and unpacked lists decode to the same rows.
+  std::string packed_floats, unpacked_floats, packed_ints, unpacked_ints;
+  PutBytes(&packed_floats, 1,
+           std::string(reinterpret_cast<const char*>(want_floats.data()),
+                       want_floats.size() * sizeof(float)));
+  for (auto f : want_floats) PutFixed32(&unpacked_floats, 1, f);
+  std::string varints;
+  for (auto i : want_ints) PutVarint(&varints, static_cast<uint64_t>(i));
+  PutBytes(&packed_ints, 1, varints);
+  for (auto i : want_ints) {
+    PutVarint(&unpacked_ints, 1 << 3);
+    PutVarint(&unpacked_ints, static_cast<uint64_t>(i));
+  }
+  if (ReadOne<float>(graph, Example("x", 2, packed_floats), floats, "f") !=
+          want_floats ||
+      ReadOne<float>(graph, Example("x", 2, unpacked_floats), floats, "f") !=
+          want_floats) {
+    std::cout << "Wrong float list" << std::endl;
+    return 2;
+  }
+  if (ReadOne<int64_t>(graph, Example("x", 3, packed_ints), ints, "i") !=
+          want_ints ||
+      ReadOne<int64_t>(graph, Example("x", 3, unpacked_ints), ints, "i") !=
+          want_ints) {
+    std::cout << "Wrong int64 list" << std::endl;
+    return 3;
+  }
+
+  // an int64 list where a float list is expected.
+  try {
+    ReadOne<float>(graph, Example("x", 3, packed_ints), floats, "f");
+    std::cout << "Type mismatch accepted" << std::endl;
+    return 4;
+  } catch (const std::runtime_error&) {
+  }
+
+  // two values where three are expected.
+  std::string short_list;
+  PutBytes(&short_list, 1, std::string(8, '\0'));
+  try {
+    ReadOne<float>(graph, Example("x", 2, short_list), floats, "f");
+    std::cout << "Wrong value count accepted" << std::endl;
+    return 5;
+  } catch (const std::runtime_error&) {
+  }
+
+  // a record cut short in the file.
+  {
+    tf_cpp::RecordWriter writer("record_reader_test.tfrecord");
+    writer.write(Example("x", 2, packed_floats));
+  }
+  std::string file;
+  {
+    std::ifstream in("record_reader_test.tfrecord", std::ios::binary);
+    file.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  {
+    std::ofstream out("record_reader_test.tfrecord", std::ios::binary);
+    out.write(file.data(), file.size() - 6);
+  }
+  try {
+    tf_cpp::RecordReader reader({"record_reader_test.tfrecord"}, {floats});
+    tf_cpp::Tensor batch(graph, "f", {1, 3}, TF_FLOAT);
+    reader.next_batch({&batch});
+    std::cout << "Truncated record accepted" << std::endl;
+    return 6;
+  } catch (const std::runtime_error&) {
+  }
+  std::remove("record_reader_test.tfrecord");
+
+  std::cout << "Success reading records" << std::endl;
+  return 0;
+}
@@ -0,0 +1,125 @@
+#include "model.h"
+#include "result_cache.h"
+#include "shared_tensor.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include "scope_guard.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {1, 256});
+  tf_utils::AddPlaceholder(graph, "y", TF_FLOAT, {1, 256});
+
+  // a result of 1KB.
+  auto result = [&](float value) {
+    tf_cpp::Tensor t(graph, "y", {1, 256}, TF_FLOAT);
+    std::fill_n(t.data<float>(), 256, value);
+    return std::vector<tf_cpp::SharedTensor>{tf_cpp::SharedTensor(std::move(t))};
+  };
+
+  // the key depends on the model, the input bytes and the outputs.
+  tf_cpp::Model model("graph.pb");
+  tf_cpp::Model other("graph.pb");
+  tf_cpp::Tensor x(graph, "x", {1, 256}, TF_FLOAT);
+  tf_cpp::Tensor y(graph, "y", {1, 256}, TF_FLOAT);
+  x.set_zero();
+  auto key = tf_cpp::ResultCache::request_key(model, {&x}, {&y});
+  if (key != tf_cpp::ResultCache::request_key(model, {&x}, {&y}) ||
+      key == tf_cpp::ResultCache::request_key(model, {&x}, {&x}) ||
+      key == tf_cpp::ResultCache::request_key(other, {&x}, {&y})) {
+    std::cout << "Wrong request key" << std::endl;
+    return 1;
+  }
+  x.at<float>(0, 7) = 1;
+  if (key == tf_cpp::ResultCache::request_key(model, {&x}, {&y})) {
+    std::cout << "Request key ignores the input" << std::endl;
+    return 2;
+  }
+
+  // room for three results, plain LRU.
+  tf_cpp::ResultCacheOptions options;
+  options.shards = 1;
+  options.max_bytes = 3 * 1200;
+  options.admission = false;
+  tf_cpp::ResultCache cache(options);
+  std::vector<tf_cpp::SharedTensor> results;
+  for (int k = 0; k < 3; ++k) cache.insert(k, result(k));
+  if (!cache.lookup(0, results) || results[0].data<float>()[0] != 0) {
+    std::cout << "Wrong hit" << std::endl;
+    return 3;
+  }
+  // 1 is the least recently used now.
+  cache.insert(3, result(3));
+  if (cache.lookup(1, results) || !cache.lookup(0, results) ||
+      !cache.lookup(3, results)) {
+    std::cout << "Wrong LRU eviction" << std::endl;
+    return 4;
+  }
+  auto stats = cache.stats();
+  if (stats.hits != 3 || stats.misses != 1 || stats.evictions != 1 ||
+      stats.entries != 3) {
+    std::cout << "Wrong stats" << std::endl;
+    return 5;
+  }
+
+  // with admission a key seen once does not evict a popular one.
+  options.admission = true;
+  tf_cpp::ResultCache lfu(options);
+  for (int k = 0; k < 3; ++k) {
+    for (int i = 0; i < 3; ++i) lfu.lookup(k, results);
+    lfu.insert(k, result(k));
+  }
+  lfu.lookup(9, results);
+  lfu.insert(9, result(9));
+  if (lfu.lookup(9, results) || lfu.stats().rejections != 1) {
+    std::cout << "One off key admitted" << std::endl;
+    return 6;
+  }
+  for (int i = 0; i < 8; ++i) lfu.lookup(9, results);
+  lfu.insert(9, result(9));
+  if (!lfu.lookup(9, results)) {
+    std::cout << "Popular key rejected" << std::endl;
+    return 7;
+  }
+
+  // a candidate that needs two victims and loses to the second keeps both.
+  tf_cpp::ResultCache big(options);
+  big.lookup(10, results);
+  big.insert(10, result(10));
+  for (int k = 11; k < 13; ++k) {
+    for (int i = 0; i < 4; ++i) big.lookup(k, results);
+    big.insert(k, result(k));
+  }
+  auto two = result(20);
+  two.push_back(result(21)[0]);
+  for (int i = 0; i < 2; ++i) big.lookup(20, results);
+  big.insert(20, two);
+  if (big.lookup(20, results) || !big.lookup(10, results) ||
+      big.stats().evictions != 0) {
+    std::cout << "Rejected key evicted entries" << std::endl;
+    return 8;
+  }
+
+  // entries expire after the ttl.
+  options.ttl = std::chrono::milliseconds(20);
+  tf_cpp::ResultCache ttl(options);
+  ttl.insert(1, result(1));
+  if (!ttl.lookup(1, results)) {
+    std::cout << "Entry expired early" << std::endl;
+    return 9;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(40));
+  if (ttl.lookup(1, results) || ttl.stats().expirations != 1) {
+    std::cout << "Entry did not expire" << std::endl;
+    return 10;
+  }
+
+  std::cout << "Success result cache" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,45 @@
+#include "row_copy.h"
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+static bool RoundTrip(std::size_t n_rows, std::size_t row_bytes) {
+  // odd offsets, so the streaming stores see unaligned buffers.
+  std::vector<std::vector<char>> payloads(n_rows, std::vector<char>(row_bytes + 1));
+  std::vector<const void*> rows;
+  for (std::size_t i = 0; i < n_rows; ++i) {
+    for (std::size_t j = 0; j <= row_bytes; ++j) payloads[i][j] = static_cast<char>(i * 31 + j);
+    rows.push_back(payloads[i].data() + 1);
+  }
+  std::vector<char> batch(n_rows * row_bytes + 1);
+  tf_cpp::gather_rows(rows.data(), n_rows, row_bytes, batch.data() + 1);
+  for (std::size_t i = 0; i < n_rows; ++i) {
+    if (std::memcmp(batch.data() + 1 + i * row_bytes, rows[i], row_bytes) != 0) return false;
+  }
+
+  std::vector<std::vector<char>> results(n_rows, std::vector<char>(row_bytes + 1));
+  std::vector<void*> out_rows;
+  for (auto& r : results) out_rows.push_back(r.data() + 1);
+  tf_cpp::scatter_rows(batch.data() + 1, n_rows, row_bytes, out_rows.data());
+  for (std::size_t i = 0; i < n_rows; ++i) {
+    if (std::memcmp(out_rows[i], rows[i], row_bytes) != 0) return false;
+  }
+  return true;
+}
+
+int main() {
+  if (!RoundTrip(3, 17) || !RoundTrip(100, 4096) || !RoundTrip(700, 3000)) {
+    std::cout << "Wrong small rows" << std::endl;
+    return 1;
+  }
+  // large enough for the thread pool and the streaming stores.
+  if (!RoundTrip(3, (1 << 20) + 77) || !RoundTrip(2, (3 << 20) + 5)) {
+    std::cout << "Wrong huge rows" << std::endl;
+    return 2;
+  }
+
+  std::cout << "Success gather and scatter rows" << std::endl;
+
+  return 0;
+}
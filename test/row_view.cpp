@@ -0,0 +1,47 @@
+#include "tensor.h"
+#include "tf_utils.h"
+#include "scope_guard.h"
+#include <iostream>
+#include <vector>
+
+int main() {
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "output", TF_FLOAT, {-1, 2, 3});
+
+  std::vector<tf_cpp::RowView<float>> rows;
+  {
+    tf_cpp::Tensor output(graph, "output", {4, 2, 3}, TF_FLOAT);
+    float* data = output.data<float>();
+    for (int i = 0; i < 24; ++i) data[i] = static_cast<float>(i);
+    rows = output.take_rows<float>();
+
+    // the tensor is empty and can be filled again.
+    if (output.data<float>() == data) {
+      std::cout << "Tensor still owns the rows" << std::endl;
+      return 1;
+    }
+  }
+
+  // the views outlive the tensor.
+  if (rows.size() != 4) {
+    std::cout << "Wrong number of rows" << std::endl;
+    return 2;
+  }
+  for (std::size_t r = 0; r < rows.size(); ++r) {
+    if (rows[r].size() != 6) {
+      std::cout << "Wrong row size" << std::endl;
+      return 3;
+    }
+    for (std::size_t i = 0; i < 6; ++i) {
+      if (rows[r][i] != static_cast<float>(r * 6 + i)) {
+        std::cout << "Wrong value in row " << r << std::endl;
+        return 4;
+      }
+    }
+  }
+
+  std::cout << "Success take rows" << std::endl;
+
+  return 0;
+}
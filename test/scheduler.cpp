@@ -0,0 +1,64 @@
+#include "scheduler.h"
+#include "model.h"
+#include "tensor.h"
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+int main() {
+  tf_cpp::Model model("graph.pb");
+  tf_cpp::Tensor input(model.get_graph(), "input_4", {1, 5, 12}, TF_FLOAT);
+  tf_cpp::Tensor output(model.get_graph(), "output_node0", {1, 4}, TF_FLOAT);
+  input.set_zero();
+
+  tf_cpp::SchedulerOptions options;
+  options.classes = 2;
+  tf_cpp::Scheduler scheduler(options);
+  using Clock = tf_cpp::Scheduler::Clock;
+
+  scheduler.run(model, {&input}, {&output}, 1);
+  if (output.data<float>() == nullptr) {
+    std::cout << "Scheduled run has no output" << std::endl;
+    return 1;
+  }
+  scheduler.run(model, {&input}, {&output}, 0,
+                Clock::now() + std::chrono::seconds(10));
+
+  // a request past its deadline is dropped without a run.
+  auto late = scheduler.submit(model, {&input}, {&output}, 0,
+                               Clock::now() - std::chrono::milliseconds(1));
+  try {
+    late.get();
+    std::cout << "Late request was not dropped" << std::endl;
+    return 2;
+  } catch (const tf_cpp::DeadlineExceeded&) {
+  }
+  auto stats = scheduler.stats(0);
+  if (stats.runs != 1 || stats.dropped != 1 || scheduler.stats(1).runs != 1) {
+    std::cout << "Wrong stats" << std::endl;
+    return 3;
+  }
+
+  // queued requests of every class finish.
+  std::vector<std::future<void>> done;
+  for (int i = 0; i < 20; ++i) {
+    done.push_back(scheduler.submit(model, {&input}, {&output}, i % 2));
+  }
+  for (auto& d : done) d.get();
+  if (scheduler.stats(0).runs != 11 || scheduler.stats(1).runs != 11) {
+    std::cout << "Queued requests did not run" << std::endl;
+    return 4;
+  }
+
+  try {
+    scheduler.submit(model, {&input}, {&output}, 2);
+    std::cout << "Unknown class did not throw" << std::endl;
+    return 5;
+  } catch (const std::runtime_error&) {
+  }
+
+  std::cout << "Success scheduling runs by priority and deadline" << std::endl;
+  return 0;
+}
@@ -0,0 +1,81 @@
+#include "shared_tensor.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include "scope_guard.h"
+#include <iostream>
+#include <utility>
+#include <vector>
+
+int main() {
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "output", TF_FLOAT, {-1, 3});
+  tf_utils::AddPlaceholder(graph, "input", TF_FLOAT, {-1, 3});
+  tf_utils::AddPlaceholder(graph, "ids", TF_INT32, {-1, 3});
+
+  tf_cpp::Tensor output(graph, "output", {2, 3}, TF_FLOAT);
+  for (int i = 0; i < 6; ++i) output.data<float>()[i] = static_cast<float>(i);
+  tf_cpp::SharedTensor a(std::move(output));
+
+  // copies share the buffer.
+  tf_cpp::SharedTensor b = a;
+  if (a.use_count() != 2 || a.data<float>() != b.data<float>()) {
+    std::cout << "Copy does not share the buffer" << std::endl;
+    return 1;
+  }
+
+  // writing to a shared buffer copies it first.
+  b.mutable_data<float>()[0] = 42;
+  if (a.data<float>() == b.data<float>() || a.data<float>()[0] != 0 || b.data<float>()[0] != 42 ||
+      b.data<float>()[5] != 5) {
+    std::cout << "Wrong copy on write" << std::endl;
+    return 2;
+  }
+
+  // a unique buffer is written in place.
+  const float* before = b.data<float>();
+  b.mutable_data<float>()[1] = 43;
+  if (b.data<float>() != before) {
+    std::cout << "Unique buffer was copied" << std::endl;
+    return 3;
+  }
+
+  // row views count as owners.
+  {
+    auto rows = a.rows<float>();
+    if (rows.size() != 2 || rows[1][2] != 5) {
+      std::cout << "Wrong rows" << std::endl;
+      return 4;
+    }
+    const float* shared = a.data<float>();
+    a.mutable_data<float>()[3] = 7;
+    if (a.data<float>() == shared || rows[1][0] != 3) {
+      std::cout << "Row view saw a write" << std::endl;
+      return 5;
+    }
+  }
+
+  tf_cpp::Tensor input(graph, "input", {2, 3}, TF_FLOAT);
+  tf_cpp::Tensor ids(graph, "ids", {2, 3}, TF_INT32);
+  auto bound = a.bind(input);
+  if (bound.get() != a.get() || bound.op().oper != TF_GraphOperationByName(graph, "input")) {
+    std::cout << "Wrong bind" << std::endl;
+    return 6;
+  }
+  try {
+    a.bind(ids);
+    std::cout << "Bind to wrong dtype accepted" << std::endl;
+    return 7;
+  } catch (const std::runtime_error&) {
+  }
+  try {
+    a.data<int32_t>();
+    std::cout << "Access in wrong dtype accepted" << std::endl;
+    return 8;
+  } catch (const std::runtime_error&) {
+  }
+
+  std::cout << "Success shared tensor" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include "model.h"
+#include "shm_transport.h"
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+int main() {
+  tf_cpp::Model model("graph.pb");
+  tf_cpp::ShmServerOptions options;
+  options.name = "/tf_cpp_shm_transport_test";
+  options.slots = 2;
+  options.slot_bytes = 4096;
+  options.inputs = {"input_4"};
+  options.outputs = {"output_node0"};
+  tf_cpp::ShmServer server(model, options);
+  std::thread loop([&]() { server.serve(); });
+
+  tf_cpp::WireTensor input;
+  input.dtype = TF_FLOAT;
+  input.shape = {1, 5, 12};
+  input.data.resize(60 * sizeof(float));
+  {
+    tf_cpp::ShmClient client(options.name);
+    auto outputs = client.run({input});
+    // the second request takes the other slot.
+    auto again = client.run({input});
+    if (outputs.size() != 1 || outputs[0].dtype != TF_FLOAT ||
+        outputs[0].data.empty() || again[0].data != outputs[0].data) {
+      std::cout << "Wrong response" << std::endl;
+      return 1;
+    }
+
+    // inputs that do not fit in a slot are refused by the client.
+    auto request = client.request();
+    try {
+      request.input(TF_FLOAT, {1, 1024, 12});
+      std::cout << "Oversized input was accepted" << std::endl;
+      return 2;
+    } catch (const std::runtime_error &) {
+    }
+    // so are strings, they have no fixed size.
+    try {
+      request.input(TF_STRING, {1});
+      std::cout << "String input was accepted" << std::endl;
+      return 2;
+    } catch (const std::runtime_error &) {
+    }
+
+    // a run the graph does not take fails with the message of the server.
+    input.shape = {1, 5, 13};
+    input.data.resize(65 * sizeof(float));
+    try {
+      client.run({input});
+      std::cout << "Malformed request was served" << std::endl;
+      return 3;
+    } catch (const std::runtime_error &) {
+    }
+  }
+
+  server.stop();
+  loop.join();
+  auto stats = server.stats();
+  if (stats.requests != 3 || stats.errors != 1) {
+    std::cout << "Wrong stats" << std::endl;
+    return 4;
+  }
+
+  std::cout << "Success serving a model through shared memory" << std::endl;
+  return 0;
+}
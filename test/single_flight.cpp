@@ -0,0 +1,85 @@
+#include "single_flight.h"
+#include "shared_tensor.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include "scope_guard.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+int main() {
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "y", TF_FLOAT, {1, 4});
+
+  tf_cpp::SingleFlight flight(8);
+  std::atomic<int> calls(0);
+  // a slow run, every thread arrives while it is in flight.
+  auto slow_run = [&]() {
+    ++calls;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    tf_cpp::Tensor y(graph, "y", {1, 4}, TF_FLOAT);
+    y.set_zero();
+    return std::vector<tf_cpp::SharedTensor>{tf_cpp::SharedTensor(std::move(y))};
+  };
+
+  const int n_threads = 8;
+  std::vector<const float*> data(n_threads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < n_threads; ++i) {
+    threads.emplace_back([&, i]() {
+      data[i] = flight.run(42, slow_run)[0].data<float>();
+    });
+  }
+  for (auto& t : threads) t.join();
+  if (calls != 1) {
+    std::cout << "Identical requests ran " << calls << " times" << std::endl;
+    return 1;
+  }
+  for (int i = 1; i < n_threads; ++i) {
+    if (data[i] != data[0]) {
+      std::cout << "Waiters do not share the results" << std::endl;
+      return 2;
+    }
+  }
+  auto stats = flight.stats();
+  if (stats.runs != 1 || stats.shared != n_threads - 1) {
+    std::cout << "Wrong stats" << std::endl;
+    return 3;
+  }
+
+  // nothing is kept after the run.
+  flight.run(42, slow_run);
+  if (calls != 2) {
+    std::cout << "Finished request was reused" << std::endl;
+    return 4;
+  }
+
+  // errors reach every waiter.
+  std::atomic<int> errors(0);
+  threads.clear();
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      try {
+        flight.run(7, [&]() -> std::vector<tf_cpp::SharedTensor> {
+          std::this_thread::sleep_for(std::chrono::milliseconds(200));
+          throw std::runtime_error("session error");
+        });
+      } catch (const std::runtime_error&) {
+        ++errors;
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+  if (errors != 4) {
+    std::cout << "Error did not reach every waiter" << std::endl;
+    return 5;
+  }
+
+  std::cout << "Success single flight" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,136 @@
+#include "model.h"
+#include "scope_guard.h"
+#include "tensor.h"
+#include "tf_utils.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TF_Operation* AddUnary(TF_Graph* graph, const char* type, const char* name,
+                       TF_Operation* x, TF_Status* status) {
+  auto desc = TF_NewOperation(graph, type, name);
+  TF_AddInput(desc, {x, 0});
+  TF_SetAttrType(desc, "T", TF_FLOAT);
+  return TF_FinishOperation(desc, status);
+}
+
+void WriteGraph(TF_Graph* graph, const std::string& filename,
+                TF_Status* status) {
+  auto buffer = TF_NewBuffer();
+  SCOPE_EXIT{ TF_DeleteBuffer(buffer); };
+  TF_GraphToGraphDef(graph, buffer, status);
+  std::ofstream(filename, std::ios::binary)
+      .write(static_cast<const char*>(buffer->data), buffer->length);
+}
+
+const std::vector<float> kRaw = {1, 2, 3, 4};
+
+bool Equal(tf_cpp::Tensor& y, const std::vector<float>& expected) {
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    if (y.data<float>()[i] != expected[i]) return false;
+  }
+  return true;
+}
+
+int main() {
+  auto status = TF_NewStatus();
+  SCOPE_EXIT{ TF_DeleteStatus(status); };
+
+  // preprocessing: double = raw + raw, neg = -raw.
+  {
+    TF_Graph* graph = TF_NewGraph();
+    SCOPE_EXIT{ tf_utils::DeleteGraph(graph); };
+    auto raw = tf_utils::AddPlaceholder(graph, "raw", TF_FLOAT, {1, 4});
+    auto desc = TF_NewOperation(graph, "AddV2", "double");
+    TF_AddInput(desc, {raw, 0});
+    TF_AddInput(desc, {raw, 0});
+    TF_SetAttrType(desc, "T", TF_FLOAT);
+    TF_FinishOperation(desc, status);
+    AddUnary(graph, "Neg", "neg", raw, status);
+    WriteGraph(graph, "splice_pre.pb", status);
+  }
+  // model: y = -input.
+  {
+    TF_Graph* graph = TF_NewGraph();
+    SCOPE_EXIT{ tf_utils::DeleteGraph(graph); };
+    auto input = tf_utils::AddPlaceholder(graph, "input", TF_FLOAT, {1, 4});
+    AddUnary(graph, "Neg", "y", input, status);
+    WriteGraph(graph, "splice_model.pb", status);
+  }
+  if (TF_GetCode(status) != TF_OK) {
+    std::cout << "Error building graphs: " << TF_Message(status) << std::endl;
+    return 1;
+  }
+
+  // the model input is mapped to pre/double, fed through pre/raw.
+  {
+    tf_cpp::ModelOptions options;
+    options.preprocess.push_back(
+        {"splice_pre.pb", "pre", {{"input", "double"}}});
+    tf_cpp::Model model("splice_model.pb", options);
+    tf_cpp::Tensor raw(model.get_graph(), "pre/raw", {1, 4}, TF_FLOAT);
+    tf_cpp::Tensor y(model.get_graph(), "y", {1, 4}, TF_FLOAT);
+    raw.fill_from(kRaw.data(), kRaw.size());
+    model.run({&raw}, {&y});
+    if (!Equal(y, {-2, -4, -6, -8})) {
+      std::cout << "Wrong spliced result" << std::endl;
+      return 2;
+    }
+  }
+
+  // names with output indices.
+  {
+    tf_cpp::ModelOptions options;
+    options.preprocess.push_back(
+        {"splice_pre.pb", "pre", {{"input:0", "neg:0"}}});
+    tf_cpp::Model model("splice_model.pb", options);
+    tf_cpp::Tensor raw(model.get_graph(), "pre/raw", {1, 4}, TF_FLOAT);
+    tf_cpp::Tensor y(model.get_graph(), "y", {1, 4}, TF_FLOAT);
+    raw.fill_from(kRaw.data(), kRaw.size());
+    model.run({&raw}, {&y});
+    if (!Equal(y, {1, 2, 3, 4})) {
+      std::cout << "Wrong mapping of indexed names" << std::endl;
+      return 3;
+    }
+  }
+
+  // no mapping, the graph sits next to the model and input is fed itself.
+  {
+    tf_cpp::ModelOptions options;
+    options.preprocess.push_back({"splice_pre.pb", "pre", {}});
+    tf_cpp::Model model("splice_model.pb", options);
+    if (TF_GraphOperationByName(model.get_graph(), "pre/neg") == nullptr) {
+      std::cout << "Preprocessing graph not imported" << std::endl;
+      return 4;
+    }
+    tf_cpp::Tensor input(model.get_graph(), "input", {1, 4}, TF_FLOAT);
+    tf_cpp::Tensor y(model.get_graph(), "y", {1, 4}, TF_FLOAT);
+    input.fill_from(kRaw.data(), kRaw.size());
+    model.run({&input}, {&y});
+    if (!Equal(y, {-1, -2, -3, -4})) {
+      std::cout << "Wrong result without mapping" << std::endl;
+      return 5;
+    }
+  }
+
+  // an empty prefix and an unknown output are rejected.
+  std::vector<tf_cpp::GraphSplice> bad = {
+      {"splice_pre.pb", "", {{"input", "double"}}},
+      {"splice_pre.pb", "pre", {{"input", "missing"}}}};
+  for (auto& splice : bad) {
+    tf_cpp::ModelOptions options;
+    options.preprocess.push_back(splice);
+    try {
+      tf_cpp::Model model("splice_model.pb", options);
+      std::cout << "Bad splice accepted" << std::endl;
+      return 6;
+    } catch (const std::runtime_error&) {
+    }
+  }
+
+  std::cout << "Success splicing graphs" << std::endl;
+
+  return 0;
+}
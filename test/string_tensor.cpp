@@ -0,0 +1,47 @@
+#include "tf_utils.h"
+#include "scope_guard.h"
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+int main() {
+  const std::vector<std::string_view> strings = {"", "a", "hello", std::string_view("with\0zero", 9),
+                                                 "a longer string that needs more than one byte of length prefix, "
+                                                 "a longer string that needs more than one byte of length prefix"};
+  const std::vector<std::int64_t> dims = {5};
+
+  auto tensor = tf_utils::CreateStringTensor(strings, dims);
+  SCOPE_EXIT{ tf_utils::DeleteTensor(tensor); }; // Auto-delete on scope exit.
+  if (tensor == nullptr) {
+    std::cout << "Wrong create string tensor" << std::endl;
+    return 1;
+  }
+
+  if (TF_TensorType(tensor) != TF_STRING || TF_NumDims(tensor) != 1 || TF_Dim(tensor, 0) != 5) {
+    std::cout << "Wrong tensor type or shape" << std::endl;
+    return 2;
+  }
+
+  auto result = tf_utils::GetStringTensorData(tensor);
+  if (result.size() != strings.size()) {
+    std::cout << "Wrong number of strings" << std::endl;
+    return 3;
+  }
+
+  for (std::size_t i = 0; i < strings.size(); ++i) {
+    if (result[i] != strings[i]) {
+      std::cout << "String: " << i << " does not match" << std::endl;
+      return 4;
+    }
+  }
+
+  if (tf_utils::CreateStringTensor(strings, {2, 2}) != nullptr) {
+    std::cout << "Wrong shape accepted" << std::endl;
+    return 5;
+  }
+
+  std::cout << "Success create string tensor" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include "scope_guard.h"
+#include "simd.h"
+#include "tensor.h"
+#include "text_parser.h"
+#include "tf_utils.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template <typename T>
+static bool Equals(tf_cpp::Tensor& tensor, const std::vector<int64_t>& shape, const std::vector<T>& values) {
+  if (tensor.shape() != shape) return false;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    if (tensor.data<T>()[i] != values[i]) return false;
+  }
+  return true;
+}
+
+static bool Fails(const tf_cpp::TextParser& parser, const std::string& text, bool json, tf_cpp::Tensor* tensor) {
+  try {
+    json ? parser.parse_json(text, tensor) : parser.parse_csv(text, tensor);
+  } catch (const std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+int main() {
+  TF_Graph* graph = TF_NewGraph();
+  SCOPE_EXIT{ tf_utils::DeleteGraph(graph); }; // Auto-delete on scope exit.
+  tf_utils::AddPlaceholder(graph, "x", TF_FLOAT, {-1, 3});
+  tf_utils::AddPlaceholder(graph, "d", TF_DOUBLE, {-1, 4});
+  tf_utils::AddPlaceholder(graph, "i", TF_INT64, {-1, 2});
+  tf_utils::AddPlaceholder(graph, "j", TF_INT32, {-1});
+
+  tf_cpp::TextParser floats({"x", TF_FLOAT, {-1, 3}});
+  tf_cpp::Tensor x(graph, "x", {-1, 3}, TF_FLOAT);
+  std::vector<float> expected = {1, 2.5f, -3e2f, 0.1f, 4, 5};
+  floats.parse_json("[[1, 2.5, -3e2],\n [0.1,4,5]]", &x);
+  if (!Equals(x, {2, 3}, expected)) {
+    std::cout << "Wrong nested json" << std::endl;
+    return 1;
+  }
+  floats.parse_json(" [1, 2.5, -3E+2, 0.1, 4, 5] ", &x);
+  if (!Equals(x, {2, 3}, expected)) {
+    std::cout << "Wrong flat json" << std::endl;
+    return 2;
+  }
+  floats.parse_csv("1, 2.5,-3e2\r\n\r\n0.1,4,5", &x);
+  if (!Equals(x, {2, 3}, expected)) {
+    std::cout << "Wrong csv" << std::endl;
+    return 3;
+  }
+
+  // long rows go through the vector scan and the eight digit steps, every
+  // number must round like strtod at every simd level.
+  std::string json = "[";
+  std::vector<double> doubles;
+  for (int i = 0; i < 1000; ++i) {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.17g", (i * 7919 % 1000 - 500) * 1.2345678901e-3 * (i % 5 ? 1 : 1e-30));
+    json += (i == 0 ? "" : ",") + std::string(number);
+    doubles.push_back(std::strtod(number, nullptr));
+  }
+  json += "]";
+  tf_cpp::TextParser parser({"d", TF_DOUBLE, {-1, 4}});
+  tf_cpp::Tensor d(graph, "d", {-1, 4}, TF_DOUBLE);
+  const auto best = tf_cpp::simd_level();
+  for (int l = 0; l <= static_cast<int>(best); ++l) {
+    tf_cpp::set_simd_level(static_cast<tf_cpp::SimdLevel>(l));
+    parser.parse_json(json, &d);
+    if (!Equals(d, {250, 4}, doubles)) {
+      std::cout << "Wrong doubles" << std::endl;
+      return 4;
+    }
+  }
+  tf_cpp::set_simd_level(best);
+
+  tf_cpp::TextParser int64s({"i", TF_INT64, {-1, 2}});
+  tf_cpp::Tensor i(graph, "i", {-1, 2}, TF_INT64);
+  int64s.parse_csv("-9223372036854775808,9223372036854775807\n", &i);
+  if (!Equals<int64_t>(i, {1, 2}, {INT64_MIN, INT64_MAX})) {
+    std::cout << "Wrong int64" << std::endl;
+    return 5;
+  }
+  tf_cpp::TextParser int32s({"j", TF_INT32, {-1}});
+  tf_cpp::Tensor j(graph, "j", {-1}, TF_INT32);
+  if (Fails(int32s, "[1, -2147483648]", true, &j) || !Fails(int32s, "[2147483648]", true, &j) ||
+      !Fails(int32s, "[1.5]", true, &j) || !Fails(int64s, "1,2,3,4\n", false, &i)) {
+    std::cout << "Wrong integer checks" << std::endl;
+    return 6;
+  }
+
+  // malformed input throws.
+  const std::vector<std::string> bad_json = {"[[1,2,3],[4,5]]", "[1,2,x]", "[1,,2,3]", "[1 2 3]", "[1,2,3",
+                                             "[1,2,3]]", "[1-2,3,4]", "[[1,2,3]", "[1,2,3] 4", "[.,2,3]"};
+  for (auto& text : bad_json) {
+    if (!Fails(floats, text, true, &x)) {
+      std::cout << "Malformed json was parsed: " << text << std::endl;
+      return 7;
+    }
+  }
+  const std::vector<std::string> bad_csv = {"1,2,3\n4,5\n", "1,2,3,4", "1;2;3", "a,b,c\n1,2,3", "1,2,3\n4,5,6e"};
+  for (auto& text : bad_csv) {
+    if (!Fails(floats, text, false, &x)) {
+      std::cout << "Malformed csv was parsed: " << text << std::endl;
+      return 8;
+    }
+  }
+  // a known first dimension must be met.
+  tf_cpp::TextParser fixed({"x", TF_FLOAT, {1, 3}});
+  if (!Fails(fixed, "[[1,2,3],[4,5,6]]", true, &x)) {
+    std::cout << "Wrong first dimension was parsed" << std::endl;
+    return 9;
+  }
+
+  std::cout << "Success parsing json and csv into tensors" << std::endl;
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "transpose.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// element by element reference.
+static void NaivePermute(const char* src, const std::vector<std::int64_t>& shape, const std::vector<int>& perm,
+                         char* dst, std::size_t element_size) {
+  std::size_t rank = shape.size();
+  std::vector<std::int64_t> stride(rank, 1), index(rank, 0);
+  for (std::size_t k = rank; k-- > 1;) stride[k - 1] = stride[k] * shape[k];
+  std::int64_t total = 1;
+  for (auto s : shape) total *= s;
+  for (std::int64_t d = 0; d < total; ++d) {
+    // index is the dst index in dst axis order.
+    std::int64_t offset = 0;
+    for (std::size_t i = 0; i < rank; ++i) offset += index[i] * stride[perm[i]];
+    std::memcpy(dst + d * element_size, src + offset * element_size, element_size);
+    for (std::size_t i = rank; i-- > 0;) {
+      if (++index[i] < shape[perm[i]]) break;
+      index[i] = 0;
+    }
+  }
+}
+
+int main() {
+  std::mt19937 rng(0);
+  const std::vector<std::size_t> element_sizes = {1, 2, 4, 8, 3, 16};
+  for (int level = 0; level <= static_cast<int>(tf_cpp::simd_level()); ++level) {
+    tf_cpp::set_simd_level(static_cast<tf_cpp::SimdLevel>(level));
+    for (int trial = 0; trial < 300; ++trial) {
+      std::size_t rank = 1 + rng() % 5;
+      std::vector<std::int64_t> shape(rank);
+      for (auto& s : shape) s = 1 + rng() % (rank <= 2 ? 150 : 13);
+      std::vector<int> perm(rank);
+      std::iota(perm.begin(), perm.end(), 0);
+      std::shuffle(perm.begin(), perm.end(), rng);
+      std::size_t element_size = element_sizes[rng() % element_sizes.size()];
+      std::int64_t total = 1;
+      for (auto s : shape) total *= s;
+      std::vector<char> src(total * element_size), expected(src.size()), result(src.size());
+      for (auto& c : src) c = static_cast<char>(rng());
+      NaivePermute(src.data(), shape, perm, expected.data(), element_size);
+      tf_cpp::permute(src.data(), shape, perm, result.data(), element_size);
+      if (result != expected) {
+        std::cout << "Wrong permutation at trial " << trial << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // large enough to run on the thread pool.
+  std::vector<std::int64_t> nchw = {2, 3, 300, 301};
+  std::vector<float> src(2 * 3 * 300 * 301), expected(src.size()), result(src.size());
+  std::iota(src.begin(), src.end(), 0.0f);
+  NaivePermute(reinterpret_cast<char*>(src.data()), nchw, tf_cpp::kNchwToNhwc,
+               reinterpret_cast<char*>(expected.data()), sizeof(float));
+  tf_cpp::permute(src.data(), nchw, tf_cpp::kNchwToNhwc, result.data(), sizeof(float));
+  if (result != expected) {
+    std::cout << "Wrong NCHW to NHWC" << std::endl;
+    return 2;
+  }
+
+  try {
+    tf_cpp::permute(src.data(), nchw, {0, 1, 1, 2}, result.data(), sizeof(float));
+    std::cout << "Invalid permutation accepted" << std::endl;
+    return 3;
+  } catch (const std::runtime_error&) {
+  }
+
+  std::cout << "Success permute" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include "versioned_model.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+int main() {
+  int warm_ups = 0;
+  tf_cpp::VersionedModel model("graph.pb", {},
+                               [&](tf_cpp::Model&) { ++warm_ups; });
+  if (model.version() != 1 || warm_ups != 1) {
+    std::cout << "First version was not loaded" << std::endl;
+    return 1;
+  }
+
+  // the swap waits for a lease on the old version.
+  std::future<std::uint64_t> swapped;
+  {
+    auto lease = model.acquire();
+    swapped = model.swap("graph.pb");
+    auto start = std::chrono::steady_clock::now();
+    while (model.version() != 2 && std::chrono::steady_clock::now() - start <
+                                        std::chrono::seconds(10)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (model.version() != 2 || model.acquire().version() != 2) {
+      std::cout << "New version did not become current" << std::endl;
+      return 2;
+    }
+    if (swapped.wait_for(std::chrono::milliseconds(100)) !=
+        std::future_status::timeout) {
+      std::cout << "Old version was destroyed under a lease" << std::endl;
+      return 3;
+    }
+    if (lease.version() != 1 || lease->get_graph() == nullptr) {
+      std::cout << "Lease lost its version" << std::endl;
+      return 4;
+    }
+  }
+  if (swapped.get() != 2 || warm_ups != 2) {
+    std::cout << "Swap did not finish" << std::endl;
+    return 5;
+  }
+
+  // a version that fails to load leaves the current one serving.
+  try {
+    model.swap("missing.pb").get();
+    std::cout << "Missing model did not throw" << std::endl;
+    return 6;
+  } catch (const std::runtime_error&) {
+  }
+  if (model.version() != 2) {
+    std::cout << "Failed swap changed the version" << std::endl;
+    return 7;
+  }
+
+  // readers keep acquiring while versions are swapped.
+  std::atomic<bool> stop(false);
+  std::atomic<int> errors(0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&]() {
+      std::uint64_t last = 0;
+      while (!stop) {
+        auto lease = model.acquire();
+        if (lease.version() < last || lease->get_graph() == nullptr) {
+          ++errors;
+        }
+        last = lease.version();
+      }
+    });
+  }
+  for (int i = 0; i < 3; ++i) {
+    model.swap("graph.pb").get();
+  }
+  stop = true;
+  for (auto& t : readers) t.join();
+  if (errors != 0 || model.version() != 5) {
+    std::cout << "Readers saw a bad version" << std::endl;
+    return 8;
+  }
+
+  std::cout << "Success swapping model versions" << std::endl;
+  return 0;
+}
@@ -0,0 +1,565 @@
+// Parses JSON and CSV numbers straight into tensors.
+
+#include "text_parser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "simd.h"
+#include "tf_utils.h"
+
+#if defined(TF_CPP_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace tf_cpp {
+
+namespace {
+
+constexpr double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                             1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                             1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+constexpr float kPow10f[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                             1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+// the digits a uint64_t mantissa always holds.
+constexpr int kMaxDigits = 19;
+
+bool IsDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool IsNumber(char c) {
+  return IsDigit(c) || c == '+' || c == '-' || c == '.' || c == 'e' ||
+         c == 'E';
+}
+
+[[noreturn]] void Malformed(bool json, std::size_t offset,
+                            const std::string &what) {
+  throw std::runtime_error(std::string("malformed ") +
+                           (json ? "json" : "csv") + " at byte " +
+                           std::to_string(offset) + ": " + what + ".");
+}
+
+std::string Describe(char c) {
+  if (c >= ' ' && c <= '~') {
+    return std::string("'") + c + "'";
+  }
+  const char *hex = "0123456789abcdef";
+  auto b = static_cast<unsigned char>(c);
+  return std::string("byte 0x") + hex[b >> 4] + hex[b & 15];
+}
+
+// numbers seen so far, and whether the last byte was part of one.
+struct Scan {
+  std::size_t numbers = 0;
+  bool in_number = false;
+};
+
+// scans n bytes at p, stops at the first byte that is neither part of a
+// number, white space nor one of the separators a, b and c. returns the
+// bytes scanned.
+std::size_t ScanScalar(const char *p, std::size_t n, char a, char b, char c,
+                       Scan *scan) {
+  for (std::size_t i = 0; i != n; ++i) {
+    bool number = IsNumber(p[i]);
+    if (!number && !IsSpace(p[i]) && p[i] != a && p[i] != b && p[i] != c) {
+      return i;
+    }
+    scan->numbers += number && !scan->in_number;
+    scan->in_number = number;
+  }
+  return n;
+}
+
+#if defined(TF_CPP_X86_SIMD)
+
+// the bytes of v equal to x.
+__attribute__((target("avx2"))) inline __m256i Avx2Eq(__m256i v, char x) {
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(x));
+}
+
+// ScanScalar for the whole 32 byte blocks of the n bytes at p. a number
+// starts at every number byte whose predecessor is not one.
+__attribute__((target("avx2,popcnt"))) std::size_t ScanAvx2(
+    const char *p, std::size_t n, char a, char b, char c, Scan *scan) {
+  const __m256i below_zero = _mm256_set1_epi8('0' - 1);
+  const __m256i above_nine = _mm256_set1_epi8('9' + 1);
+  uint32_t carry = scan->in_number;
+  std::size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    // bytes from 0x80 are negative and fail the signed compare.
+    __m256i number = _mm256_and_si256(_mm256_cmpgt_epi8(v, below_zero),
+                                      _mm256_cmpgt_epi8(above_nine, v));
+    __m256i sign = _mm256_or_si256(Avx2Eq(v, '+'), Avx2Eq(v, '-'));
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    number = _mm256_or_si256(
+        _mm256_or_si256(number, sign),
+        _mm256_or_si256(Avx2Eq(v, '.'), Avx2Eq(lower, 'e')));
+    __m256i space = _mm256_or_si256(
+        _mm256_or_si256(Avx2Eq(v, ' '), Avx2Eq(v, '\t')),
+        _mm256_or_si256(Avx2Eq(v, '\r'), Avx2Eq(v, '\n')));
+    __m256i separator = _mm256_or_si256(
+        Avx2Eq(v, a), _mm256_or_si256(Avx2Eq(v, b), Avx2Eq(v, c)));
+    __m256i other = _mm256_or_si256(space, separator);
+    auto accepted = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_or_si256(number, other)));
+    if (accepted != 0xffffffff) {
+      // the scalar scan finds the byte and counts up to it.
+      break;
+    }
+    auto numbers = static_cast<uint32_t>(_mm256_movemask_epi8(number));
+    scan->numbers += __builtin_popcount(numbers & ~((numbers << 1) | carry));
+    carry = numbers >> 31;
+  }
+  scan->in_number = carry != 0;
+  return i;
+}
+
+#endif  // TF_CPP_X86_SIMD
+
+// the value of the 8 digits at p, false if they are not all digits.
+bool EightDigits(const char *p, uint32_t *value) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  uint64_t v;
+  std::memcpy(&v, p, 8);
+  if (((v & 0xF0F0F0F0F0F0F0F0) |
+       (((v + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) !=
+      0x3333333333333333) {
+    return false;
+  }
+  // pairs, then fours, then all eight, in place.
+  v -= 0x3030303030303030;
+  v = v * 10 + (v >> 8);
+  v = ((v & 0x000000FF000000FF) * (100 + (1000000ULL << 32)) +
+       ((v >> 16) & 0x000000FF000000FF) * (1 + (10000ULL << 32))) >>
+      32;
+  *value = static_cast<uint32_t>(v);
+  return true;
+#else
+  return false;
+#endif
+}
+
+// reads the digits at p into mantissa while it has room, counting the
+// digits read in taken and all digits in seen. returns the end.
+const char *Digits(const char *p, const char *end, uint64_t *mantissa,
+                   int *taken, int *seen) {
+  uint32_t eight;
+  while (end - p >= 8 && *taken + 8 <= kMaxDigits && EightDigits(p, &eight)) {
+    *mantissa = *mantissa * 100000000 + eight;
+    *taken += 8;
+    *seen += 8;
+    p += 8;
+  }
+  for (; p != end && IsDigit(*p); ++p) {
+    if (*taken < kMaxDigits) {
+      *mantissa = *mantissa * 10 + (*p - '0');
+      ++*taken;
+    }
+    ++*seen;
+  }
+  return p;
+}
+
+// parses the number at p into out, returns its end or nullptr if there is
+// no number or it is out of range.
+template <typename T>
+const char *ParseReal(const char *p, const char *end, T *out) {
+  const char *start = p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int taken = 0, seen = 0;
+  p = Digits(p, end, &mantissa, &taken, &seen);
+  int exponent = 0;
+  if (p != end && *p == '.') {
+    int before = taken;
+    p = Digits(p + 1, end, &mantissa, &taken, &seen);
+    exponent -= taken - before;
+  }
+  if (seen == 0) {
+    return nullptr;
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negative_exponent = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+      negative_exponent = *p == '-';
+      ++p;
+    }
+    if (p == end || !IsDigit(*p)) {
+      return nullptr;
+    }
+    int e = 0;
+    for (; p != end && IsDigit(*p); ++p) {
+      e = std::min(e * 10 + (*p - '0'), 100000);
+    }
+    exponent += negative_exponent ? -e : e;
+  }
+
+  // exact when the mantissa and the power of ten are, one rounding.
+  if (std::is_same<T, float>::value) {
+    if (taken == seen && mantissa <= (uint64_t(1) << 24) && exponent >= -10 &&
+        exponent <= 10) {
+      float value = static_cast<float>(mantissa);
+      value = exponent < 0 ? value / kPow10f[-exponent]
+                           : value * kPow10f[exponent];
+      *out = negative ? -value : value;
+      return p;
+    }
+  } else if (taken == seen && mantissa <= (uint64_t(1) << 53) &&
+             exponent >= -22 && exponent <= 22) {
+    double value = static_cast<double>(mantissa);
+    value = exponent < 0 ? value / kPow10[-exponent] : value * kPow10[exponent];
+    *out = static_cast<T>(negative ? -value : value);
+    return p;
+  }
+  // long or extreme numbers go through the c library.
+  std::string number(start, p);
+  T value = std::is_same<T, float>::value
+                ? static_cast<T>(std::strtof(number.c_str(), nullptr))
+                : static_cast<T>(std::strtod(number.c_str(), nullptr));
+  if (std::isinf(value)) {
+    return nullptr;
+  }
+  *out = value;
+  return p;
+}
+
+template <typename T>
+const char *ParseInteger(const char *p, const char *end, T *out) {
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t magnitude = 0;
+  int taken = 0, seen = 0;
+  p = Digits(p, end, &magnitude, &taken, &seen);
+  uint64_t limit = static_cast<uint64_t>(std::numeric_limits<T>::max()) +
+                   (negative ? 1 : 0);
+  if (seen == 0 || taken != seen || magnitude > limit) {
+    return nullptr;
+  }
+  // 1.5 or 1e3 are not integers.
+  if (p != end && (*p == '.' || *p == 'e' || *p == 'E')) {
+    return nullptr;
+  }
+  *out = negative ? static_cast<T>(0 - magnitude) : static_cast<T>(magnitude);
+  return p;
+}
+
+const char *ParseNumber(const char *p, const char *end, float *out) {
+  return ParseReal(p, end, out);
+}
+const char *ParseNumber(const char *p, const char *end, double *out) {
+  return ParseReal(p, end, out);
+}
+const char *ParseNumber(const char *p, const char *end, int32_t *out) {
+  return ParseInteger(p, end, out);
+}
+const char *ParseNumber(const char *p, const char *end, int64_t *out) {
+  return ParseInteger(p, end, out);
+}
+
+// reads a JSON array nested as shape into out.
+template <typename T>
+struct JsonReader {
+  const char *begin;
+  const char *p;
+  const char *end;
+  const std::vector<int64_t> &shape;
+  TF_DataType dtype;
+  T *out;
+  std::size_t n;
+  std::size_t written = 0;
+
+  [[noreturn]] void fail(const std::string &what) {
+    Malformed(true, p - begin, what);
+  }
+
+  void skip() {
+    while (p != end && IsSpace(*p)) {
+      ++p;
+    }
+  }
+
+  void number() {
+    skip();
+    if (written == n) {
+      fail("more numbers than the shape holds");
+    }
+    auto next = ParseNumber(p, end, out + written);
+    if (next == nullptr) {
+      fail("expected a " + tf_utils::DataTypeToString(dtype) + " number");
+    }
+    p = next;
+    ++written;
+  }
+
+  // the array of dimension d, all numbers if flat. returns its length.
+  std::size_t array(std::size_t d, bool flat) {
+    skip();
+    if (p == end || *p != '[') {
+      fail("expected '['");
+    }
+    ++p;
+    skip();
+    if (p != end && *p == ']') {
+      ++p;
+      return 0;
+    }
+    for (std::size_t length = 1;; ++length) {
+      if (flat || d + 1 == shape.size()) {
+        number();
+      } else {
+        auto inner = array(d + 1, false);
+        if (inner != static_cast<std::size_t>(shape[d + 1])) {
+          fail("an array of " + std::to_string(inner) + " at dimension " +
+               std::to_string(d + 1) + ", expected " +
+               std::to_string(shape[d + 1]));
+        }
+      }
+      skip();
+      if (p != end && *p == ']') {
+        ++p;
+        return length;
+      }
+      if (p == end || *p != ',') {
+        fail("expected ',' or ']'");
+      }
+      ++p;
+    }
+  }
+};
+
+std::size_t NumElements(const std::vector<int64_t> &shape) {
+  std::size_t n = 1;
+  for (auto d : shape) {
+    n *= d;
+  }
+  return n;
+}
+
+}  // namespace
+
+TextParser::TextParser(const TensorSpec &spec, char delimiter)
+    : tensor_spec(spec), delimiter(delimiter) {
+  if (spec.dtype != TF_FLOAT && spec.dtype != TF_DOUBLE &&
+      spec.dtype != TF_INT32 && spec.dtype != TF_INT64) {
+    throw std::runtime_error("can not parse text into " +
+                             tf_utils::DataTypeToString(spec.dtype) + ".");
+  }
+  if (spec.shape.size() > MAX_DIMS) {
+    throw std::runtime_error("shape " + to_string(spec.shape) +
+                             " has too many dimensions.");
+  }
+  for (std::size_t d = 0; d != spec.shape.size(); ++d) {
+    if (spec.shape[d] < (d == 0 ? -1 : 0)) {
+      throw std::runtime_error("only the first dimension of " + spec.name +
+                               " may be unknown, shape " +
+                               to_string(spec.shape) + ".");
+    }
+    if (d != 0) {
+      row_size *= spec.shape[d];
+    }
+  }
+  if (IsNumber(delimiter) || delimiter == '\n') {
+    throw std::runtime_error("a csv delimiter can not be " +
+                             Describe(delimiter) + ".");
+  }
+}
+
+std::size_t TextParser::count_numbers(std::string_view text,
+                                      bool json) const {
+  char a = json ? ',' : delimiter;
+  char b = json ? '[' : delimiter;
+  char c = json ? ']' : delimiter;
+  Scan scan;
+  std::size_t i = 0;
+#if defined(TF_CPP_X86_SIMD)
+  // AVX-512F alone has no byte compares, the AVX2 scan serves both levels.
+  if (simd_level() >= SimdLevel::kAvx2) {
+    i = ScanAvx2(text.data(), text.size(), a, b, c, &scan);
+  }
+#endif
+  i += ScanScalar(text.data() + i, text.size() - i, a, b, c, &scan);
+  if (i != text.size()) {
+    Malformed(json, i, "unexpected " + Describe(text[i]));
+  }
+  return scan.numbers;
+}
+
+void *TextParser::prepare(std::size_t n, Tensor *tensor) const {
+  if (tensor->dtype() != tensor_spec.dtype) {
+    throw std::runtime_error(
+        "can not parse " + tf_utils::DataTypeToString(tensor_spec.dtype) +
+        " into a " + tf_utils::DataTypeToString(tensor->dtype()) +
+        " tensor.");
+  }
+  auto shape = tensor_spec.shape;
+  if (!shape.empty() && shape[0] == -1) {
+    if (row_size == 0 || n % row_size != 0) {
+      throw std::runtime_error(std::to_string(n) +
+                               " numbers do not fill rows of shape " +
+                               to_string(shape) + ".");
+    }
+    shape[0] = n / row_size;
+  }
+  if (NumElements(shape) != n) {
+    throw std::runtime_error(std::to_string(n) + " numbers for shape " +
+                             to_string(shape) + ".");
+  }
+  // a tensor of the same shape is parsed into in place.
+  if (tensor->tf_tensor == nullptr || tensor->tf_shape != shape) {
+    auto tf_tensor = tf_utils::CreateEmptyTensor(
+        tensor_spec.dtype, shape, n * TF_DataTypeSize(tensor_spec.dtype));
+    if (tf_tensor == nullptr) {
+      throw std::runtime_error("tf_utils::CreateTensor error");
+    }
+    tensor->set_tensor(tf_tensor);
+  }
+  return TF_TensorData(tensor->tf_tensor);
+}
+
+void TextParser::parse_json(std::string_view text, Tensor *tensor) const {
+  auto n = count_numbers(text, true);
+  auto data = prepare(n, tensor);
+  switch (tensor_spec.dtype) {
+    case TF_FLOAT:
+      return parse_json_as(text, static_cast<float *>(data), n);
+    case TF_DOUBLE:
+      return parse_json_as(text, static_cast<double *>(data), n);
+    case TF_INT32:
+      return parse_json_as(text, static_cast<int32_t *>(data), n);
+    default:
+      return parse_json_as(text, static_cast<int64_t *>(data), n);
+  }
+}
+
+void TextParser::parse_csv(std::string_view text, Tensor *tensor) const {
+  if (tensor_spec.shape.empty()) {
+    throw std::runtime_error("can not parse csv into the scalar " +
+                             tensor_spec.name + ".");
+  }
+  auto n = count_numbers(text, false);
+  auto data = prepare(n, tensor);
+  switch (tensor_spec.dtype) {
+    case TF_FLOAT:
+      return parse_csv_as(text, static_cast<float *>(data), n);
+    case TF_DOUBLE:
+      return parse_csv_as(text, static_cast<double *>(data), n);
+    case TF_INT32:
+      return parse_csv_as(text, static_cast<int32_t *>(data), n);
+    default:
+      return parse_csv_as(text, static_cast<int64_t *>(data), n);
+  }
+}
+
+template <typename T>
+void TextParser::parse_json_as(std::string_view text, T *out,
+                               std::size_t n) const {
+  const char *end = text.data() + text.size();
+  JsonReader<T> reader{text.data(),       text.data(), end,
+                       tensor_spec.shape, tensor_spec.dtype, out, n};
+  if (tensor_spec.shape.empty()) {
+    reader.number();
+  } else {
+    // nested if the first element is an array.
+    auto q = text.find_first_not_of(" \t\r\n");
+    if (q != text.npos) {
+      q = text.find_first_not_of(" \t\r\n", q + 1);
+    }
+    bool flat =
+        tensor_spec.shape.size() == 1 || q == text.npos || text[q] != '[';
+    auto rows = reader.array(0, flat);
+    if (!flat && tensor_spec.shape[0] != -1 &&
+        rows != static_cast<std::size_t>(tensor_spec.shape[0])) {
+      reader.fail("an array of " + std::to_string(rows) + ", expected " +
+                  std::to_string(tensor_spec.shape[0]));
+    }
+  }
+  reader.skip();
+  if (reader.p != end) {
+    reader.fail("unexpected " + Describe(*reader.p) + " after the array");
+  }
+  if (reader.written != n) {
+    reader.fail(std::to_string(reader.written) + " numbers, expected " +
+                std::to_string(n));
+  }
+}
+
+template <typename T>
+void TextParser::parse_csv_as(std::string_view text, T *out,
+                              std::size_t n) const {
+  const char *begin = text.data();
+  const char *end = begin + text.size();
+  const char *p = begin;
+  auto fail = [&](const std::string &what) {
+    Malformed(false, p - begin, what);
+  };
+  // white space within a line, unless it delimits.
+  auto skip = [&]() {
+    while (p != end && *p != delimiter &&
+           (*p == ' ' || *p == '\t' || *p == '\r')) {
+      ++p;
+    }
+  };
+  std::size_t written = 0;
+  for (std::size_t line = 1; p != end; ++line) {
+    skip();
+    if (p != end && *p == '\n') {
+      ++p;
+      continue;
+    }
+    if (p == end) {
+      break;
+    }
+    for (std::size_t k = 1;; ++k) {
+      skip();
+      if (written == n) {
+        fail("more numbers than the shape holds");
+      }
+      auto next = ParseNumber(p, end, out + written);
+      if (next == nullptr) {
+        fail("expected a " +
+             tf_utils::DataTypeToString(tensor_spec.dtype) + " number");
+      }
+      p = next;
+      ++written;
+      skip();
+      if (p == end || *p == '\n') {
+        if (k != row_size) {
+          fail("line " + std::to_string(line) + " has " + std::to_string(k) +
+               " values, expected " + std::to_string(row_size));
+        }
+        p += p != end;
+        break;
+      }
+      if (*p != delimiter) {
+        fail("expected " + Describe(delimiter));
+      }
+      if (k == row_size) {
+        fail("line " + std::to_string(line) + " has more than " +
+             std::to_string(row_size) + " values");
+      }
+      ++p;
+    }
+  }
+  if (written != n) {
+    fail(std::to_string(written) + " numbers, expected " + std::to_string(n));
+  }
+}
+}  // namespace tf_cpp
@@ -0,0 +1,60 @@
+// Parses JSON and CSV numbers straight into tensors.
+
+#ifndef TENSORFLOW_C_TEXT_PARSER_H
+#define TENSORFLOW_C_TEXT_PARSER_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "tensor.h"
+
+namespace tf_cpp {
+
+// parses feature rows sent as text into the buffer of a tensor, without a
+// std::vector<float> in between. the text is first scanned, with AVX2 when
+// simd_level() allows, to count the numbers and reject any byte that can
+// not occur in it. the tensor is then allocated once, and the numbers are
+// parsed into it, eight digits at a time.
+// spec.dtype is TF_FLOAT, TF_DOUBLE, TF_INT32 or TF_INT64, only the first
+// dimension of spec.shape may be -1, it is taken from the count.
+// malformed text throws std::runtime_error with the byte offset at the
+// first error, the contents of the tensor are then unspecified.
+class TextParser {
+ public:
+  // delimiter separates the values of a CSV line.
+  explicit TextParser(const TensorSpec &spec, char delimiter = ',');
+
+  // a JSON array nested as spec.shape, e.g. [[1, 2.5], [-3, 4e2]] for
+  // {-1, 2}, or flat, e.g. [1, 2.5, -3, 4e2]. a bare number for a scalar.
+  void parse_json(std::string_view text, Tensor *tensor) const;
+
+  // one line per entry of the first dimension, the other dimensions
+  // flattened into its values, e.g. "1,2.5\n-3,4e2\n" for {-1, 2}.
+  // blank lines are skipped, there is no header line and no quoting.
+  void parse_csv(std::string_view text, Tensor *tensor) const;
+
+  const TensorSpec &spec() const { return tensor_spec; }
+
+ private:
+  // the number of numbers in text, throws at the first byte that is not
+  // part of a number, white space or one of the separators.
+  std::size_t count_numbers(std::string_view text, bool json) const;
+  // the buffer of tensor, shaped for n numbers.
+  void *prepare(std::size_t n, Tensor *tensor) const;
+
+  template <typename T>
+  void parse_json_as(std::string_view text, T *out, std::size_t n) const;
+  template <typename T>
+  void parse_csv_as(std::string_view text, T *out, std::size_t n) const;
+
+  TensorSpec tensor_spec;
+  char delimiter;
+  // the numbers of one entry of the first dimension.
+  std::size_t row_size = 1;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_TEXT_PARSER_H
@@ -30,6 +30,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <string>
 
 #include "scope_guard.h"
 
@@ -85,14 +86,15 @@ static bool WriteBufferFromFile(TF_Buffer* buffer, const char* file) {
 }
 
 TF_Tensor* ScalarStringTensor(const char* str, TF_Status* status) {
-  auto str_len = std::strlen(str);
-  auto nbytes =
-      8 + TF_StringEncodedSize(str_len);  // 8 extra bytes - for start_offset.
-  auto tensor = TF_AllocateTensor(TF_STRING, nullptr, 0, nbytes);
-  auto data = static_cast<char*>(TF_TensorData(tensor));
-  std::memset(data, 0, 8);
-  TF_StringEncode(str, str_len, data + 8, nbytes - 8, status);
-  return tensor;
+  return CreateStringTensor({std::string_view(str)}, {}, status);
+}
+
+std::size_t NumElements(const TF_Tensor* tensor) {
+  std::size_t n = 1;
+  for (int i = 0; i < TF_NumDims(tensor); ++i) {
+    n *= static_cast<std::size_t>(TF_Dim(tensor, i));
+  }
+  return n;
 }
 
 }  // namespace
@@ -254,6 +256,40 @@ TF_Graph* LoadGraph(const char* graph_path, TF_Status* status) {
   return LoadGraph(graph_path, nullptr, status);
 }
 
+TF_Code ImportGraph(TF_Graph* graph, const char* graph_path,
+                    const TF_ImportGraphDefOptions* options,
+                    TF_Status* status) {
+  if (graph == nullptr || graph_path == nullptr) {
+    return TF_INVALID_ARGUMENT;
+  }
+
+  TF_Buffer* buffer = ReadBufferFromFile(graph_path);
+  if (buffer == nullptr) {
+    return TF_NOT_FOUND;
+  }
+  SCOPE_EXIT { TF_DeleteBuffer(buffer); };
+
+  MAKE_SCOPE_EXIT(delete_status) { TF_DeleteStatus(status); };
+  if (status == nullptr) {
+    status = TF_NewStatus();
+  } else {
+    delete_status.dismiss();
+  }
+
+  MAKE_SCOPE_EXIT(delete_options) {
+    TF_DeleteImportGraphDefOptions(
+        const_cast<TF_ImportGraphDefOptions*>(options));
+  };
+  if (options == nullptr) {
+    options = TF_NewImportGraphDefOptions();
+  } else {
+    delete_options.dismiss();
+  }
+
+  TF_GraphImportGraphDef(graph, buffer, options, status);
+  return TF_GetCode(status);
+}
+
 void DeleteGraph(TF_Graph* graph) {
   if (graph != nullptr) {
     TF_DeleteGraph(graph);
@@ -325,7 +361,8 @@ TF_Code RunSession(TF_Session* session, const TF_Output* inputs,
                    TF_Tensor* const* input_tensors, std::size_t ninputs,
                    const TF_Output* outputs, TF_Tensor** output_tensors,
                    std::size_t noutputs, TF_Operation* const* operations,
-                   std::size_t noperations, TF_Status* status) {
+                   std::size_t noperations, TF_Status* status,
+                   const TF_Buffer* run_options) {
   MAKE_SCOPE_EXIT(delete_status) { TF_DeleteStatus(status); };
   if (status == nullptr) {
     status = TF_NewStatus();
@@ -334,7 +371,7 @@ TF_Code RunSession(TF_Session* session, const TF_Output* inputs,
   }
   TF_SessionRun(
       session,
-      nullptr,  // Run options.
+      run_options,  // Run options.
       inputs, input_tensors,
       static_cast<int>(
           ninputs),  // Input tensors, input tensor values, number of inputs.
@@ -354,12 +391,12 @@ TF_Code RunSession(TF_Session* session, const std::vector<TF_Output>& inputs,
                    const std::vector<TF_Output>& outputs,
                    std::vector<TF_Tensor*>& output_tensors,
                    const std::vector<TF_Operation*>& operations,
-                   TF_Status* status) {
+                   TF_Status* status, const TF_Buffer* run_options) {
   return RunSession(session, inputs.data(), input_tensors.data(),
                     input_tensors.size(), outputs.data(), output_tensors.data(),
                     output_tensors.size(),
                     operations.size() ? operations.data() : nullptr,
-                    operations.size(), status);
+                    operations.size(), status, run_options);
 }
 
 TF_Tensor* CreateEmptyTensor(TF_DataType data_type, const std::int64_t* dims,
@@ -399,6 +436,98 @@ TF_Tensor* CreateTensor(TF_DataType data_type, const std::int64_t* dims,
   return tensor;
 }
 
+TF_Tensor* CreateStringTensor(const std::vector<std::string_view>& strings,
+                              const std::vector<std::int64_t>& dims,
+                              TF_Status* status) {
+  std::size_t n = 1;
+  for (auto d : dims) {
+    n *= static_cast<std::size_t>(d);
+  }
+  if (n != strings.size()) {
+    return nullptr;
+  }
+
+  MAKE_SCOPE_EXIT(delete_status) { TF_DeleteStatus(status); };
+  if (status == nullptr) {
+    status = TF_NewStatus();
+  } else {
+    delete_status.dismiss();
+  }
+
+  // layout: uint64 offset per element, then the encoded strings.
+  std::size_t table_size = n * sizeof(std::uint64_t);
+  std::size_t nbytes = table_size;
+  for (auto& s : strings) {
+    nbytes += TF_StringEncodedSize(s.size());
+  }
+  auto tensor = TF_AllocateTensor(TF_STRING, dims.data(),
+                                  static_cast<int>(dims.size()), nbytes);
+  if (tensor == nullptr) {
+    return nullptr;
+  }
+
+  auto data = static_cast<char*>(TF_TensorData(tensor));
+  auto offsets = data;
+  auto dst = data + table_size;
+  std::size_t dst_len = nbytes - table_size;
+  std::uint64_t offset = 0;
+  for (auto& s : strings) {
+    std::memcpy(offsets, &offset, sizeof(offset));
+    offsets += sizeof(offset);
+    auto written = TF_StringEncode(s.data(), s.size(), dst + offset,
+                                   dst_len - offset, status);
+    if (TF_GetCode(status) != TF_OK) {
+      DeleteTensor(tensor);
+      return nullptr;
+    }
+    offset += written;
+  }
+
+  return tensor;
+}
+
+std::vector<std::string_view> GetStringTensorData(const TF_Tensor* tensor,
+                                                  TF_Status* status) {
+  if (tensor == nullptr || TF_TensorType(tensor) != TF_STRING) {
+    return {};
+  }
+
+  MAKE_SCOPE_EXIT(delete_status) { TF_DeleteStatus(status); };
+  if (status == nullptr) {
+    status = TF_NewStatus();
+  } else {
+    delete_status.dismiss();
+  }
+
+  auto n = NumElements(tensor);
+  auto data = static_cast<const char*>(TF_TensorData(tensor));
+  auto nbytes = TF_TensorByteSize(tensor);
+  std::size_t table_size = n * sizeof(std::uint64_t);
+  if (data == nullptr || nbytes < table_size) {
+    return {};
+  }
+
+  std::vector<std::string_view> result;
+  result.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    std::uint64_t offset;
+    std::memcpy(&offset, data + i * sizeof(offset), sizeof(offset));
+    if (offset > nbytes - table_size) {
+      return {};
+    }
+    const char* dst = nullptr;
+    std::size_t dst_len = 0;
+    TF_StringDecode(data + table_size + offset, nbytes - table_size - offset,
+                    &dst, &dst_len, status);
+    if (TF_GetCode(status) != TF_OK) {
+      return {};
+    }
+    result.emplace_back(dst, dst_len);
+  }
+
+  return result;
+}
+
 void DeleteTensor(TF_Tensor* tensor) {
   if (tensor != nullptr) {
     TF_DeleteTensor(tensor);
@@ -413,14 +542,11 @@ void DeleteTensors(const std::vector<TF_Tensor*>& tensors) {
 
 TF_Tensor* CopyTensor(TF_Tensor* tensor) {
   int n_dims = TF_NumDims(tensor);
-  int64_t* dims = nullptr;
-  if (n_dims > 0) {
-    dims = new int64_t[n_dims];
-    for (int i = 0; i < n_dims; i++) {
-      dims[i] = TF_Dim(tensor, i);
-    }
+  std::vector<std::int64_t> dims(n_dims);
+  for (int i = 0; i < n_dims; i++) {
+    dims[i] = TF_Dim(tensor, i);
   }
-  return CreateTensor(TF_TensorType(tensor), dims, n_dims,
+  return CreateTensor(TF_TensorType(tensor), dims.data(), n_dims,
                       TF_TensorData(tensor), TF_TensorByteSize(tensor));
 }
 
@@ -435,12 +561,24 @@ bool SetTensorData(TF_Tensor* tensor, const void* data, std::size_t len) {
   return false;
 }
 
+std::pair<std::string, int> SplitTensorName(const std::string& tensor_name) {
+  auto colon = tensor_name.rfind(':');
+  if (colon == std::string::npos || colon + 1 == tensor_name.size() ||
+      tensor_name.find_first_not_of("0123456789", colon + 1) !=
+          std::string::npos) {
+    return {tensor_name, 0};
+  }
+  return {tensor_name.substr(0, colon),
+          std::stoi(tensor_name.substr(colon + 1))};
+}
+
 TF_Code GetTGraphOperation(TF_Graph* graph, const char* oper_name,
                            TF_Output* out, TF_DataType* type, int* n_dims,
                            int64_t* dims, TF_Status* status) {
-  out->oper = TF_GraphOperationByName(graph, oper_name);
-  out->index = 0;
-  if (out->oper == nullptr) {
+  auto name = SplitTensorName(oper_name);
+  out->index = name.second;
+  out->oper = TF_GraphOperationByName(graph, name.first.c_str());
+  if (out->oper == nullptr || out->index >= TF_OperationNumOutputs(out->oper)) {
     return TF_INVALID_ARGUMENT;
   }
 
@@ -453,7 +591,7 @@ TF_Code GetTGraphOperation(TF_Graph* graph, const char* oper_name,
   *n_dims = TF_GraphGetTensorNumDims(graph, *out, status);
   *type = TF_OperationOutputType(*out);
 
-  if (n_dims > 0) {
+  if (*n_dims > 0) {
     TF_GraphGetTensorShape(graph, *out, dims, *n_dims, status);
     if (TF_GetCode(status) != TF_OK) {
       return TF_GetCode(status);
@@ -462,6 +600,32 @@ TF_Code GetTGraphOperation(TF_Graph* graph, const char* oper_name,
   return TF_OK;
 }
 
+TF_Operation* AddPlaceholder(TF_Graph* graph, const char* oper_name,
+                             TF_DataType type,
+                             const std::vector<std::int64_t>& dims,
+                             TF_Status* status) {
+  if (graph == nullptr || oper_name == nullptr) {
+    return nullptr;
+  }
+
+  MAKE_SCOPE_EXIT(delete_status) { TF_DeleteStatus(status); };
+  if (status == nullptr) {
+    status = TF_NewStatus();
+  } else {
+    delete_status.dismiss();
+  }
+
+  auto desc = TF_NewOperation(graph, "Placeholder", oper_name);
+  TF_SetAttrType(desc, "dtype", type);
+  TF_SetAttrShape(desc, "shape", dims.data(), static_cast<int>(dims.size()));
+  auto oper = TF_FinishOperation(desc, status);
+  if (TF_GetCode(status) != TF_OK) {
+    return nullptr;
+  }
+
+  return oper;
+}
+
 std::vector<std::int64_t> GetTensorShape(TF_Graph* graph,
                                          const TF_Output& output) {
   auto status = TF_NewStatus();
@@ -559,12 +723,87 @@ TF_SessionOptions* CreateSessionOptions(
   return options;
 }
 
+TF_SessionOptions* CreateCpuSessionOptions(int device_count,
+                                           int intra_op_parallelism_threads,
+                                           int inter_op_parallelism_threads,
+                                           double gpu_memory_fraction,
+                                           TF_Status* status) {
+  MAKE_SCOPE_EXIT(delete_status) { TF_DeleteStatus(status); };
+  if (status == nullptr) {
+    status = TF_NewStatus();
+  } else {
+    delete_status.dismiss();
+  }
+
+  // a serialized ConfigProto, every field is a tag followed by a varint.
+  std::vector<std::uint8_t> config;
+  auto varint = [](std::vector<std::uint8_t>& out, std::uint64_t value) {
+    for (; value >= 0x80; value >>= 7) {
+      out.push_back(static_cast<std::uint8_t>(value | 0x80));
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+  };
+  if (device_count > 0) {
+    // device_count (1), a map entry {key (1): "CPU", value (2): count}.
+    std::vector<std::uint8_t> entry = {0x0a, 0x03, 'C', 'P', 'U', 0x10};
+    varint(entry, device_count);
+    config.push_back(0x0a);
+    varint(config, entry.size());
+    config.insert(config.end(), entry.begin(), entry.end());
+  }
+  if (intra_op_parallelism_threads > 0) {
+    // intra_op_parallelism_threads (2).
+    config.push_back(0x10);
+    varint(config, intra_op_parallelism_threads);
+  }
+  if (inter_op_parallelism_threads > 0) {
+    // inter_op_parallelism_threads (5).
+    config.push_back(0x28);
+    varint(config, inter_op_parallelism_threads);
+  }
+  if (gpu_memory_fraction > 0) {
+    // gpu_options (6), {per_process_gpu_memory_fraction (1): a double,
+    // allow_growth (4): true}.
+    config.insert(config.end(), {0x32, 0x0b, 0x09});
+    auto bytes = reinterpret_cast<std::uint8_t*>(&gpu_memory_fraction);
+    config.insert(config.end(), bytes, bytes + sizeof(gpu_memory_fraction));
+    config.insert(config.end(), {0x20, 0x01});
+  }
+  // allow_soft_placement (7).
+  config.push_back(0x38);
+  config.push_back(0x01);
+
+  auto options = TF_NewSessionOptions();
+  TF_SetConfig(options, config.data(), config.size(), status);
+
+  if (TF_GetCode(status) != TF_OK) {
+    DeleteSessionOptions(options);
+    return nullptr;
+  }
+
+  return options;
+}
+
 void DeleteSessionOptions(TF_SessionOptions* options) {
   if (options != nullptr) {
     TF_DeleteSessionOptions(options);
   }
 }
 
+TF_Buffer* CreateRunOptions(std::int64_t timeout_in_ms) {
+  // a serialized RunOptions, timeout_in_ms (2) as a varint.
+  std::vector<std::uint8_t> run_options;
+  if (timeout_in_ms > 0) {
+    run_options.push_back(0x10);
+    auto value = static_cast<std::uint64_t>(timeout_in_ms);
+    for (; value >= 0x80; value >>= 7) {
+      run_options.push_back(static_cast<std::uint8_t>(value | 0x80));
+    }
+    run_options.push_back(static_cast<std::uint8_t>(value));
+  }
+  return TF_NewBufferFromString(run_options.data(), run_options.size());
+}
+
 std::string DataTypeToString(TF_DataType data_type) {
   switch (data_type) {
     case TF_FLOAT:
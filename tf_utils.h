@@ -40,6 +40,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace tf_utils {
@@ -49,6 +52,12 @@ TF_Graph* LoadGraph(const char* graph_path, const char* checkpoint_prefix,
 
 TF_Graph* LoadGraph(const char* graph_path, TF_Status* status = nullptr);
 
+// import the GraphDef in graph_path into an existing graph, e.g. with a
+// name prefix, a default device or input mappings set in options.
+TF_Code ImportGraph(TF_Graph* graph, const char* graph_path,
+                    const TF_ImportGraphDefOptions* options,
+                    TF_Status* status = nullptr);
+
 TF_Code DumpGraph(TF_Graph* graph, TF_Session* session, const char* graph_path,
                   TF_Status* status);
 
@@ -72,14 +81,16 @@ TF_Code RunSession(TF_Session* session, const TF_Output* inputs,
                    const TF_Output* outputs, TF_Tensor** output_tensors,
                    std::size_t noutputs,
                    TF_Operation* const* operations = nullptr,
-                   std::size_t noperations = 0, TF_Status* status = nullptr);
+                   std::size_t noperations = 0, TF_Status* status = nullptr,
+                   const TF_Buffer* run_options = nullptr);
 
 TF_Code RunSession(TF_Session* session, const std::vector<TF_Output>& inputs,
                    const std::vector<TF_Tensor*>& input_tensors,
                    const std::vector<TF_Output>& outputs,
                    std::vector<TF_Tensor*>& output_tensors,
                    const std::vector<TF_Operation*>& operations = {},
-                   TF_Status* status = nullptr);
+                   TF_Status* status = nullptr,
+                   const TF_Buffer* run_options = nullptr);
 
 TF_Tensor* CreateTensor(TF_DataType data_type, const std::int64_t* dims,
                         std::size_t num_dims, const void* data,
@@ -93,6 +104,17 @@ TF_Tensor* CreateTensor(TF_DataType data_type,
                       data.size() * sizeof(T));
 }
 
+// create a TF_STRING tensor of shape dims holding strings.
+// the offset table and the encoded strings are written into one allocation.
+TF_Tensor* CreateStringTensor(const std::vector<std::string_view>& strings,
+                              const std::vector<std::int64_t>& dims,
+                              TF_Status* status = nullptr);
+
+// the strings of a TF_STRING tensor. the views point into the tensor and are
+// valid as long as the tensor lives.
+std::vector<std::string_view> GetStringTensorData(const TF_Tensor* tensor,
+                                                  TF_Status* status = nullptr);
+
 TF_Tensor* CreateEmptyTensor(TF_DataType data_type, const std::int64_t* dims,
                              std::size_t num_dims, std::size_t len = 0);
 
@@ -148,10 +170,23 @@ std::vector<std::vector<T>> GetTensorsData(
   return data;
 }
 
+// split a tensor name, "name:i" for output i of operation name or "name" for
+// output 0, into the operation name and the output index.
+std::pair<std::string, int> SplitTensorName(const std::string& tensor_name);
+
+// look up a graph tensor, "name" for output 0 of operation name or
+// "name:i" for output i, and its dtype and static shape. n_dims is -1 if
+// the rank is unknown.
 TF_Code GetTGraphOperation(TF_Graph* graph, const char* oper_name,
                            TF_Output* out, TF_DataType* type, int* n_dims,
                            int64_t* dims, TF_Status* status);
 
+// add a Placeholder op to graph, e.g. for feeding tensors without a graph.pb.
+TF_Operation* AddPlaceholder(TF_Graph* graph, const char* oper_name,
+                             TF_DataType type,
+                             const std::vector<std::int64_t>& dims,
+                             TF_Status* status = nullptr);
+
 std::vector<std::int64_t> GetTensorShape(TF_Graph* graph,
                                          const TF_Output& output);
 
@@ -165,8 +200,27 @@ TF_SessionOptions* CreateSessionOptions(
     std::uint8_t intra_op_parallelism_threads,
     std::uint8_t inter_op_parallelism_threads, TF_Status* status = nullptr);
 
+// session options with device_count CPU devices, /cpu:0 to
+// /cpu:<device_count - 1>, so parts of a graph can be pinned to separate
+// devices, and the sizes of the intra and inter op thread pools.
+// the CPU devices are logical, every one of them uses the same intra op
+// pool of the session, there are no per device pools.
+// 0 keeps the default of tensorflow. soft placement is on.
+// a gpu_memory_fraction above 0 sets the gpu options of
+// CreateSessionOptions, that fraction and allow_growth.
+TF_SessionOptions* CreateCpuSessionOptions(int device_count,
+                                           int intra_op_parallelism_threads,
+                                           int inter_op_parallelism_threads,
+                                           double gpu_memory_fraction = 0,
+                                           TF_Status* status = nullptr);
+
 void DeleteSessionOptions(TF_SessionOptions* options);
 
+// serialized RunOptions for RunSession, a run taking longer than
+// timeout_in_ms fails with TF_DEADLINE_EXCEEDED. 0 means no timeout.
+// free with TF_DeleteBuffer.
+TF_Buffer* CreateRunOptions(std::int64_t timeout_in_ms);
+
 std::string DataTypeToString(TF_DataType data_type);
 
 std::string CodeToString(TF_Code code);
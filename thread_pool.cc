@@ -0,0 +1,49 @@
+// A small fixed size thread pool for host side work.
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace tf_cpp {
+
+ThreadPool::ThreadPool(std::size_t num_threads) : stopping(false) {
+  workers.reserve(num_threads);
+  for (std::size_t i = 0; i != num_threads; ++i) {
+    workers.emplace_back([this]() { worker_loop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  cv.notify_all();
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+
+void ThreadPool::worker_loop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      // drain the queue before stopping, futures may still be waited on.
+      if (tasks.empty()) {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    task();
+  }
+}
+
+ThreadPool &ThreadPool::default_pool() {
+  static ThreadPool pool(
+      std::max(1u, std::thread::hardware_concurrency()) - 1);
+  return pool;
+}
+}  // namespace tf_cpp
@@ -0,0 +1,111 @@
+// A small fixed size thread pool for host side work.
+
+#ifndef TENSORFLOW_C_THREAD_POOL_H
+#define TENSORFLOW_C_THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace tf_cpp {
+
+// a fixed size pool of worker threads.
+// used for host side work around the session, e.g. decoding records or
+// copying batches. do not call parallel_for from inside a pool task.
+class ThreadPool {
+ public:
+  explicit ThreadPool(std::size_t num_threads);
+
+  ThreadPool(const ThreadPool &pool) = delete;
+  ThreadPool(ThreadPool &&pool) = delete;
+  ThreadPool &operator=(const ThreadPool &pool) = delete;
+  ThreadPool &operator=(ThreadPool &&pool) = delete;
+
+  ~ThreadPool();
+
+  std::size_t size() const { return workers.size(); }
+
+  template <typename F>
+  auto enqueue(F &&f) -> std::future<decltype(f())> {
+    using R = decltype(f());
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+    auto result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopping) {
+        throw std::runtime_error("enqueue on a stopped ThreadPool.");
+      }
+      tasks.emplace([task]() { (*task)(); });
+    }
+    cv.notify_one();
+    return result;
+  }
+
+  // run fn(begin, end) over chunks of [first, last).
+  // the calling thread runs the first chunk, the pool runs the others.
+  // chunks are never smaller than min_chunk, so small ranges run inline.
+  // the first exception thrown by any chunk is rethrown here after all
+  // chunks finished.
+  template <typename F>
+  void parallel_for(std::size_t first, std::size_t last, F &&fn,
+                    std::size_t min_chunk = 1) {
+    if (last <= first) {
+      return;
+    }
+    std::size_t n = last - first;
+    std::size_t max_chunks = (n + min_chunk - 1) / std::max<std::size_t>(min_chunk, 1);
+    std::size_t n_chunks = std::min(size() + 1, max_chunks);
+    if (n_chunks <= 1) {
+      fn(first, last);
+      return;
+    }
+    std::size_t chunk = (n + n_chunks - 1) / n_chunks;
+    std::vector<std::future<void>> pending;
+    pending.reserve(n_chunks - 1);
+    for (std::size_t b = first + chunk; b < last; b += chunk) {
+      std::size_t e = std::min(b + chunk, last);
+      pending.push_back(enqueue([&fn, b, e]() { fn(b, e); }));
+    }
+    std::exception_ptr error;
+    try {
+      fn(first, std::min(first + chunk, last));
+    } catch (...) {
+      error = std::current_exception();
+    }
+    for (auto &p : pending) {
+      try {
+        p.get();
+      } catch (...) {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  // process wide pool with one thread per core, minus the caller.
+  static ThreadPool &default_pool();
+
+ private:
+  void worker_loop();
+
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopping;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_THREAD_POOL_H
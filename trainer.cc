@@ -0,0 +1,90 @@
+// Hogwild style training: several threads run the train op of one session.
+
+#include "trainer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace tf_cpp {
+
+HogwildTrainer::HogwildTrainer(Model &model,
+                               const std::vector<TensorSpec> &inputs,
+                               const std::string &train_op,
+                               const TensorSpec &loss)
+    : model(model), inputs(inputs), loss(loss), train_op(nullptr) {
+  this->train_op = TF_GraphOperationByName(model.get_graph(), train_op.c_str());
+  if (this->train_op == nullptr) {
+    throw std::runtime_error("no train operation " + train_op + " in graph.");
+  }
+}
+
+TrainStats HogwildTrainer::train(const FeedFn &feed,
+                                 const HogwildOptions &options) {
+  std::size_t num_threads = options.num_threads;
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  TrainStats stats;
+  stats.steps.assign(num_threads, 0);
+  stats.seconds.assign(num_threads, 0);
+  stats.last_loss.assign(num_threads, 0);
+  std::vector<std::exception_ptr> errors(num_threads);
+
+  auto worker = [&](std::size_t w) {
+    try {
+      // every worker owns its tensors, only the session is shared.
+      std::vector<std::unique_ptr<Tensor>> owned;
+      std::vector<Tensor *> feeds;
+      for (auto &spec : inputs) {
+        owned.emplace_back(new Tensor(model.get_graph(), spec));
+        feeds.push_back(owned.back().get());
+      }
+      Tensor loss_tensor(model.get_graph(), loss);
+
+      auto start = std::chrono::steady_clock::now();
+      std::size_t step = 0;
+      for (; step != options.steps_per_thread; ++step) {
+        if (!feed(w, step, feeds)) {
+          break;
+        }
+        if (options.loss_every != 0 && (step + 1) % options.loss_every == 0) {
+          model.run(feeds, {&loss_tensor}, {train_op});
+          stats.last_loss[w] = loss_tensor.at<float>();
+        } else {
+          model.run(feeds, {}, {train_op});
+        }
+      }
+      stats.steps[w] = step;
+      stats.seconds[w] = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    } catch (...) {
+      errors[w] = std::current_exception();
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (std::size_t w = 0; w != num_threads; ++w) {
+    threads.emplace_back(worker, w);
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  stats.wall_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  for (auto &e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+  return stats;
+}
+}  // namespace tf_cpp
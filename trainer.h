@@ -0,0 +1,72 @@
+// Hogwild style training: several threads run the train op of one session.
+
+#ifndef TENSORFLOW_C_TRAINER_H
+#define TENSORFLOW_C_TRAINER_H
+
+#include <tensorflow/c/c_api.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "model.h"
+#include "tensor.h"
+
+namespace tf_cpp {
+
+struct HogwildOptions {
+  // number of worker threads, 0 means one per core.
+  std::size_t num_threads = 0;
+  // upper bound of steps per worker.
+  std::size_t steps_per_thread = 1000;
+  // fetch the loss every loss_every steps of a worker, 0 never fetches it.
+  // fetching a scalar forces the run to wait for it, so fetch it rarely.
+  std::size_t loss_every = 100;
+};
+
+struct TrainStats {
+  // per worker.
+  std::vector<std::size_t> steps;
+  std::vector<double> seconds;
+  std::vector<float> last_loss;
+  double wall_seconds = 0;
+
+  double steps_per_second(std::size_t worker) const {
+    return seconds[worker] > 0 ? steps[worker] / seconds[worker] : 0;
+  }
+  double steps_per_second() const {
+    std::size_t total = 0;
+    for (auto s : steps) total += s;
+    return wall_seconds > 0 ? total / wall_seconds : 0;
+  }
+};
+
+// runs the train op from many threads on one session and one set of
+// variables, without any locking around the updates (Hogwild!). this suits
+// sparse models, where concurrent updates rarely touch the same weights.
+// the optimizer in the graph must not use use_locking=True, otherwise the
+// workers serialize inside tensorflow.
+class HogwildTrainer {
+ public:
+  // fills the inputs of a worker for its next step, in the order of the
+  // input specs. returns false when the worker has no more data.
+  using FeedFn = std::function<bool(std::size_t worker, std::size_t step,
+                                    const std::vector<Tensor *> &inputs)>;
+
+  HogwildTrainer(Model &model, const std::vector<TensorSpec> &inputs,
+                 const std::string &train_op,
+                 const TensorSpec &loss = {"loss", TF_FLOAT, {}});
+
+  // feed is called concurrently from the workers.
+  TrainStats train(const FeedFn &feed,
+                   const HogwildOptions &options = HogwildOptions());
+
+ private:
+  Model &model;
+  std::vector<TensorSpec> inputs;
+  TensorSpec loss;
+  TF_Operation *train_op;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_TRAINER_H
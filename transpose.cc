@@ -0,0 +1,351 @@
+// Cache blocked axis permutation, e.g. NCHW <-> NHWC, for feeding tensors.
+
+#include "transpose.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "simd.h"
+#include "tensor.h"
+#include "thread_pool.h"
+
+#if defined(TF_CPP_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+namespace tf_cpp {
+
+namespace {
+
+// side of a cache block in elements, 64 x 64 x 8 bytes fit in L1 twice.
+constexpr int64_t kBlock = 64;
+constexpr std::size_t kMinParallelBytes = 1 << 20;
+
+// drop unit axes and merge axes that stay adjacent, so that e.g.
+// NCHW -> NHWC becomes {N, C, HW} -> {N, HW, C}.
+void Simplify(std::vector<int64_t> &shape, std::vector<int> &perm) {
+  std::vector<int> kept(shape.size(), -1);
+  std::vector<int64_t> s;
+  for (std::size_t i = 0; i != shape.size(); ++i) {
+    if (shape[i] != 1) {
+      kept[i] = static_cast<int>(s.size());
+      s.push_back(shape[i]);
+    }
+  }
+  std::vector<int> p;
+  for (auto axis : perm) {
+    if (kept[axis] >= 0) {
+      p.push_back(kept[axis]);
+    }
+  }
+  // runs of consecutive src axes in dst order, as (first src axis, size).
+  std::vector<std::pair<int, int64_t>> groups;
+  for (std::size_t k = 0; k != p.size(); ++k) {
+    if (k > 0 && p[k] == p[k - 1] + 1) {
+      groups.back().second *= s[p[k]];
+    } else {
+      groups.emplace_back(p[k], s[p[k]]);
+    }
+  }
+  std::vector<int> order(groups.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int x, int y) {
+    return groups[x].first < groups[y].first;
+  });
+  shape.resize(groups.size());
+  perm.resize(groups.size());
+  std::vector<int> src_axis(groups.size());
+  for (std::size_t r = 0; r != order.size(); ++r) {
+    src_axis[order[r]] = static_cast<int>(r);
+    shape[r] = groups[order[r]].second;
+  }
+  for (std::size_t g = 0; g != groups.size(); ++g) {
+    perm[g] = src_axis[g];
+  }
+}
+
+// dst[i + j * db] = src[i * sa + j] for i < ni, j < nj.
+template <typename T>
+void TransposeScalar(const T *src, int64_t sa, T *dst, int64_t db, int64_t ni,
+                     int64_t nj) {
+  if (ni < 8) {
+    // few long rows, e.g. the 3 channels of an image, read them in order.
+    for (int64_t i = 0; i != ni; ++i) {
+      for (int64_t j = 0; j != nj; ++j) {
+        dst[i + j * db] = src[i * sa + j];
+      }
+    }
+    return;
+  }
+  for (int64_t j = 0; j != nj; ++j) {
+    for (int64_t i = 0; i != ni; ++i) {
+      dst[i + j * db] = src[i * sa + j];
+    }
+  }
+}
+
+#if defined(TF_CPP_X86_SIMD)
+
+__attribute__((target("avx2"))) inline void Transpose8x8(const uint32_t *src,
+                                                        int64_t sa,
+                                                        uint32_t *dst,
+                                                        int64_t db) {
+  auto s = reinterpret_cast<const float *>(src);
+  auto d = reinterpret_cast<float *>(dst);
+  __m256 r0 = _mm256_loadu_ps(s + 0 * sa);
+  __m256 r1 = _mm256_loadu_ps(s + 1 * sa);
+  __m256 r2 = _mm256_loadu_ps(s + 2 * sa);
+  __m256 r3 = _mm256_loadu_ps(s + 3 * sa);
+  __m256 r4 = _mm256_loadu_ps(s + 4 * sa);
+  __m256 r5 = _mm256_loadu_ps(s + 5 * sa);
+  __m256 r6 = _mm256_loadu_ps(s + 6 * sa);
+  __m256 r7 = _mm256_loadu_ps(s + 7 * sa);
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+  __m256 u0 = _mm256_shuffle_ps(t0, t2, 0x44);
+  __m256 u1 = _mm256_shuffle_ps(t0, t2, 0xee);
+  __m256 u2 = _mm256_shuffle_ps(t1, t3, 0x44);
+  __m256 u3 = _mm256_shuffle_ps(t1, t3, 0xee);
+  __m256 u4 = _mm256_shuffle_ps(t4, t6, 0x44);
+  __m256 u5 = _mm256_shuffle_ps(t4, t6, 0xee);
+  __m256 u6 = _mm256_shuffle_ps(t5, t7, 0x44);
+  __m256 u7 = _mm256_shuffle_ps(t5, t7, 0xee);
+  _mm256_storeu_ps(d + 0 * db, _mm256_permute2f128_ps(u0, u4, 0x20));
+  _mm256_storeu_ps(d + 1 * db, _mm256_permute2f128_ps(u1, u5, 0x20));
+  _mm256_storeu_ps(d + 2 * db, _mm256_permute2f128_ps(u2, u6, 0x20));
+  _mm256_storeu_ps(d + 3 * db, _mm256_permute2f128_ps(u3, u7, 0x20));
+  _mm256_storeu_ps(d + 4 * db, _mm256_permute2f128_ps(u0, u4, 0x31));
+  _mm256_storeu_ps(d + 5 * db, _mm256_permute2f128_ps(u1, u5, 0x31));
+  _mm256_storeu_ps(d + 6 * db, _mm256_permute2f128_ps(u2, u6, 0x31));
+  _mm256_storeu_ps(d + 7 * db, _mm256_permute2f128_ps(u3, u7, 0x31));
+}
+
+__attribute__((target("avx2"))) inline void Transpose4x4(const uint64_t *src,
+                                                        int64_t sa,
+                                                        uint64_t *dst,
+                                                        int64_t db) {
+  auto s = reinterpret_cast<const double *>(src);
+  auto d = reinterpret_cast<double *>(dst);
+  __m256d r0 = _mm256_loadu_pd(s + 0 * sa);
+  __m256d r1 = _mm256_loadu_pd(s + 1 * sa);
+  __m256d r2 = _mm256_loadu_pd(s + 2 * sa);
+  __m256d r3 = _mm256_loadu_pd(s + 3 * sa);
+  __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+  _mm256_storeu_pd(d + 0 * db, _mm256_permute2f128_pd(t0, t2, 0x20));
+  _mm256_storeu_pd(d + 1 * db, _mm256_permute2f128_pd(t1, t3, 0x20));
+  _mm256_storeu_pd(d + 2 * db, _mm256_permute2f128_pd(t0, t2, 0x31));
+  _mm256_storeu_pd(d + 3 * db, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+// full W x W tiles with the kernel, the ragged edges with scalar code.
+template <int W, typename T,
+          void (*Kernel)(const T *, int64_t, T *, int64_t)>
+__attribute__((target("avx2"))) inline void TransposeTiled(
+    const T *src, int64_t sa, T *dst, int64_t db, int64_t ni, int64_t nj) {
+  int64_t mi = ni - ni % W;
+  int64_t mj = nj - nj % W;
+  for (int64_t i = 0; i != mi; i += W) {
+    for (int64_t j = 0; j != mj; j += W) {
+      Kernel(src + i * sa + j, sa, dst + i + j * db, db);
+    }
+  }
+  TransposeScalar(src + mi * sa, sa, dst + mi, db, ni - mi, nj);
+  TransposeScalar(src + mj, sa, dst + mj * db, db, mi, nj - mj);
+}
+
+#endif  // TF_CPP_X86_SIMD
+
+template <typename T>
+void TransposeBlock(const T *src, int64_t sa, T *dst, int64_t db, int64_t ni,
+                    int64_t nj) {
+  TransposeScalar(src, sa, dst, db, ni, nj);
+}
+
+void TransposeBlock(const uint32_t *src, int64_t sa, uint32_t *dst,
+                    int64_t db, int64_t ni, int64_t nj) {
+#if defined(TF_CPP_X86_SIMD)
+  if (simd_level() >= SimdLevel::kAvx2) {
+    return TransposeTiled<8, uint32_t, Transpose8x8>(src, sa, dst, db,
+                                                     ni, nj);
+  }
+#endif
+  TransposeScalar(src, sa, dst, db, ni, nj);
+}
+
+void TransposeBlock(const uint64_t *src, int64_t sa, uint64_t *dst,
+                    int64_t db, int64_t ni, int64_t nj) {
+#if defined(TF_CPP_X86_SIMD)
+  if (simd_level() >= SimdLevel::kAvx2) {
+    return TransposeTiled<4, uint64_t, Transpose4x4>(src, sa, dst, db,
+                                                     ni, nj);
+  }
+#endif
+  TransposeScalar(src, sa, dst, db, ni, nj);
+}
+
+template <typename F>
+void ParallelFor(std::size_t units, std::size_t bytes, F &&fn) {
+  if (bytes < kMinParallelBytes) {
+    fn(0, units);
+    return;
+  }
+  auto &pool = ThreadPool::default_pool();
+  std::size_t min_chunk = std::max<std::size_t>(
+      1, units * kMinParallelBytes / 4 / bytes);
+  pool.parallel_for(0, units, fn, min_chunk);
+}
+
+// shape and perm are simplified, rank >= 2.
+template <typename T>
+void Permute(const T *src, const std::vector<int64_t> &shape,
+             const std::vector<int> &perm, T *dst) {
+  int rank = static_cast<int>(shape.size());
+  std::vector<int64_t> src_stride(rank), dst_stride(rank);
+  int64_t stride = 1;
+  for (int k = rank - 1; k >= 0; --k) {
+    src_stride[k] = stride;
+    stride *= shape[k];
+  }
+  const std::size_t bytes = static_cast<std::size_t>(stride) * sizeof(T);
+  stride = 1;
+  for (int k = rank - 1; k >= 0; --k) {
+    dst_stride[perm[k]] = stride;
+    stride *= shape[perm[k]];
+  }
+
+  // a is the src axis that is innermost in dst, b the innermost src axis.
+  const int a = perm[rank - 1];
+  const int b = rank - 1;
+  std::vector<int> outer;
+  for (int k = 0; k != rank; ++k) {
+    if (k != a && k != b) {
+      outer.push_back(k);
+    }
+  }
+  int64_t outer_count = 1;
+  for (auto k : outer) {
+    outer_count *= shape[k];
+  }
+  auto offsets = [&](int64_t u, int64_t &so, int64_t &d) {
+    so = 0;
+    d = 0;
+    for (auto k = outer.rbegin(); k != outer.rend(); ++k) {
+      int64_t i = u % shape[*k];
+      u /= shape[*k];
+      so += i * src_stride[*k];
+      d += i * dst_stride[*k];
+    }
+  };
+
+  if (a == b) {
+    // the innermost axis is shared, copy contiguous runs.
+    const int64_t run = shape[b];
+    ParallelFor(outer_count, bytes, [&](std::size_t first, std::size_t last) {
+      for (std::size_t u = first; u != last; ++u) {
+        int64_t so, d;
+        offsets(u, so, d);
+        std::memcpy(dst + d, src + so, run * sizeof(T));
+      }
+    });
+    return;
+  }
+
+  const int64_t ni = shape[a];
+  const int64_t nj = shape[b];
+  const int64_t sa = src_stride[a];
+  const int64_t db = dst_stride[b];
+  // blocks of about kBlock * kBlock elements, wider when ni is small.
+  const int64_t bi = std::min(kBlock, ni);
+  const int64_t bj = kBlock * kBlock / bi;
+  const int64_t blocks_i = (ni + bi - 1) / bi;
+  const int64_t blocks_j = (nj + bj - 1) / bj;
+  const int64_t blocks = blocks_i * blocks_j;
+  ParallelFor(outer_count * blocks, bytes,
+              [&](std::size_t first, std::size_t last) {
+                for (std::size_t u = first; u != last; ++u) {
+                  int64_t so, d;
+                  offsets(u / blocks, so, d);
+                  int64_t i = (u % blocks) % blocks_i * bi;
+                  int64_t j = (u % blocks) / blocks_i * bj;
+                  TransposeBlock(src + so + i * sa + j, sa, dst + d + i + j * db,
+                                 db, std::min(bi, ni - i), std::min(bj, nj - j));
+                }
+              });
+}
+
+}  // namespace
+
+std::vector<int64_t> permuted_shape(const std::vector<int64_t> &shape,
+                                    const std::vector<int> &perm) {
+  if (perm.size() != shape.size() || shape.size() > MAX_DIMS) {
+    throw std::runtime_error("permutation of " + std::to_string(perm.size()) +
+                             " axes for shape " + to_string(shape) + ".");
+  }
+  std::vector<bool> seen(perm.size(), false);
+  std::vector<int64_t> permuted(perm.size());
+  for (std::size_t i = 0; i != perm.size(); ++i) {
+    if (perm[i] < 0 || perm[i] >= static_cast<int>(perm.size()) ||
+        seen[perm[i]]) {
+      throw std::runtime_error("not a permutation of the axes: " +
+                               to_string(perm) + ".");
+    }
+    seen[perm[i]] = true;
+    permuted[i] = shape[perm[i]];
+  }
+  return permuted;
+}
+
+void permute(const void *src, const std::vector<int64_t> &src_shape,
+             const std::vector<int> &perm, void *dst,
+             std::size_t element_size) {
+  permuted_shape(src_shape, perm);
+  std::size_t bytes = element_size;
+  for (auto s : src_shape) {
+    bytes *= s;
+  }
+  if (bytes == 0) {
+    return;
+  }
+  auto shape = src_shape;
+  auto p = perm;
+  if (element_size != 1 && element_size != 2 && element_size != 4 &&
+      element_size != 8) {
+    // other sizes as an extra innermost axis of bytes that stays in place.
+    shape.push_back(static_cast<int64_t>(element_size));
+    p.push_back(static_cast<int>(p.size()));
+    element_size = 1;
+  }
+  Simplify(shape, p);
+  if (shape.size() <= 1) {
+    std::memcpy(dst, src, bytes);
+    return;
+  }
+  switch (element_size) {
+    case 1:
+      return Permute(static_cast<const uint8_t *>(src), shape, p,
+                     static_cast<uint8_t *>(dst));
+    case 2:
+      return Permute(static_cast<const uint16_t *>(src), shape, p,
+                     static_cast<uint16_t *>(dst));
+    case 4:
+      return Permute(static_cast<const uint32_t *>(src), shape, p,
+                     static_cast<uint32_t *>(dst));
+    default:
+      return Permute(static_cast<const uint64_t *>(src), shape, p,
+                     static_cast<uint64_t *>(dst));
+  }
+}
+}  // namespace tf_cpp
@@ -0,0 +1,31 @@
+// Cache blocked axis permutation, e.g. NCHW <-> NHWC, for feeding tensors.
+
+#ifndef TENSORFLOW_C_TRANSPOSE_H
+#define TENSORFLOW_C_TRANSPOSE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tf_cpp {
+
+// axis orders for the common image layouts, see permute.
+inline const std::vector<int> kNchwToNhwc = {0, 2, 3, 1};
+inline const std::vector<int> kNhwcToNchw = {0, 3, 1, 2};
+
+// the shape of an array of shape shape permuted by perm.
+std::vector<int64_t> permuted_shape(const std::vector<int64_t> &shape,
+                                    const std::vector<int> &perm);
+
+// copy src, a dense row major array of shape src_shape, into dst with its
+// axes permuted: axis i of dst is axis perm[i] of src.
+// unit axes are dropped and axes that stay adjacent are merged first, so
+// e.g. NCHW -> NHWC runs as a batch of 2d transposes. those are done in
+// cache sized blocks with AVX2 tiles for 4 and 8 byte elements, and split
+// over ThreadPool::default_pool() for arrays of 1MB or more.
+// throws std::runtime_error if perm is not a permutation of the axes.
+void permute(const void *src, const std::vector<int64_t> &src_shape,
+             const std::vector<int> &perm, void *dst,
+             std::size_t element_size);
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_TRANSPOSE_H
@@ -0,0 +1,76 @@
+// A Model whose graph can be replaced by a new version while it serves.
+
+#include "versioned_model.h"
+
+#include <chrono>
+#include <thread>
+#include <utility>
+
+namespace tf_cpp {
+
+VersionedModel::Lease::Lease(Lease &&lease) noexcept
+    : readers(lease.readers), model(lease.model), number(lease.number) {
+  lease.readers = nullptr;
+}
+
+VersionedModel::Lease::~Lease() {
+  if (readers != nullptr) {
+    readers->fetch_sub(1);
+  }
+}
+
+VersionedModel::VersionedModel(const std::string &filename,
+                               const ModelOptions &options, WarmUp warm_up)
+    : options(options), warm_up(std::move(warm_up)) {
+  std::unique_ptr<Version> first(new Version(filename, options, 1));
+  if (this->warm_up) {
+    this->warm_up(first->model);
+  }
+  current = first.release();
+  loader.reset(new ThreadPool(1));
+}
+
+VersionedModel::~VersionedModel() {
+  loader.reset();
+  delete current.load();
+}
+
+VersionedModel::Lease VersionedModel::acquire() const {
+  while (true) {
+    auto e = epoch.load();
+    auto &count = readers[e & 1].count;
+    count.fetch_add(1);
+    // a swap that bumped epoch in between may not wait for this reader.
+    if (epoch.load() == e) {
+      auto version = current.load();
+      return Lease(&count, &version->model, version->number);
+    }
+    count.fetch_sub(1);
+  }
+}
+
+std::future<std::uint64_t> VersionedModel::swap(const std::string &filename) {
+  return loader->enqueue([this, filename]() { return replace(filename); });
+}
+
+std::uint64_t VersionedModel::version() const { return current_number.load(); }
+
+std::uint64_t VersionedModel::replace(const std::string &filename) {
+  auto number = current_number.load() + 1;
+  std::unique_ptr<Version> next(new Version(filename, options, number));
+  if (warm_up) {
+    warm_up(next->model);
+  }
+  std::unique_ptr<Version> old(current.exchange(next.release()));
+  current_number = number;
+
+  // readers acquiring from now on register under the new epoch and see the
+  // new version. the old version is destroyed once the readers of the old
+  // epoch are gone.
+  auto e = epoch.fetch_add(1);
+  while (readers[e & 1].count.load() != 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return number;
+}
+}  // namespace tf_cpp
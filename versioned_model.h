@@ -0,0 +1,110 @@
+// A Model whose graph can be replaced by a new version while it serves.
+
+#ifndef TENSORFLOW_C_VERSIONED_MODEL_H
+#define TENSORFLOW_C_VERSIONED_MODEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "model.h"
+#include "thread_pool.h"
+
+namespace tf_cpp {
+
+// serves the current version of a model and swaps in new versions RCU
+// style. a new version is loaded and warmed up on a background thread, then
+// the current pointer flips atomically, and the old version is destroyed
+// once the last run that acquired it has finished. acquire never takes a
+// lock, it costs two atomic increments.
+// Tensors are bound to the graph of one version, so build them from the
+// Model of the lease, e.g. with TensorSpecs.
+// thread safe.
+class VersionedModel {
+ public:
+  // runs a new version before it becomes current, e.g. a few requests, so
+  // the first requests on it do not pay for lazy initialization.
+  using WarmUp = std::function<void(Model &)>;
+
+  // a version held by a reader. it stays alive at least as long as the
+  // lease, so keep leases short, a swap waits for them.
+  class Lease {
+   public:
+    Lease(Lease &&lease) noexcept;
+    Lease(const Lease &lease) = delete;
+    Lease &operator=(const Lease &lease) = delete;
+    Lease &operator=(Lease &&lease) = delete;
+    ~Lease();
+
+    Model &operator*() const { return *model; }
+    Model *operator->() const { return model; }
+    // 1 for the model the VersionedModel was built with, then 2, 3, ...
+    std::uint64_t version() const { return number; }
+
+   private:
+    friend class VersionedModel;
+    Lease(std::atomic<std::int64_t> *readers, Model *model,
+          std::uint64_t number)
+        : readers(readers), model(model), number(number) {}
+
+    std::atomic<std::int64_t> *readers;
+    Model *model;
+    std::uint64_t number;
+  };
+
+  // loads version 1 on this thread, warm_up included.
+  explicit VersionedModel(const std::string &filename,
+                          const ModelOptions &options = {},
+                          WarmUp warm_up = {});
+
+  VersionedModel(const VersionedModel &model) = delete;
+  VersionedModel &operator=(const VersionedModel &model) = delete;
+
+  // waits for pending swaps, the leases must be released before.
+  ~VersionedModel();
+
+  // the current version.
+  Lease acquire() const;
+
+  // load filename in the background, warm it up and make it the current
+  // version. the future holds the new version number once the old version
+  // is destroyed, or the error that kept the model from loading, in which
+  // case the current version keeps serving. swaps run one at a time.
+  std::future<std::uint64_t> swap(const std::string &filename);
+
+  std::uint64_t version() const;
+
+ private:
+  struct Version {
+    Version(const std::string &filename, const ModelOptions &options,
+            std::uint64_t number)
+        : model(filename, options), number(number) {}
+
+    Model model;
+    std::uint64_t number;
+  };
+
+  // readers of the two grace periods, on their own cache lines.
+  struct alignas(64) Readers {
+    std::atomic<std::int64_t> count{0};
+  };
+
+  std::uint64_t replace(const std::string &filename);
+
+  ModelOptions options;
+  WarmUp warm_up;
+  std::atomic<Version *> current;
+  // readers register in readers[epoch & 1], a swap bumps epoch and waits
+  // for the readers of the previous one.
+  mutable std::atomic<std::uint64_t> epoch{0};
+  mutable Readers readers[2];
+  // the number of current, readable without a lease.
+  std::atomic<std::uint64_t> current_number{1};
+  // one thread, so swaps never overlap.
+  std::unique_ptr<ThreadPool> loader;
+};
+}  // namespace tf_cpp
+#endif  // TENSORFLOW_C_VERSIONED_MODEL_H